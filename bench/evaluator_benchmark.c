@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "lex.h"
+#include "parser.h"
+#include "operations.h"
+#include "expression.h"
+#include "pratt.h"
+#include "timer.h"
+
+
+// Benchmark of each phase of the evaluator over the corpus in bench/corpus (or the files given): every expression of
+// a file is lexed, parsed and evaluated, then evaluated again compiled, once by the graph interpreter and once as a
+// compiled expression (bytecode), and last compiled from the source by the single-pass PRATT front end and evaluated
+// (to compare with lex + parse + evaluate), with each phase timed on its own. The corpus is made of constant
+// expressions, which constant folding would reduce to a single number before the graph and compiled phases: those two
+// phases evaluate each expression with its numbers (and `pi` and `e`) replaced by variables bound to their values, so
+// they compute the whole expression like the evaluate phase does. After `warmup` untimed passes over the
+// file, `repetitions` timed passes are made, and the median (p50) and 99th percentile (p99) time of one expression and
+// the throughput of each phase are printed. The times of single expressions include one reading of the clock (a few
+// dozen nanoseconds).
+//
+// Usage: evaluator_benchmark [--warmup passes] [--repetitions passes] [corpus files...]
+
+
+#ifndef CORPUS_DIRECTORY
+#define CORPUS_DIRECTORY "bench/corpus"  // Set by CMake to the absolute path
+#endif
+
+#define PHASE_COUNT 6
+
+static const char* PHASE_NAMES[PHASE_COUNT] = {"lex", "parse", "evaluate", "graph", "compiled", "pratt"};
+static const char* DEFAULT_CORPUS[] = {
+    CORPUS_DIRECTORY "/short.txt", CORPUS_DIRECTORY "/nested.txt",
+    CORPUS_DIRECTORY "/polynomial.txt", CORPUS_DIRECTORY "/functions.txt"
+};
+static const int DEFAULT_WARMUP = 3;
+static const int DEFAULT_REPETITIONS = 20;
+
+#define MAX_NAME_LENGTH 8  // A variable name (`v` and up to 7 digits) is at most 8 times as long as what it replaces
+
+
+// Structure for the expressions of one corpus file: the text of the file with each line null-terminated, the start
+// of each line, and the number of lines and of bytes. `boundLines` are the lines with their numbers replaced by
+// variables (in `boundText`), whose values are at `lineVariables[line]` (in `variableValues`), see bind_corpus.
+typedef struct Corpus {
+    char* text;
+    char** lines;
+    char* boundText;
+    char** boundLines;
+    double* variableValues;
+    double** lineVariables;
+    int lineCount;
+    size_t byteCount;
+} Corpus;
+
+
+// Reads the non-empty lines of the file `fileName` into `corpus`. Returns 0 upon success, 1 upon errors (a message is
+// printed). Errors are fatal.
+static int load_corpus(const char* fileName, Corpus* corpus) {
+
+    FILE* file = fopen(fileName, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "\nError: could not open '%s'.\n\n", fileName);
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    corpus->boundText = NULL;
+    corpus->boundLines = NULL;
+    corpus->variableValues = NULL;
+    corpus->lineVariables = NULL;
+    corpus->text = malloc(size + 1);
+    corpus->lines = malloc((size / 2 + 1) * sizeof(char*));
+    if (corpus->text == NULL || corpus->lines == NULL || fread(corpus->text, 1, size, file) != (size_t)size) {
+        fprintf(stderr, "\nError: could not read '%s'.\n\n", fileName);
+        fclose(file);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    fclose(file);
+    corpus->text[size] = '\0';
+
+    // Split the text into lines, dropping line endings and empty lines
+    corpus->lineCount = 0;
+    corpus->byteCount = 0;
+    char* line = corpus->text;
+    while (*line != '\0') {
+        char* end = line + strcspn(line, "\r\n");
+        int terminated = *end != '\0';
+        *end = '\0';
+        if (end > line) {
+            corpus->lines[corpus->lineCount++] = line;
+            corpus->byteCount += end - line;
+        }
+        line = terminated ? end + 1 : end;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// Lexes `sourceString` into `tokenList` and writes it into `boundString` with each number (and `pi` and `e`) replaced
+// by a variable (`v0`, `v1`, ..., one per distinct value, in order of first appearance), whose value is written into
+// `variableValues[slot]`. `boundString` needs room for MAX_NAME_LENGTH characters per character of `sourceString`,
+// and `variableValues` for one value per character. Returns the number of variables, -1 if the string cannot be lexed.
+static int bind_numbers(char* sourceString, TokenList* tokenList, char* boundString, double* variableValues) {
+
+    if (lexical_analyzer(sourceString, tokenList) != 0) {
+        return -1;
+    }
+
+    int variableCount = 0;
+    int copied = 0;
+    char* writer = boundString;
+    for (int i = 0; i <= tokenList->position; i++) {
+        Token* token = &tokenList->array[i];
+        double value;
+        switch (token->typeToken) {
+            case TOKEN_NUMBER: value = tokenList->numberValues[token->slot]; break;
+            case TOKEN_KEYWORD_PI: value = CONSTANT_PI; break;
+            case TOKEN_KEYWORD_E: value = CONSTANT_E; break;
+            default: continue;
+        }
+        int variable = 0;
+        while (variable < variableCount && memcmp(&variableValues[variable], &value, sizeof(double)) != 0) {
+            variable++;
+        }
+        if (variable == variableCount) {
+            variableValues[variableCount++] = value;
+        }
+        memcpy(writer, sourceString + copied, token->offset - copied);
+        writer += token->offset - copied;
+        writer += sprintf(writer, "v%d", variable);
+        copied = token->offset + token->length;
+    }
+    strcpy(writer, sourceString + copied);
+
+    return variableCount;
+}
+
+
+// Fills the bound lines of `corpus`, read from the file `fileName` (see Corpus), with bind_numbers, lexing with
+// `tokenList`. Returns 0 upon success, 1 upon errors (a message is printed). Errors are fatal.
+static int bind_corpus(const char* fileName, Corpus* corpus, TokenList* tokenList) {
+
+    corpus->boundText = malloc(corpus->byteCount * MAX_NAME_LENGTH + corpus->lineCount + 1);
+    corpus->boundLines = malloc((corpus->lineCount + 1) * sizeof(char*));
+    corpus->variableValues = malloc((corpus->byteCount + 1) * sizeof(double));
+    corpus->lineVariables = malloc((corpus->lineCount + 1) * sizeof(double*));
+    if (corpus->boundText == NULL || corpus->boundLines == NULL || corpus->variableValues == NULL ||
+        corpus->lineVariables == NULL) {
+        fprintf(stderr, "Fatal error: memory could not be allocated.\n\n");
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    char* boundLine = corpus->boundText;
+    double* variableValues = corpus->variableValues;
+    for (int i = 0; i < corpus->lineCount; i++) {
+        int variableCount = bind_numbers(corpus->lines[i], tokenList, boundLine, variableValues);
+        if (variableCount < 0) {
+            fprintf(stderr, "Error on line %d of '%s'.\n\n", i + 1, fileName);
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        corpus->boundLines[i] = boundLine;
+        corpus->lineVariables[i] = variableValues;
+        boundLine += strlen(boundLine) + 1;
+        variableValues += variableCount;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// Comparison function for qsort, sorts times in increasing order.
+static int compare_times(const void* a, const void* b) {
+    unsigned long long timeA = *(const unsigned long long*)a;
+    unsigned long long timeB = *(const unsigned long long*)b;
+    return (timeA > timeB) - (timeA < timeB);
+}
+
+
+// Runs one pass over `corpus`, `compiledExpressions` being its bound lines compiled. When `samples` is not NULL, the
+// time of each phase of each expression is written into `samples[phase][sampleIndex + line]`. Returns the number of
+// expressions that could not be evaluated.
+static int run_pass(Corpus* corpus, CompiledExpression* compiledExpressions, TokenList* tokenList,
+                    StackTokenList* postfixTokenList, DoubleStack* doubleStack, double* nodeValues,
+                    unsigned long long** samples, size_t sampleIndex) {
+
+    int failed = 0;
+    for (int i = 0; i < corpus->lineCount; i++) {
+        unsigned long long times[PHASE_COUNT + 1];
+        double result;
+
+        times[0] = get_timer_nanoseconds();
+        int status = lexical_analyzer(corpus->lines[i], tokenList);
+        times[1] = get_timer_nanoseconds();
+        status = status != 0 ? status : shunting_yard_algorithm(tokenList, postfixTokenList);
+        times[2] = get_timer_nanoseconds();
+        status = status != 0 ? status : evaluate_postfixTokenList(tokenList, postfixTokenList, NULL, doubleStack,
+                                                                  &result);
+        times[3] = get_timer_nanoseconds();
+        status = status != 0 ? status : evaluate_expressionGraph(&compiledExpressions[i].graph,
+                                                                 corpus->lineVariables[i], nodeValues, &result);
+        times[4] = get_timer_nanoseconds();
+        status = status != 0 ? status : evaluate_compiledExpression_context(&compiledExpressions[i],
+                                                                            corpus->lineVariables[i], doubleStack,
+                                                                            &result);
+        times[5] = get_timer_nanoseconds();
+        PrattExpression prattExpression;
+        if (status == 0 && (status = compile_prattExpression(corpus->lines[i], &prattExpression)) == 0) {
+            status = evaluate_prattExpression(&prattExpression, NULL, &result);
+            free_prattExpression_memory(&prattExpression);
+        }
+        times[6] = get_timer_nanoseconds();
+
+        if (status != 0) {
+            failed++;
+        }
+        if (samples != NULL) {
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                samples[phase][sampleIndex + i] = times[phase + 1] - times[phase];
+            }
+        }
+    }
+
+    return failed;
+}
+
+
+// Benchmarks every phase over the corpus in the file `fileName` and prints one line per phase.
+// Returns 0 upon success, 1 upon errors (a message is printed). Errors are fatal.
+static int benchmark_corpus(const char* fileName, int warmup, int repetitions) {
+
+    Corpus corpus;
+    if (load_corpus(fileName, &corpus) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // Buffers reused for every expression, compiled expressions, and room for every sample of every phase
+    TokenList tokenList;
+    StackTokenList postfixTokenList;
+    DoubleStack doubleStack;
+    CompiledExpression* compiledExpressions = malloc((corpus.lineCount + 1) * sizeof(CompiledExpression));
+    size_t sampleCount = (size_t)corpus.lineCount * repetitions;
+    unsigned long long* samples[PHASE_COUNT];
+    int status = 0;
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        samples[phase] = malloc((sampleCount + 1) * sizeof(unsigned long long));
+        if (samples[phase] == NULL) {
+            status = ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+    }
+    if (compiledExpressions == NULL || status != 0 ||
+        init_tokenList(&tokenList, 256) != 0 ||
+        init_StackTokenList(&tokenList, &postfixTokenList) != 0 ||
+        init_doubleStack(&doubleStack, 256) != 0) {
+        fprintf(stderr, "Fatal error: memory could not be allocated.\n\n");
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    if (bind_corpus(fileName, &corpus, &tokenList) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    int compiledCount = 0;
+    int maxNodeCount = 1;
+    for (; compiledCount < corpus.lineCount; compiledCount++) {
+        if (compile_expression(corpus.boundLines[compiledCount], &compiledExpressions[compiledCount]) != 0) {
+            fprintf(stderr, "Error on line %d of '%s'.\n\n", compiledCount + 1, fileName);
+            status = ERROR_FATAL_FUNCTION_CALL;
+            break;
+        }
+        if (compiledExpressions[compiledCount].graph.nodeCount > maxNodeCount) {
+            maxNodeCount = compiledExpressions[compiledCount].graph.nodeCount;
+        }
+    }
+    double* nodeValues = malloc(maxNodeCount * sizeof(double));
+    if (nodeValues == NULL) {
+        fprintf(stderr, "Fatal error: memory could not be allocated.\n\n");
+        status = ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    // Untimed passes first, so caches and branch predictors are warm
+    int failed = 0;
+    for (int pass = 0; status == 0 && pass < warmup + repetitions; pass++) {
+        int timed = pass >= warmup;
+        failed = run_pass(&corpus, compiledExpressions, &tokenList, &postfixTokenList, &doubleStack, nodeValues,
+                          timed ? samples : NULL, timed ? (size_t)(pass - warmup) * corpus.lineCount : 0);
+    }
+
+    // Percentiles of the time of one expression, and the throughput over the total time of each phase
+    const char* baseName = strrchr(fileName, '/') != NULL ? strrchr(fileName, '/') + 1 : fileName;
+    for (int phase = 0; status == 0 && phase < PHASE_COUNT; phase++) {
+        unsigned long long total = 0;
+        for (size_t i = 0; i < sampleCount; i++) {
+            total += samples[phase][i];
+        }
+        qsort(samples[phase], sampleCount, sizeof(unsigned long long), compare_times);
+        double seconds = total > 0 ? total * 1e-9 : 1e-9;
+
+        printf("%-16s %6d %6d  %-9s %11llu %11llu %13.0f %9.1f\n", baseName, corpus.lineCount, failed,
+               PHASE_NAMES[phase], samples[phase][sampleCount / 2], samples[phase][sampleCount * 99 / 100],
+               sampleCount / seconds, corpus.byteCount * (double)repetitions / seconds / 1e6);
+    }
+
+    // Free all memory
+    for (int i = 0; i < compiledCount; i++) {
+        free_compiledExpression_memory(&compiledExpressions[i]);
+    }
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        free(samples[phase]);
+    }
+    free(compiledExpressions);
+    free(nodeValues);
+    free_tokenList_memory(&tokenList);
+    free_stackTokenList_memory(&postfixTokenList);
+    free_doubleStack_memory(&doubleStack);
+    free(corpus.lines);
+    free(corpus.text);
+    free(corpus.boundLines);
+    free(corpus.boundText);
+    free(corpus.lineVariables);
+    free(corpus.variableValues);
+
+    return status;
+}
+
+
+int main(int argc, char *argv[]) {
+
+    int warmup = DEFAULT_WARMUP;
+    int repetitions = DEFAULT_REPETITIONS;
+    int firstFile = 1;
+    while (firstFile + 1 < argc && strncmp(argv[firstFile], "--", 2) == 0) {
+        if (strcmp(argv[firstFile], "--warmup") == 0) {
+            warmup = atoi(argv[firstFile + 1]);
+        }
+        else if (strcmp(argv[firstFile], "--repetitions") == 0) {
+            repetitions = atoi(argv[firstFile + 1]);
+        }
+        else {
+            break;
+        }
+        firstFile += 2;
+    }
+    if (warmup < 0 || repetitions < 1 || (firstFile < argc && strncmp(argv[firstFile], "--", 2) == 0)) {
+        fprintf(stderr, "\nError: Incorrect usage. Correct usage: evaluator_benchmark [--warmup passes] "
+                        "[--repetitions passes] [corpus files...].\n\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    printf("%d warmup passes, %d timed passes, times in nanoseconds per expression\n\n", warmup, repetitions);
+    printf("%-16s %6s %6s  %-9s %11s %11s %13s %9s\n", "corpus", "lines", "failed", "phase", "p50", "p99",
+           "expressions/s", "MB/s");
+
+    int fileCount = firstFile < argc ? argc - firstFile : (int)(sizeof(DEFAULT_CORPUS) / sizeof(DEFAULT_CORPUS[0]));
+    for (int i = 0; i < fileCount; i++) {
+        const char* fileName = firstFile < argc ? argv[firstFile + i] : DEFAULT_CORPUS[i];
+        if (benchmark_corpus(fileName, warmup, repetitions) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+    }
+
+    return 0;
+}
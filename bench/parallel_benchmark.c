@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "errors.h"
+#include "expression.h"
+#include "thread_pool.h"
+#include "batch.h"
+#include "timer.h"
+
+
+// Benchmark of evaluate_compiledExpression_parallel: evaluates one expression over columns of random values with
+// 1, 2, 4, ... threads (up to the number of processors, or the number given) and prints the time per row and the
+// speedup over one thread. The results of every run are compared with those of the single-threaded batch evaluation.
+//
+// Usage: parallel_benchmark [rows] [max threads] [expression]
+
+
+static const char* DEFAULT_EXPRESSION = "sin(x) * exp(0 - y*y / 2) + ln(1 + x*x) / (1 + cos(y))";
+static const size_t DEFAULT_ROWS = 20000000;
+static const int REPETITIONS = 3;  // Each thread count is timed this many times, the best time is kept
+
+
+// Returns 1 if `a` and `b` are the same result (both NaN, or equal bit for bit), 0 otherwise.
+static int same_result(double a, double b) {
+    return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+
+int main(int argc, char *argv[]) {
+
+    size_t rowCount = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_ROWS;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : 0;
+    char* expressionString = argc > 3 ? argv[3] : (char*)DEFAULT_EXPRESSION;
+    if (rowCount == 0) {
+        fprintf(stderr, "\nError: Incorrect usage. Correct usage: parallel_benchmark [rows] [max threads] "
+                        "[expression].\n\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    CompiledExpression compiledExpression;
+    if (compile_expression(expressionString, &compiledExpression) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // One column of random values in [-2, 2] per variable, and the reference results
+    int variableCount = compiledExpression.variableCount;
+    double** columns = calloc(variableCount > 0 ? variableCount : 1, sizeof(double*));
+    double* expected = malloc(rowCount * sizeof(double));
+    double* results = malloc(rowCount * sizeof(double));
+    if (columns == NULL || expected == NULL || results == NULL) {
+        fprintf(stderr, "\nError: could not allocate %zu rows.\n\n", rowCount);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    srand(1);
+    for (int slot = 0; slot < variableCount; slot++) {
+        columns[slot] = malloc(rowCount * sizeof(double));
+        if (columns[slot] == NULL) {
+            fprintf(stderr, "\nError: could not allocate %zu rows.\n\n", rowCount);
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+        for (size_t row = 0; row < rowCount; row++) {
+            columns[slot][row] = 4.0 * rand() / RAND_MAX - 2.0;
+        }
+    }
+    size_t expectedFailed;
+    if (evaluate_compiledExpression_batch(&compiledExpression, (const double* const*)columns, expected, rowCount,
+                                          &expectedFailed) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // The thread count defaults to the number of processors
+    if (maxThreads <= 0) {
+        ThreadPool threadPool;
+        if (init_threadPool(&threadPool, 0) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        maxThreads = threadPool.workerCount;
+        free_threadPool_memory(&threadPool);
+    }
+
+    printf("%s\n%zu rows, %d variables\n\n", expressionString, rowCount, variableCount);
+    printf("threads   ns/row   speedup\n");
+
+    double singleThread = 0;
+    for (int threads = 1; ; threads = threads * 2 < maxThreads ? threads * 2 : maxThreads) {
+        ThreadPool threadPool;
+        if (init_threadPool(&threadPool, threads) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+
+        double best = INFINITY;
+        for (int repetition = 0; repetition < REPETITIONS; repetition++) {
+            size_t failed;
+            unsigned long long start = get_timer_nanoseconds();
+            if (evaluate_compiledExpression_parallel(&threadPool, &compiledExpression, (const double* const*)columns,
+                                                     results, rowCount, &failed) != 0) {
+                return ERROR_FATAL_FUNCTION_CALL;
+            }
+            double elapsed = (get_timer_nanoseconds() - start) * 1e-9;
+            best = elapsed < best ? elapsed : best;
+
+            if (failed != expectedFailed) {
+                fprintf(stderr, "\nError: %zu failed rows with %d threads, %zu expected.\n\n", failed, threads,
+                        expectedFailed);
+                return ERROR_FATAL_FUNCTION_CALL;
+            }
+            for (size_t row = 0; row < rowCount; row++) {
+                if (!same_result(results[row], expected[row])) {
+                    fprintf(stderr, "\nError: row %zu is %.17g with %d threads, %.17g expected.\n\n", row,
+                            results[row], threads, expected[row]);
+                    return ERROR_FATAL_FUNCTION_CALL;
+                }
+            }
+        }
+        free_threadPool_memory(&threadPool);
+
+        if (threads == 1) {
+            singleThread = best;
+        }
+        printf("%7d %8.3f %9.2f\n", threads, best * 1e9 / rowCount, singleThread / best);
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+
+    // Free all memory
+    for (int slot = 0; slot < variableCount; slot++) {
+        free(columns[slot]);
+    }
+    free(columns);
+    free(expected);
+    free(results);
+    free_compiledExpression_memory(&compiledExpression);
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+
+#include "graph.h"
+#include "expression.h"
+#include "thread_pool.h"
+
+
+// BATCH module evaluates one expression over many rows of input at once: every variable is bound to a column (an
+// array with one value per row) and one result is written per row. Rows are processed in blocks of BATCH_BLOCK_ROWS,
+// and each operation of the expression runs over a whole block before the next one starts, as a SIMD loop using
+// the widest instructions the CPU supports (AVX-512, AVX2 or SSE2, detected at runtime).
+
+// Large inputs can be split across the workers of a THREAD POOL: chunks of BATCH_PARALLEL_CHUNK_ROWS rows are
+// evaluated by the workers with one scratch space each, straight into the caller's array of results.
+
+// A row whose evaluation hits a domain error gets NaN as its result and is counted, no message is printed (the
+// expression can be evaluated for that row with evaluate_compiledExpression to find out why).
+
+
+#define BATCH_BLOCK_ROWS 256  // Rows evaluated together, each operation runs over this many values at once
+#define BATCH_PARALLEL_CHUNK_ROWS (64 * BATCH_BLOCK_ROWS)  // Rows per chunk handed to a worker of a thread pool
+
+
+// Structure for one instruction of a batch program. `typeToken` and `typeFunction` are the operation (as in a
+// GraphNode), `destination` the buffer it writes, `operands` the buffers it reads (for TOKEN_VARIABLE `operands[0]`
+// is the variable slot). Fused sin/cos instructions write the sine into `destination` and the cosine into
+// `secondDestination` (-1 for every other instruction). `value` is the constant of TOKEN_NUMBER instructions.
+typedef struct BatchInstruction {
+    double value;
+    int destination;
+    int secondDestination;
+    int operands[2];
+    unsigned char typeToken;
+    unsigned char typeFunction;
+} BatchInstruction;
+
+
+// Structure for a batch program: the instructions in evaluation order, the number of block buffers they use (buffers
+// are reused once the value they hold is no longer needed), and the buffer holding the value of the expression.
+// Functions are computed by the VECTOR MATH module when `useVectorMath` is set (the default), and one value at a time
+// by the C library otherwise (results bit-identical to evaluate_compiledExpression, several times slower).
+typedef struct BatchProgram {
+    BatchInstruction* instructions;
+    int instructionCount;
+    int bufferCount;
+    int resultBuffer;
+    int useVectorMath;
+} BatchProgram;
+
+
+// Translates `expressionGraph` into a batch program. Returns 0 upon success, 1 upon errors. Errors are fatal.
+int build_batchProgram(ExpressionGraph* expressionGraph, BatchProgram* batchProgram);
+
+
+// Returns the size in bytes of the scratch space evaluate_batchProgram needs for `batchProgram`.
+size_t get_batchProgram_scratchSize(BatchProgram* batchProgram);
+
+
+/**
+ * @brief Evaluates `batchProgram` over `rowCount` rows.
+ *
+ * @param batchProgram A pointer to the BatchProgram to evaluate.
+ * @param columns One array of `rowCount` values per variable slot (`columns[slot][row]`). May be NULL if the
+ *        expression has no variables.
+ * @param results The array of `rowCount` doubles the results are written into.
+ * @param rowCount The number of rows.
+ * @param scratch Scratch space of get_batchProgram_scratchSize bytes, aligned to 64 bytes. Each thread evaluating
+ *        at the same time needs its own.
+ * @param failedRows A pointer to the count of rows with domain errors (results are NaN), or NULL.
+ * @return int Returns 0 on success (even if some rows failed), or 1 on invalid parameters. Errors are fatal.
+ */
+int evaluate_batchProgram(BatchProgram* batchProgram, const double* const* columns, double* results, size_t rowCount,
+                          void* scratch, size_t* failedRows);
+
+
+// Evaluates `batchProgram` over `rowCount` rows like evaluate_batchProgram, on the workers of `threadPool`.
+// `scratch` holds one scratch space (see evaluate_batchProgram) per worker of the pool. The rows are split into chunks
+// of BATCH_PARALLEL_CHUNK_ROWS rows, results are the same as with evaluate_batchProgram.
+// Returns 0 on success (even if some rows failed), or 1 on invalid parameters. Errors are fatal.
+int evaluate_batchProgram_parallel(ThreadPool* threadPool, BatchProgram* batchProgram, const double* const* columns,
+                                   double* results, size_t rowCount, void** scratch, size_t* failedRows);
+
+
+// Frees the memory allocated for the instructions of `batchProgram`. Returns 0 upon success, 1 upon errors.
+int free_batchProgram_memory(BatchProgram* batchProgram);
+
+
+// Allocates `size` bytes of scratch space aligned to 64 bytes (e.g. for evaluate_batchProgram). Returns NULL upon
+// failure. Must be freed with free_batchScratch_memory.
+void* allocate_batchScratch(size_t size);
+
+
+// Frees scratch space returned by allocate_batchScratch.
+void free_batchScratch_memory(void* scratch);
+
+
+// Evaluates `compiledExpression` over `rowCount` rows of `columns` (one per variable slot) into `results`, and writes
+// the number of rows with domain errors into `failedRows` (if not NULL). Builds the batch program and its scratch space
+// for this call only. Returns 0 upon success, 1 upon errors (invalid parameters, memory). Errors are fatal.
+int evaluate_compiledExpression_batch(CompiledExpression* compiledExpression, const double* const* columns,
+                                      double* results, size_t rowCount, size_t* failedRows);
+
+
+// Same as evaluate_compiledExpression_batch, with the rows split across the workers of `threadPool`. Builds the batch
+// program and the scratch space of each worker for this call only. Returns 0 upon success, 1 upon errors (invalid
+// parameters, memory). Errors are fatal.
+int evaluate_compiledExpression_parallel(ThreadPool* threadPool, CompiledExpression* compiledExpression,
+                                         const double* const* columns, double* results, size_t rowCount,
+                                         size_t* failedRows);
+
+
+#endif // BATCH_H
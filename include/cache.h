@@ -0,0 +1,106 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "expression.h"
+
+
+// CACHE module keeps the most recently used compiled expressions, keyed by their source string, so services that see
+// the same expression strings over and over only lex and parse each of them once. The cache is bounded (CLOCK
+// replacement) and safe to use from many threads: lookups only take a shared read lock, and the lock is only taken
+// exclusively to insert a newly compiled expression.
+
+// Keys are normalized by removing the spaces that cannot change how the string is lexed (e.g. `x * 2` and `x*2` share
+// one entry). Spaces that matter (`2E +2`, `sin (x)`) are kept, so a key never maps to an expression that compiles
+// differently from the original string.
+
+
+// Structure for one cached compiled expression. `compiledExpression` is what callers use; the other fields belong to
+// the cache. `referenceCount` counts the callers holding the entry (it is never evicted while held), `referenced` is
+// the CLOCK bit set by every lookup, and `cached` is 0 for entries handed out without being stored in the cache.
+typedef struct CachedExpression {
+    CompiledExpression compiledExpression;
+    char* key;
+    unsigned int hash;
+    int next;
+    atomic_int referenceCount;
+    atomic_int referenced;
+    int cached;
+} CachedExpression;
+
+
+// Structure for the counters of a cache, see get_expressionCache_statistics.
+typedef struct CacheStatistics {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    int count;
+    int capacity;
+} CacheStatistics;
+
+
+// Structure for the cache. Includes the lock, the `capacity` entry slots (NULL when empty), the hash buckets (each the
+// slot of the first entry of a chain linked by `next`, -1 if empty), the number of entries, the CLOCK hand, and the
+// hit, miss and eviction counters (atomic, updated without the write lock).
+typedef struct ExpressionCache {
+    pthread_rwlock_t lock;
+    CachedExpression** entries;
+    int* buckets;
+    int bucketMask;
+    int capacity;
+    int count;
+    int clockHand;
+    atomic_ullong hits;
+    atomic_ullong misses;
+    atomic_ullong evictions;
+} ExpressionCache;
+
+
+// Initializes `expressionCache` to hold up to `capacity` compiled expressions.
+// Returns 0 upon successful call. 1 if errors encountered. Errors are fatal.
+int init_expressionCache(ExpressionCache* expressionCache, int capacity);
+
+
+/**
+ * @brief Looks up the compiled expression of `sourceString`, compiling and inserting it if it is not in the cache.
+ *
+ * The entry written into `*cachedExpression` stays valid (and is not evicted) until it is given back with
+ * release_cachedExpression. Its `compiledExpression` may be evaluated by many threads at once, but must not be
+ * modified. Every call must be matched by one call to release_cachedExpression.
+ *
+ * @param expressionCache A pointer to an initialized ExpressionCache.
+ * @param sourceString A null-terminated string containing the mathematical expression.
+ * @param cachedExpression A pointer to the CachedExpression pointer to fill out.
+ * @return int Returns 0 on success, or 1 on failure (syntax errors are reported to stderr, and are not cached).
+ *         Errors are fatal.
+ */
+int acquire_cachedExpression(ExpressionCache* expressionCache, char* sourceString, CachedExpression** cachedExpression);
+
+
+// Gives back an entry returned by acquire_cachedExpression. Returns 0 upon success, 1 upon errors.
+int release_cachedExpression(ExpressionCache* expressionCache, CachedExpression* cachedExpression);
+
+
+// Evaluates `sourceString` through `expressionCache`, with `variableValues[slot]` as the value of each variable (slots
+// in order of first appearance in the source string), and writes the answer to `result`.
+// Returns 0 upon success, 1 upon errors (syntax errors, domain errors, memory). Errors are fatal.
+int evaluate_cachedExpression(ExpressionCache* expressionCache, char* sourceString, double* variableValues,
+                              double* result);
+
+
+// Writes the current counters of `expressionCache` into `cacheStatistics`. Returns 0 upon success, 1 upon errors.
+int get_expressionCache_statistics(ExpressionCache* expressionCache, CacheStatistics* cacheStatistics);
+
+
+/*
+ * - Frees every entry of the cache and the cache's tables.
+ * - No entry may still be held (acquired and not yet released) when the cache is freed.
+ * - The original ExpressionCache struct needs not to be freed (it was allocated onto the stack).
+ * - Returns 0 upon success, 1 upon errors.
+ */
+int free_expressionCache_memory(ExpressionCache* expressionCache);
+
+
+#endif // CACHE_H
@@ -8,5 +8,52 @@
 #define ERROR_FATAL_FUNCTION_CALL 1
 
 
+// Functions return the status codes above; what went wrong is reported through report_error. By default the message
+// is printed to stderr. A thread that installs an ErrorReport with capture_errors gets the first error of its calls
+// written into it instead, as a code, the position in the source string and the message, and nothing is printed.
 
-#endif // ERRORS_H
\ No newline at end of file
+
+// Enumeration for the kinds of errors
+typedef enum {
+    ERROR_CODE_NONE,
+    ERROR_CODE_SYNTAX,            // The source string could not be lexed or parsed
+    ERROR_CODE_DOMAIN,            // An operation was applied outside of its domain (divide by zero, ln of a negative)
+    ERROR_CODE_UNBOUND_VARIABLE,  // A variable was given no value
+    ERROR_CODE_MEMORY,            // Memory could not be allocated
+    ERROR_CODE_FILE,              // A file could not be read, or is not in the expected format
+    ERROR_CODE_INVALID_ARGUMENT   // A function was called with invalid parameters
+} TypeErrorCode;
+
+
+#define ERROR_MESSAGE_SIZE 128  // Longer messages are truncated
+
+
+// Structure for a captured error. `position` and `length` are the offset from the start of the source string and the
+// length of the text the error is about (-1 and 0 when it is not about a place in the source string, e.g. errors
+// found during evaluation). `message` is the message that would have been printed, without the "Error: " prefix.
+typedef struct ErrorReport {
+    TypeErrorCode code;
+    int position;
+    int length;
+    char message[ERROR_MESSAGE_SIZE];
+} ErrorReport;
+
+
+// Makes the errors reported by the calling thread go into `errorReport` (reset to ERROR_CODE_NONE here) until
+// capture_errors is called again, or be printed again when `errorReport` is NULL. Only the first error is kept, it
+// is the cause of the others. Returns the ErrorReport installed before, so calls can be nested.
+ErrorReport* capture_errors(ErrorReport* errorReport);
+
+
+// Reports an error of kind `errorCode` about the `length` characters at `position` in the source string (-1 if none).
+// `format` is the printf format of the message as printed to stderr (e.g. "\nError: mismatched parentheses.\n").
+void report_error(TypeErrorCode errorCode, int position, int length, const char* format, ...);
+
+
+// Moves the position of the error captured by the calling thread (if any, and if it is about a place in the source
+// string) by `offset`, for callers that lex a window of a longer source string. Positions past INT_MAX become -1.
+void shift_error_position(long long offset);
+
+
+
+#endif // ERRORS_H
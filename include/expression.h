@@ -0,0 +1,96 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "lex.h"
+#include "parser.h"
+#include "graph.h"
+#include "vm.h"
+#include "jit.h"
+
+
+// EXPRESSION module wraps the LEX and PARSER modules into a compile-once / evaluate-many handle. The source string is
+// lexed and converted to RPN exactly once, its constant subexpressions are folded by the OPTIMIZER module, and every
+// variable name found in it is bound to a slot index. The RPN is then turned into an expression graph by the GRAPH 
+// module (repeated subexpressions computed once) and into register bytecode by the VM module, and can optionally be
+// translated into native code by the JIT module.
+// The compiled expression can be evaluated any number of times with different values for its variables.
+
+
+// Structure for a compiled expression. Owns a copy of the source string (tokens point into it), the lexer token
+// list (as the lexer produced it), the copy of it in which constants were folded and that the postfix token list
+// refers to, the expression graph, the bytecode that is evaluated, its native code (`jit.function` is NULL until
+// enable_jit_compiledExpression succeeds), and the table of variable names (the index in the table is the variable's
+// slot).
+typedef struct CompiledExpression {
+    char* sourceString;
+    TokenList tokenList;
+    TokenList foldedTokenList;
+    StackTokenList postfixTokenList;
+    ExpressionGraph graph;
+    VmProgram vm;
+    JitExpression jit;
+    char** variableNames;
+    int variableCount;
+} CompiledExpression;
+
+
+/**
+ * @brief Compiles the input source string into a CompiledExpression that can be evaluated many times.
+ *
+ * @param sourceString A null-terminated string containing the mathematical expression. It is copied, so it need
+ *        not outlive the compiled expression.
+ * @param compiledExpression A pointer to the CompiledExpression struct to fill out.
+ * @return int Returns 0 on success, or 1 on failure (syntax errors are reported, see errors.h). Errors are fatal.
+ */
+int compile_expression(char* sourceString, CompiledExpression* compiledExpression);
+
+
+// Returns the slot index bound to the variable called `variableName` in `compiledExpression`.
+// Returns -1 if the expression does not use a variable with that name.
+int get_variable_slot(CompiledExpression* compiledExpression, char* variableName);
+
+
+// Translates `compiledExpression` into native code, used by every later evaluation. Evaluations the native code
+// cannot complete (domain errors) are redone by the interpreter, so results and error messages do not change.
+// Returns 0 upon success, 1 if the JIT is not available (evaluations keep using the interpreter). Errors are not fatal.
+int enable_jit_compiledExpression(CompiledExpression* compiledExpression);
+
+
+// Returns the number of values an evaluation of `compiledExpression` holds: the registers of its bytecode, or one per
+// graph node once it has native code. Returns 0 if `compiledExpression` is NULL.
+int get_compiledExpression_valueCount(CompiledExpression* compiledExpression);
+
+
+/**
+ * @brief Evaluates `compiledExpression` with the values of the evaluation held in a caller-owned, reusable context.
+ *
+ * @param compiledExpression A pointer to the CompiledExpression to evaluate (only read).
+ * @param variableValues The value of each variable, indexed by slot (may be NULL if the expression has no variables).
+ * @param doubleStack An initialized DoubleStack used as the context of the evaluation, grown only if it holds fewer
+ *        than get_compiledExpression_valueCount values: a DoubleStack initialized with that count (or reused across
+ *        calls) makes evaluations allocate no memory. One context must not be used by two threads at once.
+ * @param result A pointer to the double the answer is written into.
+ * @return int Returns 0 on success, or 1 on failure (domain errors, unbound variables, memory). Errors are fatal.
+ */
+int evaluate_compiledExpression_context(CompiledExpression* compiledExpression, double* variableValues,
+                                        DoubleStack* doubleStack, double* result);
+
+
+// Evaluates `compiledExpression` with `variableValues[slot]` as the value of each variable, writes answer to `result`.
+// `variableValues` must hold `variableCount` values (may be NULL if the expression has no variables). Convenience
+// wrapper of evaluate_compiledExpression_context: the context is on the stack for up to 64 values, allocated for the
+// call otherwise.
+// Returns 0 upon success, 1 upon errors (domain errors, unbound variables, memory). Errors are fatal.
+int evaluate_compiledExpression(CompiledExpression* compiledExpression, double* variableValues, double* result);
+
+
+/*
+ * - Frees all memory owned by the CompiledExpression (source copy, token lists, graph, bytecode, native code and
+ *   variable names).
+ * - The original CompiledExpression struct needs not to be freed (it was allocated onto the stack).
+ * - Returns 0 upon success, 1 upon errors.
+ */
+int free_compiledExpression_memory(CompiledExpression* compiledExpression);
+
+
+#endif // EXPRESSION_H
@@ -0,0 +1,42 @@
+#ifndef GRADIENT_H
+#define GRADIENT_H
+
+#include "graph.h"
+#include "expression.h"
+
+
+// GRADIENT module evaluates an expression together with its partial derivatives with respect to chosen variables in
+// a single pass over its graph (forward-mode automatic differentiation). Every node carries a dual number: its value
+// and the derivatives of that value with respect to each chosen variable, computed from the dual numbers of its
+// operands by the rule of its operation (sum, product and quotient rules, chain rule for the functions).
+
+// Values are computed as by evaluate_expressionGraph, with the same results and the same errors. Derivatives are
+// exact up to rounding, where finite differences need two more evaluations per variable and lose half the digits.
+// Folded constant subexpressions have no derivatives. The derivatives of asin and acos are infinite at -1 and 1.
+
+
+/**
+ * @brief Evaluates `expressionGraph` and its partial derivatives with respect to `slotCount` variables.
+ *
+ * @param expressionGraph A pointer to the ExpressionGraph to evaluate.
+ * @param variableValues The value of each variable, indexed by slot (may be NULL if the graph has no variables).
+ * @param slots The slots of the variables to derive by, or NULL for the slots 0 to `slotCount` - 1.
+ * @param slotCount The number of derivatives to compute.
+ * @param nodeValues Caller-provided scratch space for `nodeCount` * (`slotCount` + 1) doubles.
+ * @param result A pointer to the double the value of the expression is written into.
+ * @param gradient The array of `slotCount` doubles the derivatives are written into (may be NULL if `slotCount` is 0).
+ * @return int Returns 0 on success, or 1 on failure (domain errors, missing variable values). Errors are fatal.
+ */
+int evaluate_expressionGraph_gradient(ExpressionGraph* expressionGraph, double* variableValues, const int* slots,
+                                      int slotCount, double* nodeValues, double* result, double* gradient);
+
+
+// Evaluates `compiledExpression` and its partial derivatives with respect to the `slotCount` variables in `slots`
+// (every variable of the expression, in slot order, when `slots` is NULL: `gradient` then holds `variableCount`
+// values). Writes the value into `result` and the derivatives into `gradient`.
+// Returns 0 upon success, 1 upon errors (domain errors, missing variable values, memory). Errors are fatal.
+int evaluate_compiledExpression_gradient(CompiledExpression* compiledExpression, double* variableValues,
+                                         const int* slots, int slotCount, double* result, double* gradient);
+
+
+#endif // GRADIENT_H
@@ -0,0 +1,69 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include "lex.h"
+#include "parser.h"
+
+
+// GRAPH module converts the RPN produced by the PARSER module (and the OPTIMIZER module) into a directed acyclic graph.
+// Nodes are hash-consed: an operation on the same operands is only ever created once, so a subexpression repeated in
+// the source string (e.g. `sin(x*k)/(1+sin(x*k))`) is computed once per evaluation and its value reused. A `sin` and
+// a `cos` of the same argument are fused so that both values come from a single sincos evaluation.
+
+// Nodes are stored in the order they were created, which is a topological order (operands always come before the
+// operations using them), and the same order in which evaluate_postfixTokenList would first compute each value. The
+// graph is therefore evaluated by one loop over the array, and reports the same first error as the RPN would.
+
+
+// Structure for a node of the graph. `typeToken` is the operation: TOKEN_NUMBER (a constant `value`, keywords are
+// turned into numbers), TOKEN_VARIABLE (`operands[0]` is the variable slot), one of the binary operators, or
+// TOKEN_FUNCTION (`typeFunction` applied to `operands[0]`). Other `operands` are node indices, -1 when unused.
+// `sincosPartner` is the index of the node computing the `cos` of the same argument as this `sin` node (or
+// vice-versa), -1 if there is none. The first of the two nodes computes both values.
+typedef struct GraphNode {
+    double value;
+    int operands[2];
+    int sincosPartner;
+    unsigned char typeToken;
+    unsigned char typeFunction;
+} GraphNode;
+
+
+// Structure for an expression graph. Includes the array of nodes, the number of nodes, the index of the node whose
+// value is the value of the expression, and the table of variable names (borrowed, used for error messages, may be
+// NULL).
+typedef struct ExpressionGraph {
+    GraphNode* nodes;
+    int nodeCount;
+    int root;
+    char** variableNames;
+} ExpressionGraph;
+
+
+/**
+ * @brief Builds the expression graph of the RPN in `postfixTokenList`.
+ *
+ * @param lexicalTokenList A pointer to the TokenList the indices of `postfixTokenList` refer to. Variable tokens must
+ *        already be bound to slots.
+ * @param postfixTokenList A pointer to the StackTokenList holding the RPN of the expression.
+ * @param variableNames The table of variable names (indexed by slot), used in error messages. It is not copied.
+ * @param expressionGraph A pointer to the ExpressionGraph struct to fill out.
+ * @return int Returns 0 on success, or 1 on failure (invalid RPN, memory allocation). Errors are fatal.
+ */
+int build_expressionGraph(TokenList* lexicalTokenList, StackTokenList* postfixTokenList, char** variableNames,
+                          ExpressionGraph* expressionGraph);
+
+
+// Evaluates `expressionGraph` with `variableValues[slot]` as the value of each variable, writes answer to `result`.
+// `nodeValues` is caller-provided scratch space for `nodeCount` doubles, so evaluations never allocate memory and
+// one graph can be evaluated by many threads at once.
+// Returns 0 upon success, 1 upon errors (domain errors, missing variable values). Errors are fatal.
+int evaluate_expressionGraph(ExpressionGraph* expressionGraph, double* variableValues, double* nodeValues,
+                             double* result);
+
+
+// Frees the memory allocated for the nodes of `expressionGraph`. Returns 0 upon success, 1 upon errors.
+int free_expressionGraph_memory(ExpressionGraph* expressionGraph);
+
+
+#endif // GRAPH_H
@@ -0,0 +1,58 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stddef.h>
+
+#include "graph.h"
+
+
+// JIT module translates an expression graph (GRAPH module) into native x86-64 machine code, so evaluating an
+// expression is one call instead of a loop dispatching on every node. The generated function computes every node in
+// SSE2 registers and stores its value in the caller's scratch space, calling into libm for the functions.
+
+// The generated code does not print errors. Whenever an operation would raise a domain error (or a function returns
+// NaN) it stops and reports failure, and the caller evaluates the expression again with the interpreter (the bytecode
+// of the VM module for compiled expressions, see evaluate_compiledExpression_context), which reports the same error
+// as it always would. The JIT is only available on x86-64 (System V and Windows ABIs).
+
+
+// Signature of the generated code: takes the variable values and the scratch space for the node values (where the
+// value of the expression is left), returns 0 upon success, 1 if the graph must be evaluated by the interpreter.
+typedef int (*JitFunction)(const double* variableValues, double* nodeValues);
+
+
+// Structure for a JIT-compiled expression graph. Includes the executable memory holding the code, its size,
+// the entry point into it, the index of the node whose value is the value of the expression, and whether the
+// expression reads any variable.
+typedef struct JitExpression {
+    void* code;
+    size_t codeSize;
+    JitFunction function;
+    int root;
+    int hasVariables;
+} JitExpression;
+
+
+/**
+ * @brief Generates native code evaluating `expressionGraph`.
+ *
+ * @param expressionGraph A pointer to the ExpressionGraph to translate. It may be freed afterwards.
+ * @param jitExpression A pointer to the JitExpression struct to fill out.
+ * @return int Returns 0 on success, or 1 if the JIT is not available on this platform or executable memory could
+ *         not be allocated. Errors are not fatal: the graph can always be evaluated by the interpreter instead.
+ */
+int compile_jitExpression(ExpressionGraph* expressionGraph, JitExpression* jitExpression);
+
+
+// Evaluates `jitExpression` with `variableValues[slot]` as the value of each variable, writes answer to `result`.
+// `nodeValues` is scratch space for as many doubles as the graph it was compiled from has nodes.
+// Returns 0 upon success, 1 if the expression must be evaluated by the interpreter (domain errors, NaN values, or
+// `variableValues` is NULL but the expression has variables).
+int evaluate_jitExpression(JitExpression* jitExpression, double* variableValues, double* nodeValues, double* result);
+
+
+// Frees the executable memory of `jitExpression`. Returns 0 upon success, 1 upon errors.
+int free_jitExpression_memory(JitExpression* jitExpression);
+
+
+#endif // JIT_H
@@ -2,6 +2,9 @@
 #define LEX_H
 
 
+#define MAX_LEXEMME_LENGTH 65535  // Longest lexemme that fits in the length field of a token
+
+
 // Enumeration for valid token types
 typedef enum {
     TOKEN_NUMBER,
@@ -15,37 +18,63 @@ typedef enum {
 
     TOKEN_KEYWORD_PI, TOKEN_KEYWORD_E,
 
-    TOKEN_EOF
+    TOKEN_VARIABLE,
+
+    TOKEN_EOF,
+
+    TOKEN_OPERATOR_POWER  // Only produced by scan_token (PRATT module), after the others so their values do not change
 } TypeToken;
 
 
-// Struct for token. Includes token type, a pointer to the start of lexemme 
-// in main string, and length of lexemme.
+// Enumeration for supported functions. Function tokens are resolved to one of these by the lexer,
+// so the parser and evaluator never have to compare function names.
+typedef enum {
+    FUNCTION_SIN, FUNCTION_COS, FUNCTION_TAN,
+    FUNCTION_ASIN, FUNCTION_ACOS, FUNCTION_ATAN,
+    FUNCTION_LN, FUNCTION_LOG, FUNCTION_EXP,
+
+    FUNCTION_INVALID
+} TypeFunction;
+
+
+// Struct for token, stored by value in the contiguous array of a TokenList (12 bytes per token). Includes the offset
+// of the lexemme from the start of the source string, the length of the lexemme, the token type, and for function
+// tokens which function they call (FUNCTION_INVALID for other tokens). `slot` is the index of the value of a number token
+// in the TokenList's `numberValues` array (converted once by the lexer), or the slot index a variable token was bound
+// to when the expression was compiled (-1 if not bound yet).
 typedef struct Token {
-    TypeToken typeToken;
-    char* pLexemmeStart;
-    int length;
+    int offset;
+    unsigned short length;
+    unsigned char typeToken;
+    unsigned char typeFunction;
+    int slot;
 } Token;
 
 
-// Struct for a dynamic array of tokens. Includes pointer array of pointers to tokens, maximum capacity of the list
-// and current position in the list. This is the main output of the lexer.
+// Struct for the array of tokens produced by the lexer. Tokens are stored by value in `array`, and the values of the
+// number tokens in `numberValues`, both inside one allocation sized from the length of the source string up front 
+// (every token is at least one character long). Includes the source string the token offsets refer to, the maximum
+// capacity of the list, the current position in the list, and the number of values in `numberValues`.
 typedef struct TokenList {
-    Token** array;
+    Token* array;
+    double* numberValues;
+    char* sourceString;
     int position;
     int maxCapacity;
+    int numberCount;
 } TokenList;
 
 
-// Prints the data of the input `token` in format: "Token(type: "TYPE_TOKEN", value: "VALUE")"
+// Prints the data of the input `token` of `tokenList` in format: "Token(type: "TYPE_TOKEN", value: "VALUE")"
 // Returns 0 upon successful call, and 1 if errors encountered. Errors are fatal.
-int print_token(Token* token);
+int print_token(TokenList* tokenList, Token* token);
 
 
 
-// Initializes the fields for a `tokenList` struct instance
+// Initializes the fields for a `tokenList` struct instance, with room for the tokens of a source string of 
+// `sourceLength` characters. Longer source strings passed to lexical_analyzer later grow the list once.
 // Returns 0 if successful, 1 if errors encountered. Errors are fatal.
-int init_tokenList(TokenList* tokenList);
+int init_tokenList(TokenList* tokenList, int sourceLength);
 
 
 
@@ -53,20 +82,54 @@ int init_tokenList(TokenList* tokenList);
  * @brief Performs lexical analysis on the input source string, identifying tokens and storing them in a TokenList.
  * 
  * @param sourceString A null-terminated string containing the mathematical expression to be tokenized.
- * @param tokenList A pointer to a TokenList struct where the identified tokens will be stored.
+ * @param tokenList A pointer to an initialized TokenList struct where the identified tokens will be stored. Any tokens
+ *        from a previous call are discarded, so one TokenList can be reused for many source strings.
  * @return int Returns 0 on success, or 1, represented by an error code 
  *         (e.g., ERROR_INVALID_FUNCTION_PARAMETERS, ERROR_FATAL_FUNCTION_CALL) on failure. Errors are fatal.
  */
 int lexical_analyzer(char* sourceString, TokenList* tokenList);
 
 
+/**
+ * @brief Same as lexical_analyzer, for the first `sourceLength` characters of `sourceString`, which need not be
+ *        null-terminated: lines of a larger text (e.g. a memory-mapped file) are lexed where they are, without copies.
+ *
+ * @param sourceString The start of the source string. Tokens keep pointing into it (by offset).
+ * @param sourceLength The number of characters of the source string.
+ * @param tokenList A pointer to an initialized TokenList struct, as for lexical_analyzer.
+ * @return int Returns 0 on success, or 1 on failure (including when the character after the source string is not
+ *         '\0', '\n' or '\r'). Errors are fatal.
+ */
+int lexical_analyzer_length(char* sourceString, int sourceLength, TokenList* tokenList);
+
+
+/**
+ * @brief Scans the single token starting at `offset` in `sourceString` (after any whitespace), for parsers that lex on
+ *        demand instead of building a TokenList. Applies the same rules and reports the same errors as
+ *        lexical_analyzer, and also recognizes '^' (TOKEN_OPERATOR_POWER).
+ *
+ * @param sourceString The source string, ended by '\0', '\n' or '\r' (the end gives a TOKEN_EOF token).
+ * @param offset The offset in `sourceString` to scan from (the end of the previous token).
+ * @param token A pointer to the Token filled out (`offset` and `length` locate the lexemme, `slot` is -1).
+ * @param number A pointer to the double the value of a number token is written into.
+ * @return int Returns 0 on success, or 1 on failure (syntax errors). Errors are fatal.
+ */
+int scan_token(char* sourceString, int offset, Token* token, double* number);
+
+
 // Prints every token in the input `tokenList` struct.
 // Returns 0 upon successful call, and 1 if errors encountered. Errors are fatal.
 int print_tokenList(TokenList* tokenList);
 
 
+// Copies the tokens and number values of `tokenList` into the initialized `tokenListCopy` (grown if needed), which
+// refers to the same source string. Used to rewrite tokens (OPTIMIZER module) while keeping those of the lexer.
+// Returns 0 upon successful call, and 1 if errors encountered. Errors are fatal.
+int copy_tokenList(TokenList* tokenList, TokenList* tokenListCopy);
+
+
 /*
- * - Frees the memory allocated for the TokenList array and its tokens.
+ * - Frees the memory allocated for the TokenList array and its tokens (a single allocation).
  * - Ensures that no dangling pointers remain and that all allocated memory is properly freed.
  * - The original TokenList struct needs not to be freed (it was allocated onto the stack).
  * - Returns 0 upon success, 1 upon errors.
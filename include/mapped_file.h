@@ -0,0 +1,47 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+
+// MAPPED FILE module maps a whole file read-only into memory (mmap on POSIX systems, a file mapping on Windows), so
+// huge inputs are lexed where the operating system keeps them instead of being copied into the heap by read() calls.
+// Inputs read once from start to end are advised for sequential access, so pages are read ahead and dropped after.
+
+
+// Enumeration for how a mapped file is going to be read, passed on to the operating system as advice.
+typedef enum {
+    ACCESS_SEQUENTIAL,  // Read once from start to end (streams of expressions)
+    ACCESS_NORMAL  // Read again and in any order (program files, whose programs are evaluated as they are looked up)
+} TypeAccess;
+
+
+// Structure for a mapped file: its `size` bytes start at `data` (NULL for an empty file, which is not mapped).
+// `nullTerminated` is set when the size is not a multiple of the page size: the rest of the last page is mapped and
+// filled with zeros, so `data[size]` can be read and is '\0'. On Windows, `fileHandle` and `mappingHandle` are the
+// handles the mapping is made from (unused elsewhere).
+typedef struct MappedFile {
+    char* data;
+    size_t size;
+    int nullTerminated;
+    void* fileHandle;
+    void* mappingHandle;
+} MappedFile;
+
+
+// Maps the file called `fileName` into `mappedFile`, advised for the access pattern `typeAccess`. The data must not be
+// written to.
+// Returns 0 upon success, 1 if the file could not be opened or mapped (e.g. a pipe). Errors are not fatal: the file
+// can still be read as a stream.
+int map_file(const char* fileName, TypeAccess typeAccess, MappedFile* mappedFile);
+
+
+/*
+ * - Unmaps the MappedFile and closes the file.
+ * - The original MappedFile struct needs not to be freed (it was allocated onto the stack).
+ * - Returns 0 upon success, 1 upon errors.
+ */
+int free_mappedFile_memory(MappedFile* mappedFile);
+
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,69 @@
+#ifndef MATHEVAL_H
+#define MATHEVAL_H
+
+#include "errors.h"
+#include "expression.h"
+#include "gradient.h"
+
+
+// MATHEVAL module is the public interface of the matheval library: compiling an expression, evaluating it and its
+// gradient, and freeing it, with what went wrong returned in an ErrorReport instead of printed. It only wraps the
+// EXPRESSION and GRADIENT modules between calls to capture_errors, so the CompiledExpression it fills out can also be
+// used with every other module (get_variable_slot finds the slot of a variable, enable_jit_compiledExpression adds
+// native code).
+
+// The library has no global state but the statistics counters (STATISTICS module, off unless enabled): compiling
+// only touches the CompiledExpression being filled out, and evaluating only reads it, so any number of threads can
+// compile and evaluate at once, and share a compiled expression for evaluations. Nothing is printed by these calls.
+
+
+/**
+ * @brief Compiles `sourceString` into `compiledExpression`, see compile_expression.
+ *
+ * @param sourceString A null-terminated string containing the mathematical expression (copied).
+ * @param compiledExpression A pointer to the CompiledExpression struct to fill out. On failure it holds nothing and
+ *        needs not to be freed.
+ * @param errorReport A pointer to the ErrorReport filled out on failure (code, position of the offending text in
+ *        `sourceString`, message), or NULL.
+ * @return int Returns 0 on success, or 1 on failure.
+ */
+int matheval_compile(char* sourceString, CompiledExpression* compiledExpression, ErrorReport* errorReport);
+
+
+/**
+ * @brief Evaluates `compiledExpression`, see evaluate_compiledExpression.
+ *
+ * @param compiledExpression A pointer to the CompiledExpression to evaluate (only read).
+ * @param variableValues The value of each variable, indexed by slot (may be NULL if the expression has no variables).
+ * @param result A pointer to the double the answer is written into.
+ * @param errorReport A pointer to the ErrorReport filled out on failure (domain errors, unbound variables, memory), or
+ *        NULL. Evaluation errors have no position.
+ * @return int Returns 0 on success, or 1 on failure.
+ */
+int matheval_evaluate(CompiledExpression* compiledExpression, double* variableValues, double* result,
+                      ErrorReport* errorReport);
+
+
+// Same as matheval_evaluate, with the values of the evaluation held in `doubleStack`, a context owned by the caller
+// (init_doubleStack, free_doubleStack_memory) and reused across calls, so evaluations allocate no memory once it is
+// large enough (see evaluate_compiledExpression_context). Each thread needs its own context.
+// Returns 0 upon success, 1 upon errors, described in `errorReport` if it is not NULL.
+int matheval_evaluate_context(CompiledExpression* compiledExpression, double* variableValues, DoubleStack* doubleStack,
+                              double* result, ErrorReport* errorReport);
+
+
+// Evaluates `compiledExpression` and its derivative with respect to each of its variables (`gradient` holds
+// `variableCount` values, in slot order), see evaluate_compiledExpression_gradient.
+// Returns 0 upon success, 1 upon errors, described in `errorReport` if it is not NULL.
+int matheval_evaluate_gradient(CompiledExpression* compiledExpression, double* variableValues, double* result,
+                               double* gradient, ErrorReport* errorReport);
+
+
+/*
+ * - Frees all memory owned by the CompiledExpression, see free_compiledExpression_memory.
+ * - Returns 0 upon success, 1 upon errors.
+ */
+int matheval_free(CompiledExpression* compiledExpression);
+
+
+#endif // MATHEVAL_H
@@ -0,0 +1,58 @@
+#ifndef OPERATIONS_H
+#define OPERATIONS_H
+
+#include "lex.h"
+
+
+// OPERATIONS module holds the arithmetic shared by every stage that computes values: the evaluator, and the optimizer
+// that folds constant subexpressions at compile time. Both must agree on the values of the constants and on which
+// inputs are outside the domain of an operation, so the checks live here once. The operations themselves never report
+// errors.
+
+
+// Values of the keyword constants `pi` and `e`
+extern const double CONSTANT_PI;
+extern const double CONSTANT_E;
+
+
+// Enumeration for the domain errors an operation can report (DOMAIN_VALID when the value could be computed)
+typedef enum {
+    DOMAIN_VALID,
+
+    DOMAIN_ERROR_DIVIDE_BY_ZERO,
+    DOMAIN_ERROR_TAN, DOMAIN_ERROR_ASIN, DOMAIN_ERROR_ACOS,
+    DOMAIN_ERROR_LN, DOMAIN_ERROR_LOG,
+    DOMAIN_ERROR_POWER,
+
+    DOMAIN_ERROR_UNKNOWN_OPERATION
+} TypeDomainError;
+
+
+// Applies the binary operator `typeToken` (+, -, *, /, ^) to `a` and `b` and writes the value into `result`. `a ^ b`
+// is a divide by zero for `a` = 0 and `b` < 0, and undefined for `a` < 0 and a `b` that is not an integer.
+// Returns DOMAIN_VALID upon success, or the domain error that prevented the value from being computed.
+TypeDomainError apply_operator(TypeToken typeToken, double a, double b, double* result);
+
+
+// Applies the function `typeFunction` to `x` and writes the value into `result`.
+// Returns DOMAIN_VALID upon success, or the domain error that prevented the value from being computed.
+TypeDomainError apply_function(TypeFunction typeFunction, double x, double* result);
+
+
+// Computes both the sine and the cosine of `x` (never a domain error), with a single call where the C library allows
+// it. The values are the same as those of apply_function with FUNCTION_SIN and FUNCTION_COS.
+void apply_sincos(double x, double* sinValue, double* cosValue);
+
+
+// Returns the derivative of the function `typeFunction` at `x`, where `value` is the value of the function at `x` (as
+// computed by apply_function). `x` must be inside the domain of the function; the derivatives of asin and acos are
+// infinite at -1 and 1.
+double derive_function(TypeFunction typeFunction, double x, double value);
+
+
+// Reports `domainError` raised by an operation on the argument `x` (printed to stderr unless errors are captured, see
+// capture_errors in errors.h).
+void print_domain_error(TypeDomainError domainError, double x);
+
+
+#endif // OPERATIONS_H
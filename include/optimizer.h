@@ -0,0 +1,31 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "lex.h"
+#include "parser.h"
+
+
+// OPTIMIZER module rewrites the RPN produced by the PARSER module before it is evaluated. Every subexpression that
+// does not depend on a variable (numbers, `pi`, `e`, and operators or functions over them) is computed once and
+// replaced by a single number token, so repeated evaluations only do the work that actually varies.
+
+// A subexpression whose value is outside the domain of an operation (e.g. `1/0` or `ln(0)`) is left as it is, so the
+// evaluator still reports the same error when the expression is evaluated.
+
+
+/**
+ * @brief Folds every constant subexpression of `postfixTokenList` into a single number token.
+ *
+ * The root token of each folded subexpression is rewritten in place into a TOKEN_NUMBER whose value is stored in
+ * the `numberValues` of `lexicalTokenList`, and whose lexemme spans the whole subexpression (for printing). The
+ * other tokens of the subexpression are removed from `postfixTokenList`. Tokens and number values of the list are
+ * rewritten, so pass it a copy (copy_tokenList) to keep the tokens produced by the lexer.
+ *
+ * @param lexicalTokenList A pointer to the TokenList the indices of `postfixTokenList` refer to.
+ * @param postfixTokenList A pointer to the StackTokenList holding the RPN produced by shunting_yard_algorithm.
+ * @return int Returns 0 on success, or 1 on failure (invalid parameters, memory allocation). Errors are fatal.
+ */
+int fold_constants(TokenList* lexicalTokenList, StackTokenList* postfixTokenList);
+
+
+#endif // OPTIMIZER_H
@@ -8,42 +8,54 @@
 // Parser errors (invalid function names, invalid parenthesis, and unexpected token list (e.g. two operators in a row)) happen during
 // Conversion to RPN
 
-// Other errors (divide by 0, more invalid stuff, happen during evalution of rpn)
+// Operators missing an operand (`1+`, `sin()`) and operands missing an operator (`1 2`) are also found then: the
+// parser follows the depth of the evaluation stack while it writes the RPN, and records its maximum.
 
+// Other errors (divide by 0, unbound variables) happen during evalution of rpn. The evaluation allocates nothing and
+// checks nothing per value once its DoubleStack is as deep as the RPN needs.
 
-// Structure for a fixed-length stack version of an array of token pointers.
-// Used for operator stack AND output token list in shunting yard algorithm 
+
+// Structure for a fixed-length stack version of an array of token indices (into the array of the lexer TokenList).
+// Used for operator stack AND output token list in shunting yard algorithm (the operator stack is the upper half of
+// the output list's array). `evaluationDepth` is the most values the evaluation stack holds while evaluating the
+// output list (set by shunting_yard_algorithm; folding constants can only lower the actual depth).
 typedef struct StackTokenList {
-    Token** array;
+    int* array;
     int top;
+    int maxCapacity;
+    int evaluationDepth;
 } StackTokenList;
 
 
-// Structure for stack for evaluatig the RPF token list
+// Structure for stack for evaluatig the RPF token list, the reusable context of evaluate_postfixTokenList
 // All numbers are converted to doubles
 typedef struct DoubleStack {
     double* array;
     int top;
+    int maxCapacity;
 } DoubleStack;
 
 
 
 // Function for initializing `stackTokenList` based on the `lexicalTokenList` produced by the lexer module
 // Note that any instance of StackTokenList can ONLY store up to the maximum number of tokens produced by the lexer or less
+// (it has room for twice as many, for the operator stack of shunting_yard_algorithm)
 // Returns 0 upon successful call. 1 if errors encountered. Errors are fatal.
 int init_StackTokenList(TokenList* lexicalTokenList, StackTokenList* stackTokenList);
 
 
 // Function implementation of the shunting yard algorithm.
 // Takes input `lexicalTokenList` created from lex module and an initialized `postfixTokenList`
-// Performs shunting yard algorithm and fills out the postfixTokenList
-// Returns 0 upon success. 1 if errors encountered. Errors are fatal.
+// Performs shunting yard algorithm and fills out the postfixTokenList. Any tokens from a previous call are discarded
+// (and the list grown if needed), so one postfixTokenList can be reused for many token lists and nothing is allocated.
+// Checks that every operator and function has its operands and computes `evaluationDepth`.
+// Returns 0 upon success. 1 if errors encountered (syntax errors, memory). Errors are fatal.
 int shunting_yard_algorithm(TokenList* lexicalTokenList, StackTokenList* postfixTokenList);
 
 
-// Prints every token in the input `stackTokenList` struct.
+// Prints every token in the input `stackTokenList` struct (tokens are looked up in `lexicalTokenList`).
 // Returns 0 upon successful call, and 1 if errors encountered. Errors are fatal.
-int print_stackTokenList(StackTokenList* stackTokenList);
+int print_stackTokenList(TokenList* lexicalTokenList, StackTokenList* stackTokenList);
 
 
 /*
@@ -55,9 +67,29 @@ int print_stackTokenList(StackTokenList* stackTokenList);
 int free_stackTokenList_memory(StackTokenList* stackTokenList);
 
 
-// Function for evaluating the `postfixTokenList` Returns the final answer (double).
-// Any errors with memory allocation and etc are fatal.
-double evaluate_postfixTokenList(StackTokenList* postfixTokenList);
+// Function for initializing `doubleStack` with room for `capacity` values. 
+// Returns 0 upon successful call. 1 if errors encountered. Errors are fatal.
+int init_doubleStack(DoubleStack* doubleStack, int capacity);
+
+
+// Makes sure the initialized `doubleStack` can hold `capacity` values, growing its array only if needed (it never
+// shrinks, so a DoubleStack reused across calls stops allocating once it is as large as the deepest evaluation).
+// Returns 0 upon successful call. 1 if errors encountered. Errors are fatal.
+int reserve_doubleStack(DoubleStack* doubleStack, int capacity);
+
+
+// Frees the memory allocated for the DoubleStack array. Returns 0 upon success, 1 upon errors.
+int free_doubleStack_memory(DoubleStack* doubleStack);
+
+
+// Function for evaluating the `postfixTokenList` filled out by shunting_yard_algorithm (tokens are looked up in
+// `lexicalTokenList`). Writes the final answer (double) into `result`. `variableValues` holds one value per variable
+// slot (may be NULL if the expression has no variables). `doubleStack` is an initialized DoubleStack used for the
+// evaluation, grown only if it holds fewer than `evaluationDepth` values: a DoubleStack reused across calls (or
+// initialized with the `evaluationDepth` of the list) makes evaluations allocate no memory.
+// Returns 0 upon success, 1 upon errors (domain errors, unbound variables, memory). Errors are fatal.
+int evaluate_postfixTokenList(TokenList* lexicalTokenList, StackTokenList* postfixTokenList, double* variableValues,
+                              DoubleStack* doubleStack, double* result);
 
 
 
@@ -0,0 +1,66 @@
+#ifndef PRATT_H
+#define PRATT_H
+
+#include "vm.h"
+
+
+// PRATT module is a single-pass front end: it compiles a source string straight into bytecode for the VM module,
+// without building a TokenList, a postfix list, an operator stack or an expression graph. Tokens are scanned on demand
+// (scan_token), one lookahead token at a time, and parsed by precedence climbing (a Pratt parser): each operator has a
+// binding power, and the operand on its right is parsed with the binding power that makes it left or right
+// associative. Instructions are emitted as soon as both operands of an operation are known.
+
+// The grammar is that of the LEX and PARSER modules, plus the right-associative power operator `^` (binding tighter
+// than the unary minus, so `-2^2` is -4 and `2^3^2` is 2^9) and the unary `-` and `+` (`-x`, `2*-3`, `2^-1`).
+// Constant operands are folded while parsing, as by the OPTIMIZER module (operations outside of their domain are left
+// for the evaluation to report), and a constant left or right operand is folded into the instruction (`x*2` is one
+// instruction). Registers are given out as a stack, so an evaluation needs as many as the parse was deep.
+
+// Syntax errors are reported with the position of the offending token. Expressions nested deeper than
+// MAX_PRATT_DEPTH levels (parentheses, unary operators, chains of `^`) are rejected, since the parser recurses.
+
+
+#define MAX_PRATT_DEPTH 10000
+
+
+// Structure for an expression compiled by the PRATT module. Includes its bytecode and the table of variable names
+// (the index in the table is the variable's slot, slots are given in order of first appearance).
+typedef struct PrattExpression {
+    VmProgram vm;
+    char** variableNames;
+    int variableCount;
+} PrattExpression;
+
+
+/**
+ * @brief Compiles the input source string into bytecode in a single pass.
+ *
+ * @param sourceString A null-terminated string containing the mathematical expression. It is not referenced once
+ *        compiled.
+ * @param prattExpression A pointer to the PrattExpression struct to fill out. On failure it holds nothing and needs
+ *        not to be freed.
+ * @return int Returns 0 on success, or 1 on failure (syntax errors, memory). Errors are fatal.
+ */
+int compile_prattExpression(char* sourceString, PrattExpression* prattExpression);
+
+
+// Returns the slot index bound to the variable called `variableName` in `prattExpression`.
+// Returns -1 if the expression does not use a variable with that name.
+int get_prattExpression_slot(PrattExpression* prattExpression, char* variableName);
+
+
+// Evaluates `prattExpression` with `variableValues[slot]` as the value of each variable, writes answer to `result`.
+// `variableValues` must hold `variableCount` values (may be NULL if the expression has no variables).
+// Returns 0 upon success, 1 upon errors (domain errors, unbound variables, memory). Errors are fatal.
+int evaluate_prattExpression(PrattExpression* prattExpression, double* variableValues, double* result);
+
+
+/*
+ * - Frees all memory owned by the PrattExpression (bytecode and variable names).
+ * - The original PrattExpression struct needs not to be freed (it was allocated onto the stack).
+ * - Returns 0 upon success, 1 upon errors.
+ */
+int free_prattExpression_memory(PrattExpression* prattExpression);
+
+
+#endif // PRATT_H
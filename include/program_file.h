@@ -0,0 +1,123 @@
+#ifndef PROGRAM_FILE_H
+#define PROGRAM_FILE_H
+
+#include <stdint.h>
+
+#include "graph.h"
+#include "expression.h"
+#include "mapped_file.h"
+
+
+// PROGRAM FILE module saves compiled expressions to a binary file that later runs map into memory and evaluate as they
+// are, so a library of formulas is lexed, parsed, folded and turned into graphs once instead of at every start. Each
+// program is the expression graph built by the GRAPH module (folded constants, operations, the variable slot of each
+// variable node), its source string, its table of variable names, and the number of values its evaluation needs.
+
+// Every reference inside the file is an offset from the start of the file and graph nodes refer to each other by
+// index, so the file is position-independent: nothing is parsed or relocated when it is loaded. The nodes are stored
+// in the in-memory layout of GraphNode and evaluated in place. The header records the byte order and node size of the
+// machine that wrote the file, and files from a different layout are rejected. It also records a checksum of the whole
+// file, so truncated or damaged files are rejected: loading a file maps it and hashes every byte of it (linear in its
+// size, a single pass with no allocation), then checks that the header and program records point inside it. The nodes
+// of a program are checked each time its graph is taken (get_programFile_graph, linear in its node count).
+
+
+#define PROGRAM_FILE_MAGIC "MATHPRGM"
+#define PROGRAM_FILE_VERSION 2
+#define PROGRAM_FILE_BYTE_ORDER 0x01020304u
+
+
+// Structure for the header at the start of a program file. `programsOffset` is the offset of the `programCount`
+// program records, `bucketsOffset` that of the hash table finding a program from its source string (`bucketCount`
+// entries, a power of two, each the index of a program plus one, 0 when empty, with linear probing). `checksum` is the
+// FNV-1a hash of the `fileSize` bytes of the file, those of `checksum` itself counted as zeros.
+typedef struct ProgramFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t nodeSize;
+    uint32_t programCount;
+    uint64_t fileSize;
+    uint64_t programsOffset;
+    uint64_t bucketsOffset;
+    uint32_t bucketCount;
+    uint32_t checksum;
+} ProgramFileHeader;
+
+
+// Structure for the record of one program. The offsets are those of its null-terminated source string, of its
+// `nodeCount` graph nodes (8-byte aligned), and of the offsets of its `variableCount` null-terminated variable names
+// (indexed by slot). `root` is the index of the node whose value is the value of the expression, and `valueCount` the
+// number of doubles of scratch space an evaluation needs. `sourceHash` is the FNV-1a hash of the source string.
+typedef struct ProgramRecord {
+    uint64_t sourceOffset;
+    uint64_t nodesOffset;
+    uint64_t variableNamesOffset;
+    uint32_t sourceLength;
+    uint32_t sourceHash;
+    int32_t nodeCount;
+    int32_t root;
+    int32_t variableCount;
+    int32_t valueCount;
+} ProgramRecord;
+
+
+// Structure for a loaded program file: the mapping, and the header, program records and hash table inside it.
+typedef struct ProgramFile {
+    MappedFile mappedFile;
+    const ProgramFileHeader* header;
+    const ProgramRecord* programs;
+    const uint32_t* buckets;
+    int programCount;
+} ProgramFile;
+
+
+/**
+ * @brief Writes the `count` compiled expressions in `compiledExpressions` to a program file called `fileName`.
+ *
+ * @param fileName The name of the file to create (replaced if it exists).
+ * @param compiledExpressions An array of `count` compiled expressions. Their source strings identify them in the file.
+ * @param count The number of compiled expressions.
+ * @return int Returns 0 on success, or 1 on failure (file could not be written, memory allocation). Errors are fatal.
+ */
+int write_programFile(const char* fileName, CompiledExpression* compiledExpressions, int count);
+
+
+// Maps the program file called `fileName` into `programFile` and checks its header, checksum (which reads the whole
+// file) and program records.
+// Returns 0 upon success, 1 if the file could not be mapped or is not a valid program file for this machine (a
+// message is printed). Errors are fatal.
+int load_programFile(const char* fileName, ProgramFile* programFile);
+
+
+// Returns the index of the program compiled from `sourceString` (compared as written) in `programFile`.
+// Returns -1 if the file has no such program.
+int find_programFile_program(ProgramFile* programFile, const char* sourceString);
+
+
+// Fills `expressionGraph` with the graph of program `index` of `programFile`. The nodes are those inside the mapping,
+// so the graph must not be freed, and stays valid until the program file is freed. It can be evaluated like any graph
+// (evaluate_expressionGraph with `nodeCount` doubles of scratch space, build_batchProgram, compile_jitExpression).
+// The nodes are checked here, at every call, so a damaged file cannot make an evaluation read outside of its arrays.
+// Returns 0 upon success, 1 if the index or the program is invalid. Errors are fatal.
+int get_programFile_graph(ProgramFile* programFile, int index, ExpressionGraph* expressionGraph);
+
+
+// Returns the source string of program `index` of `programFile`, NULL if the index is invalid.
+const char* get_programFile_source(ProgramFile* programFile, int index);
+
+
+// Returns the number of variables of program `index` of `programFile` (-1 if the index is invalid), and writes the
+// table of their names (indexed by slot) into `variableNames` when it is not NULL (room for that many pointers).
+int get_programFile_variables(ProgramFile* programFile, int index, const char** variableNames);
+
+
+/*
+ * - Unmaps the ProgramFile. Graphs obtained from it can no longer be used.
+ * - The original ProgramFile struct needs not to be freed (it was allocated onto the stack).
+ * - Returns 0 upon success, 1 upon errors.
+ */
+int free_programFile_memory(ProgramFile* programFile);
+
+
+#endif // PROGRAM_FILE_H
@@ -0,0 +1,140 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "timer.h"
+
+
+// STATISTICS module records where the evaluator spends its time and memory: the nanoseconds spent in each phase, the
+// number of tokens and numbers lexed, the peak depths of the parser and evaluator stacks, and the number and size of
+// the heap allocations made by the library (every module: the compiler, the back ends, the cache, batch evaluation,
+// the thread pool, streaming and program files; the pages mapped for JIT code count as allocations too).
+
+// Recording is compiled in unless MATH_EVALUATOR_NO_STATISTICS is defined, and then only done once enabled with
+// enable_statistics: while disabled, each instrumented call only tests one flag. Counters are shared by every thread
+// (atomic adds), so enabling them costs more when many threads evaluate at once.
+
+
+// Enumeration for the timed phases. Phases can be nested: the time spent in functions is also part of evaluation.
+typedef enum {
+    STATISTICS_PHASE_LEX,
+    STATISTICS_PHASE_PARSE,
+    STATISTICS_PHASE_FOLD,
+    STATISTICS_PHASE_GRAPH,
+    STATISTICS_PHASE_EVALUATE,
+    STATISTICS_PHASE_FUNCTIONS,
+
+    STATISTICS_PHASE_COUNT
+} TypeStatisticsPhase;
+
+
+// Enumeration for the counters. Slow numbers are the numbers the lexer could not convert exactly itself and passed to
+// strtod, allocated bytes count the size asked for (the new size for a reallocation).
+typedef enum {
+    STATISTICS_TOKENS,
+    STATISTICS_NUMBERS,
+    STATISTICS_SLOW_NUMBERS,
+    STATISTICS_ALLOCATIONS,
+    STATISTICS_ALLOCATED_BYTES,
+
+    STATISTICS_COUNTER_COUNT
+} TypeStatisticsCounter;
+
+
+// Enumeration for the recorded peaks: the deepest operator stack of the shunting yard algorithm, and the deepest
+// value stack of an evaluation: the stack of a postfix token list, or the values held by the evaluation of a compiled
+// expression (the registers of its bytecode, or one per graph node with native code).
+typedef enum {
+    STATISTICS_PEAK_OPERATOR_STACK,
+    STATISTICS_PEAK_VALUE_STACK,
+
+    STATISTICS_PEAK_COUNT
+} TypeStatisticsPeak;
+
+
+// Structure for a snapshot of the statistics: the calls and nanoseconds of each phase, the counters and the peaks.
+typedef struct Statistics {
+    unsigned long long phaseCalls[STATISTICS_PHASE_COUNT];
+    unsigned long long phaseNanoseconds[STATISTICS_PHASE_COUNT];
+    unsigned long long counters[STATISTICS_COUNTER_COUNT];
+    unsigned long long peaks[STATISTICS_PEAK_COUNT];
+} Statistics;
+
+
+// Set while statistics are recorded, see enable_statistics.
+extern atomic_int statisticsEnabled;
+
+#if defined(MATH_EVALUATOR_NO_STATISTICS)
+#define STATISTICS_ENABLED 0
+#else
+#define STATISTICS_ENABLED atomic_load_explicit(&statisticsEnabled, memory_order_relaxed)
+#endif
+
+
+// Starts (`enabled` set) or stops recording statistics. Has no effect if MATH_EVALUATOR_NO_STATISTICS is defined.
+void enable_statistics(int enabled);
+
+
+// Sets every recorded statistic back to zero.
+void reset_statistics(void);
+
+
+// Copies the statistics recorded so far into `statistics`. Returns 0 upon success, 1 upon errors.
+int get_statistics(Statistics* statistics);
+
+
+// Writes `statistics` to `output` as a JSON object (phases with their calls and nanoseconds, counters and peaks).
+// Returns 0 upon success, 1 upon errors.
+int write_statistics_json(Statistics* statistics, FILE* output);
+
+
+// Adds one call of `nanoseconds` to `phase`, `value` to `counter`, or raises `peak` to `value`. Used by the
+// instrumented modules through the inline functions below.
+void record_statistics_phase(TypeStatisticsPhase phase, unsigned long long nanoseconds);
+void record_statistics_counter(TypeStatisticsCounter counter, unsigned long long value);
+void record_statistics_peak(TypeStatisticsPeak peak, unsigned long long value);
+
+
+// Returns the clock reading marking the start of a phase when statistics are enabled, 0 otherwise.
+static inline unsigned long long start_statistics_phase(void) {
+    return STATISTICS_ENABLED ? get_timer_nanoseconds() : 0;
+}
+
+
+// Ends the phase `phase` started at `start` (see start_statistics_phase), nothing is recorded if `start` is 0.
+static inline void end_statistics_phase(TypeStatisticsPhase phase, unsigned long long start) {
+    if (start != 0) {
+        record_statistics_phase(phase, get_timer_nanoseconds() - start);
+    }
+}
+
+
+// Adds `value` to `counter` when statistics are enabled.
+static inline void count_statistics(TypeStatisticsCounter counter, unsigned long long value) {
+    if (STATISTICS_ENABLED) {
+        record_statistics_counter(counter, value);
+    }
+}
+
+
+// Counts one heap allocation of `bytes` bytes when statistics are enabled.
+static inline void count_statistics_allocation(size_t bytes) {
+    if (STATISTICS_ENABLED) {
+        record_statistics_counter(STATISTICS_ALLOCATIONS, 1);
+        record_statistics_counter(STATISTICS_ALLOCATED_BYTES, bytes);
+    }
+}
+
+
+// Raises `peak` to `value` when statistics are enabled.
+static inline void raise_statistics_peak(TypeStatisticsPeak peak, unsigned long long value) {
+    if (STATISTICS_ENABLED) {
+        record_statistics_peak(peak, value);
+    }
+}
+
+
+#endif // STATISTICS_H
@@ -0,0 +1,105 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+
+#include "thread_pool.h"
+
+
+// STREAM module evaluates many newline-delimited expressions in one process. The lexer, parser and evaluator
+// buffers are created once and reused for every line, and one result is written per input line. Large inputs can be
+// evaluated by the workers of a THREAD POOL, each with its own buffers, with the results still written in input order.
+// A single expression too long to hold in memory (or its token lists) can be evaluated as it is read instead.
+
+// Blank lines (empty, or only spaces) hold no expression and are never errors: evaluate_stream writes an empty result
+// line for them, so results stay lined up with the input lines, evaluate_stream_expression skips them to the first
+// line holding something, and the compile mode of the program stores no program for them.
+
+
+// Returns 1 if the `length` characters at `line` (without its line ending) are a blank line: empty, or only spaces.
+// Returns 0 otherwise, and for lines too long to lex (`length` < 0).
+int is_blank_line(char* line, int length);
+
+
+/**
+ * @brief Evaluates every line of `input` as an expression and writes one result per line to `output`.
+ *
+ * Each result is written with full precision ("%.17g"). A line that cannot be evaluated (syntax or domain error)
+ * produces the line "error" in `output` and a message naming the line number on stderr, and the stream continues
+ * with the next line. A blank line produces an empty line in `output` and is not counted as failed. Trailing '\r'
+ * characters (Windows line endings) are ignored.
+ *
+ * @param input The stream to read expressions from (e.g. stdin or an opened file).
+ * @param output The stream to write the results to.
+ * @param failedLines A pointer to an int that receives the number of lines that could not be evaluated.
+ * @return int Returns 0 on success (even if some lines failed), or 1 if the stream itself could not be processed
+ *         (memory allocation or read errors). Errors are fatal.
+ */
+int evaluate_stream(FILE* input, FILE* output, int* failedLines);
+
+
+/**
+ * @brief Same as evaluate_stream, with the lines evaluated by the workers of `threadPool`.
+ *
+ * The input is read in batches of a few megabytes. The lines of a batch are split into chunks of lines shared out to
+ * the workers (a worker done with its chunks steals the chunks of the others, so long expressions do not hold the
+ * batch back), and the results of the batch are then written in input order. The output and the "Error on line"
+ * messages are the same as with evaluate_stream, the messages of the lexer and parser are printed by the workers as
+ * lines fail, so they may come in any order.
+ *
+ * @param input The stream to read expressions from (e.g. stdin or an opened file).
+ * @param output The stream to write the results to.
+ * @param threadPool A pointer to an initialized ThreadPool, not running another loop.
+ * @param failedLines A pointer to an int that receives the number of lines that could not be evaluated.
+ * @return int Returns 0 on success (even if some lines failed), or 1 if the stream itself could not be processed
+ *         (memory allocation or read errors). Errors are fatal.
+ */
+int evaluate_stream_parallel(FILE* input, FILE* output, ThreadPool* threadPool, int* failedLines);
+
+
+/**
+ * @brief Same as evaluate_stream (or evaluate_stream_parallel with a thread pool) for the lines of the `length`
+ *        characters at `text`, typically a memory-mapped file (see include/mapped_file.h).
+ *
+ * Lines are lexed where they are in the text, without being copied (the text is never written to). Only a last line
+ * without a line ending is copied, when the text is not null-terminated.
+ *
+ * @param text The text holding one expression per line (may be NULL if `length` is 0).
+ * @param length The number of characters of the text.
+ * @param nullTerminated 1 if `text[length]` can be read and is '\0', 0 otherwise.
+ * @param output The stream to write the results to.
+ * @param threadPool A pointer to an initialized ThreadPool to evaluate the lines on, or NULL to evaluate them in the
+ *        calling thread.
+ * @param failedLines A pointer to an int that receives the number of lines that could not be evaluated.
+ * @return int Returns 0 on success (even if some lines failed), or 1 on memory allocation errors. Errors are fatal.
+ */
+int evaluate_text(char* text, size_t length, int nullTerminated, FILE* output, ThreadPool* threadPool,
+                  int* failedLines);
+
+
+/**
+ * @brief Evaluates the expression on the first non-blank line of `input` as it is read, in memory bounded by its
+ *        nesting depth.
+ *
+ * The input is read in chunks of 1 MiB and lexed one token at a time, and each operator is applied as soon as the
+ * shunting yard algorithm would output it, so no token list, postfix list or copy of the line is made: memory is the
+ * chunk plus stacks holding the operations still waiting for an operand (a few per level of parentheses), whatever the
+ * length of the expression. The grammar and the result are those of the other functions of the module. Errors are
+ * reported as by the lexer, parser and evaluator, with positions counted from the start of the input, but the
+ * expression is evaluated while it is parsed: a domain error is reported before a syntax error further on.
+ *
+ * @param input The stream to read the expression from (e.g. stdin or an opened file). Blank lines before the expression
+ *        are skipped (positions still count them), and reading stops at the line ending after it. An input holding
+ *        only blank lines is an empty expression (syntax error).
+ * @param variableNames The name of each variable the expression may use (may be NULL if `variableCount` is 0).
+ * @param variableValues The value of each variable, in the order of `variableNames`.
+ * @param variableCount The number of variables.
+ * @param result A pointer to the double the answer is written into.
+ * @return int Returns 0 on success, or 1 on failure (syntax, domain, unbound variables, memory or read errors).
+ *         Errors are fatal.
+ */
+int evaluate_stream_expression(FILE* input, char** variableNames, double* variableValues, int variableCount,
+                               double* result);
+
+
+#endif // STREAM_H
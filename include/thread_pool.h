@@ -0,0 +1,82 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+
+// THREAD POOL module runs data-parallel loops on a fixed set of worker threads. The items of a loop are cut into
+// chunks and every worker starts with an equal, contiguous share of them. A worker that finishes its share steals
+// chunks from the end of the shares of the workers still busy, so a slow chunk (or a core shared with another
+// process) does not leave the others idle. The thread that starts a loop works as worker 0 until the loop is done.
+
+
+// Function called by the workers for each chunk of a loop: `itemCount` items starting at `firstItem`, run by worker
+// `worker` (0 to workerCount - 1, a worker never runs two chunks at once). Returns 0 upon success, any other value
+// makes run_threadPool return 1 (the other chunks still run).
+typedef int (*ThreadPoolTask)(void* context, int worker, size_t firstItem, size_t itemCount);
+
+
+// Structure for one worker. `chunks` holds the chunks of its share not taken yet, the index of the first one in the
+// low 32 bits and the index after the last one in the high 32 bits: the worker takes chunks from the front and
+// thieves take them from the back, each with one compare-and-swap.
+typedef struct ThreadPoolWorker {
+    atomic_ullong chunks;
+    pthread_t thread;
+    struct ThreadPool* threadPool;
+    int index;
+} ThreadPoolWorker;
+
+
+// Structure for a thread pool. Includes the lock and conditions the threads wait on between loops, the workers
+// (`workers[0]` is the calling thread, it has no thread of its own), and the loop being run: its task, context,
+// item and chunk counts, a generation counter bumped for each loop, the number of threads still working on it, and
+// whether one of its tasks failed.
+typedef struct ThreadPool {
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    ThreadPoolWorker* workers;
+    int workerCount;
+    ThreadPoolTask task;
+    void* context;
+    size_t itemCount;
+    size_t chunkSize;
+    unsigned long long generation;
+    int activeThreads;
+    int stopping;
+    atomic_int failed;
+} ThreadPool;
+
+
+// Initializes `threadPool` with `workerCount` workers (the number of processors when 0 or less), and starts
+// `workerCount - 1` threads. Returns 0 upon success, 1 upon errors. Errors are fatal.
+int init_threadPool(ThreadPool* threadPool, int workerCount);
+
+
+/**
+ * @brief Calls `task` for every chunk of `chunkSize` items (the last one may be shorter) of a loop over `itemCount`
+ *        items, on all the workers of `threadPool`, and returns once every chunk is done.
+ *
+ * @param threadPool A pointer to an initialized ThreadPool. Runs one loop at a time: run_threadPool must not be called
+ *        from two threads at once, nor from inside a task.
+ * @param task The function called for each chunk.
+ * @param context The pointer passed to every call of `task`.
+ * @param itemCount The number of items of the loop.
+ * @param chunkSize The number of items per chunk (raised when the loop would have more than 2^32 - 1 chunks).
+ * @return int Returns 0 on success, or 1 on invalid parameters or if a call of `task` failed. Errors are fatal.
+ */
+int run_threadPool(ThreadPool* threadPool, ThreadPoolTask task, void* context, size_t itemCount, size_t chunkSize);
+
+
+/*
+ * - Stops and joins the threads of the ThreadPool, and frees its workers.
+ * - Must not be called while a loop is running.
+ * - The original ThreadPool struct needs not to be freed (it was allocated onto the stack).
+ * - Returns 0 upon success, 1 upon errors.
+ */
+int free_threadPool_memory(ThreadPool* threadPool);
+
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,13 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+
+// TIMER module reads a monotonic clock (clock_gettime on POSIX systems, QueryPerformanceCounter on Windows) for
+// timing code. Readings only make sense relative to each other: subtract two of them to get the elapsed time.
+
+
+// Returns the current reading of the monotonic clock in nanoseconds.
+unsigned long long get_timer_nanoseconds(void);
+
+
+#endif // TIMER_H
@@ -0,0 +1,94 @@
+#ifndef VM_H
+#define VM_H
+
+#include "graph.h"
+
+
+// VM module translates an expression graph (GRAPH module) into bytecode for a register machine, the interpreter used
+// by compiled expressions when there is no native code (see the JIT module). Each instruction is three-address: it
+// reads its operands from registers and writes its result into a register, and registers are reused once the value
+// they hold is no longer needed, so an evaluation touches a handful of doubles instead of one per graph node.
+
+// Constants are folded into the instructions using them (`x * 2` is one instruction), and a multiplication used only
+// by an addition or subtraction is fused into it (`a*b + c` is one instruction, computed with the same two roundings
+// as before). With GCC and Clang, instructions are dispatched by jumping from one to the next through a table of
+// label addresses (computed goto) instead of returning to a switch. Results and error messages are those of
+// evaluate_expressionGraph.
+
+
+// Enumeration for the opcodes. `d` is the destination register, `a`, `b`, `c` the operand registers (operands[0..2])
+// and `k` the constant of the instruction.
+typedef enum {
+    VM_CONSTANT,              // d = k
+    VM_VARIABLE,              // d = variableValues[operands[0]]
+    VM_ADD,                   // d = a + b
+    VM_SUBTRACT,              // d = a - b
+    VM_MULTIPLY,              // d = a * b
+    VM_DIVIDE,                // d = a / b
+    VM_ADD_CONSTANT,          // d = a + k (also a - k, as a + -k)
+    VM_CONSTANT_SUBTRACT,     // d = k - a
+    VM_MULTIPLY_CONSTANT,     // d = a * k
+    VM_DIVIDE_CONSTANT,       // d = a / k, k is not zero
+    VM_CONSTANT_DIVIDE,       // d = k / a
+    VM_MULTIPLY_ADD,          // d = a * b + c
+    VM_MULTIPLY_SUBTRACT,     // d = a * b - c
+    VM_SUBTRACT_MULTIPLY,     // d = c - a * b
+    VM_MULTIPLY_ADD_CONSTANT, // d = a * b + k
+    VM_MULTIPLY_CONSTANT_ADD, // d = a * k + b
+    VM_FUNCTION,              // d = typeFunction(a)
+    VM_SINCOS,                // d = sin(a), b = cos(a)
+    VM_NEGATE,                // d = -a (only emitted by the PRATT module)
+    VM_POWER,                 // d = a ^ b (only emitted by the PRATT module)
+    VM_RETURN,                // result = a
+
+    VM_OPCODE_COUNT
+} TypeVmOpcode;
+
+
+// Structure for an instruction, see TypeVmOpcode.
+typedef struct VmInstruction {
+    double constant;
+    int destination;
+    int operands[3];
+    unsigned char opcode;
+    unsigned char typeFunction;
+} VmInstruction;
+
+
+// Structure for a bytecode program. Includes the instructions (the last one is VM_RETURN), their number, the number
+// of registers an evaluation needs, whether the program reads any variable, and the table of variable names
+// (borrowed from the graph, used for error messages, may be NULL).
+typedef struct VmProgram {
+    VmInstruction* instructions;
+    int instructionCount;
+    int registerCount;
+    int hasVariables;
+    char** variableNames;
+} VmProgram;
+
+
+/**
+ * @brief Translates `expressionGraph` into a bytecode program.
+ *
+ * @param expressionGraph A pointer to the ExpressionGraph to translate. It may be freed afterwards.
+ * @param vmProgram A pointer to the VmProgram struct to fill out.
+ * @return int Returns 0 on success, or 1 on failure (memory allocation). Errors are fatal.
+ */
+int compile_vmProgram(ExpressionGraph* expressionGraph, VmProgram* vmProgram);
+
+
+// Evaluates `vmProgram` with `variableValues[slot]` as the value of each variable, writes answer to `result`.
+// `registers` is caller-provided scratch space for `registerCount` doubles (never more than the graph had nodes).
+// Returns 0 upon success, 1 upon errors (domain errors, missing variable values). Errors are fatal.
+int evaluate_vmProgram(VmProgram* vmProgram, double* variableValues, double* registers, double* result);
+
+
+/*
+ * - Frees the instructions of the VmProgram.
+ * - The original VmProgram struct needs not to be freed (it was allocated onto the stack).
+ * - Returns 0 upon success, 1 upon errors.
+ */
+int free_vmProgram_memory(VmProgram* vmProgram);
+
+
+#endif // VM_H
@@ -0,0 +1,452 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#include "errors.h"
+#include "lex.h"
+#include "operations.h"
+#include "statistics.h"
+#include "graph.h"
+#include "expression.h"
+#include "vector_math.h"
+#include "thread_pool.h"
+#include "batch.h"
+
+
+// Block buffers are processed as vectors of 8 doubles (one AVX-512 register, two AVX2 or four SSE2 registers)
+typedef double BatchVector __attribute__((vector_size(64)));
+typedef long long BatchMask __attribute__((vector_size(64)));
+#define VECTORS_PER_BLOCK (BATCH_BLOCK_ROWS * (int)sizeof(double) / (int)sizeof(BatchVector))
+
+// One copy of evaluate_block is compiled per instruction set, the loader picks the best one for the CPU
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__)
+#define BATCH_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define BATCH_TARGET_CLONES
+#endif
+
+
+int build_batchProgram(ExpressionGraph* expressionGraph, BatchProgram* batchProgram) {
+
+    // Validating function parameters
+    if (expressionGraph == NULL || expressionGraph->nodes == NULL || batchProgram == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    int nodeCount = expressionGraph->nodeCount;
+    batchProgram->instructions = malloc(nodeCount * sizeof(BatchInstruction));
+    batchProgram->instructionCount = 0;
+    batchProgram->bufferCount = 0;
+    batchProgram->useVectorMath = 1;
+    int* lastUse = malloc(nodeCount * sizeof(int));
+    int* bufferOfNode = malloc(nodeCount * sizeof(int));
+    int* freeBuffers = malloc(nodeCount * sizeof(int));
+    if (batchProgram->instructions == NULL || lastUse == NULL || bufferOfNode == NULL || freeBuffers == NULL) {
+        free(batchProgram->instructions);
+        batchProgram->instructions = NULL;
+        free(lastUse);
+        free(bufferOfNode);
+        free(freeBuffers);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(nodeCount * sizeof(BatchInstruction));
+    count_statistics_allocation(3 * nodeCount * sizeof(int));
+    int freeBufferCount = 0;
+
+    // Find the last instruction reading the value of each node, its buffer can be reused after that. The second node
+    // of a fused sin/cos pair reads its argument in the instruction of the first one
+    for (int i = 0; i < nodeCount; i++) {
+        lastUse[i] = -1;
+        bufferOfNode[i] = -1;
+    }
+    for (int i = 0; i < nodeCount; i++) {
+        GraphNode* node = &expressionGraph->nodes[i];
+        if (node->typeToken == TOKEN_NUMBER || node->typeToken == TOKEN_VARIABLE) {
+            continue;
+        }
+        int reader = (node->sincosPartner != -1 && node->sincosPartner < i) ? node->sincosPartner : i;
+        for (int j = 0; j < 2 && node->operands[j] != -1; j++) {
+            if (lastUse[node->operands[j]] < reader) {
+                lastUse[node->operands[j]] = reader;
+            }
+        }
+    }
+    lastUse[expressionGraph->root] = nodeCount;
+
+    for (int i = 0; i < nodeCount; i++) {
+
+        // The second node of a fused sin/cos pair was written by the first one
+        GraphNode* node = &expressionGraph->nodes[i];
+        if (bufferOfNode[i] != -1) {
+            continue;
+        }
+
+        BatchInstruction* instruction = &batchProgram->instructions[batchProgram->instructionCount++];
+        instruction->value = node->value;
+        instruction->typeToken = node->typeToken;
+        instruction->typeFunction = node->typeFunction;
+        instruction->operands[0] = node->operands[0];
+        instruction->operands[1] = -1;
+        instruction->secondDestination = -1;
+
+        // Read the operands, and give back the buffers this is the last reader of (the result may be written in place)
+        int partner = node->sincosPartner;
+        if (node->typeToken != TOKEN_NUMBER && node->typeToken != TOKEN_VARIABLE) {
+            for (int j = 0; j < 2 && node->operands[j] != -1; j++) {
+                instruction->operands[j] = bufferOfNode[node->operands[j]];
+            }
+            for (int j = 0; j < 2 && node->operands[j] != -1; j++) {
+                int operand = node->operands[j];
+                if (lastUse[operand] == i && (j == 0 || operand != node->operands[0])) {
+                    freeBuffers[freeBufferCount++] = bufferOfNode[operand];
+                }
+            }
+        }
+
+        // Destination buffers, for the fused partner as well
+        int destinationCount = partner != -1 ? 2 : 1;
+        for (int j = 0; j < destinationCount; j++) {
+            int buffer = freeBufferCount > 0 ? freeBuffers[--freeBufferCount] : batchProgram->bufferCount++;
+            if (j == 0) {
+                bufferOfNode[i] = buffer;
+                instruction->destination = buffer;
+            }
+            else {
+                bufferOfNode[node->sincosPartner] = buffer;
+                instruction->secondDestination = buffer;
+            }
+        }
+        // Fused pairs are stored as a sin instruction, with the cosine in the second destination
+        if (node->sincosPartner != -1 && node->typeFunction == FUNCTION_COS) {
+            instruction->typeFunction = FUNCTION_SIN;
+            instruction->destination = bufferOfNode[node->sincosPartner];
+            instruction->secondDestination = bufferOfNode[i];
+        }
+
+        // A value nobody reads (never the case for graphs built from RPN) would hold its buffer forever
+        if (lastUse[i] == -1) {
+            freeBuffers[freeBufferCount++] = bufferOfNode[i];
+        }
+        if (partner != -1 && lastUse[partner] == -1) {
+            freeBuffers[freeBufferCount++] = bufferOfNode[partner];
+        }
+    }
+
+    batchProgram->resultBuffer = bufferOfNode[expressionGraph->root];
+
+    free(lastUse);
+    free(bufferOfNode);
+    free(freeBuffers);
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+size_t get_batchProgram_scratchSize(BatchProgram* batchProgram) {
+    if (batchProgram == NULL) {
+        return 0;
+    }
+    // The block buffers, then one error mask per row of a block
+    return ((size_t)batchProgram->bufferCount + 1) * BATCH_BLOCK_ROWS * sizeof(double);
+}
+
+
+// Evaluates every instruction of `batchProgram` over one block of rows starting at row `firstRow` (`rowCount` rows, the
+// rest of the block is padding). Marks the rows with domain errors in `rowErrors` (all bits set).
+BATCH_TARGET_CLONES
+static void evaluate_block(BatchProgram* batchProgram, const double* const* columns, size_t firstRow, int rowCount,
+                           double* buffers, long long* rowErrors) {
+
+    BatchMask* errors = (BatchMask*)rowErrors;
+
+    for (int i = 0; i < batchProgram->instructionCount; i++) {
+
+        BatchInstruction* instruction = &batchProgram->instructions[i];
+        double* destination = buffers + (size_t)instruction->destination * BATCH_BLOCK_ROWS;
+        BatchVector* d = (BatchVector*)destination;
+        BatchVector* a = (BatchVector*)(buffers + (size_t)instruction->operands[0] * BATCH_BLOCK_ROWS);
+        BatchVector* b = (BatchVector*)(buffers + (size_t)instruction->operands[1] * BATCH_BLOCK_ROWS);
+
+        switch (instruction->typeToken) {
+            case TOKEN_NUMBER: {
+                // Lane by lane, adding the constant to a zero vector would turn -0.0 into 0.0
+                BatchVector constant = {0};
+                for (int lane = 0; lane < (int)(sizeof(BatchVector) / sizeof(double)); lane++) {
+                    constant[lane] = instruction->value;
+                }
+                for (int v = 0; v < VECTORS_PER_BLOCK; v++) {
+                    d[v] = constant;
+                }
+                break;
+            }
+            case TOKEN_VARIABLE:
+                memcpy(destination, columns[instruction->operands[0]] + firstRow, rowCount * sizeof(double));
+                memset(destination + rowCount, 0, (BATCH_BLOCK_ROWS - rowCount) * sizeof(double));
+                break;
+            case TOKEN_OPERATOR_PLUS:
+                for (int v = 0; v < VECTORS_PER_BLOCK; v++) {
+                    d[v] = a[v] + b[v];
+                }
+                break;
+            case TOKEN_OPERATOR_MINUS:
+                for (int v = 0; v < VECTORS_PER_BLOCK; v++) {
+                    d[v] = a[v] - b[v];
+                }
+                break;
+            case TOKEN_OPERATOR_MULTIPLY:
+                for (int v = 0; v < VECTORS_PER_BLOCK; v++) {
+                    d[v] = a[v] * b[v];
+                }
+                break;
+            case TOKEN_OPERATOR_DIVIDE:
+                for (int v = 0; v < VECTORS_PER_BLOCK; v++) {
+                    errors[v] |= b[v] == 0.0;
+                    d[v] = a[v] / b[v];
+                }
+                break;
+            case TOKEN_FUNCTION: {
+                double* x = (double*)a;
+                if (instruction->secondDestination != -1) {
+                    double* cosDestination = buffers + (size_t)instruction->secondDestination * BATCH_BLOCK_ROWS;
+                    if (batchProgram->useVectorMath) {
+                        vector_apply_sincos(x, destination, cosDestination, BATCH_BLOCK_ROWS);
+                        break;
+                    }
+                    for (int r = 0; r < BATCH_BLOCK_ROWS; r++) {
+                        apply_sincos(x[r], &destination[r], &cosDestination[r]);
+                    }
+                    break;
+                }
+                if (batchProgram->useVectorMath) {
+                    vector_apply_function(instruction->typeFunction, x, destination, rowErrors, BATCH_BLOCK_ROWS);
+                    break;
+                }
+                for (int r = 0; r < BATCH_BLOCK_ROWS; r++) {
+                    if (apply_function(instruction->typeFunction, x[r], &destination[r]) != DOMAIN_VALID) {
+                        rowErrors[r] = -1;
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+
+// Evaluates `batchProgram` over the rows `firstRow` to `endRow - 1` of `columns` into the same rows of `results`,
+// using `scratch` for the block buffers. Returns the number of rows with domain errors.
+static size_t evaluate_rows(BatchProgram* batchProgram, const double* const* columns, double* results, size_t firstRow,
+                            size_t endRow, void* scratch) {
+
+    double* buffers = scratch;
+    long long* rowErrors = (long long*)(buffers + (size_t)batchProgram->bufferCount * BATCH_BLOCK_ROWS);
+    double* resultBuffer = buffers + (size_t)batchProgram->resultBuffer * BATCH_BLOCK_ROWS;
+    size_t failed = 0;
+
+    for (size_t blockRow = firstRow; blockRow < endRow; blockRow += BATCH_BLOCK_ROWS) {
+        int blockRows = endRow - blockRow < BATCH_BLOCK_ROWS ? (int)(endRow - blockRow) : BATCH_BLOCK_ROWS;
+
+        memset(rowErrors, 0, BATCH_BLOCK_ROWS * sizeof(long long));
+        evaluate_block(batchProgram, columns, blockRow, blockRows, buffers, rowErrors);
+
+        memcpy(results + blockRow, resultBuffer, blockRows * sizeof(double));
+        for (int r = 0; r < blockRows; r++) {
+            if (rowErrors[r] != 0) {
+                results[blockRow + r] = NAN;
+                failed++;
+            }
+        }
+    }
+
+    return failed;
+}
+
+
+int evaluate_batchProgram(BatchProgram* batchProgram, const double* const* columns, double* results, size_t rowCount,
+                          void* scratch, size_t* failedRows) {
+
+    // Validating function parameters
+    if (batchProgram == NULL || batchProgram->instructions == NULL || results == NULL || scratch == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    size_t failed = evaluate_rows(batchProgram, columns, results, 0, rowCount, scratch);
+    if (failedRows != NULL) {
+        *failedRows = failed;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// Structure for the context of the tasks of evaluate_batchProgram_parallel: the program and its input and output
+// arrays, the scratch space of each worker, and the number of rows with domain errors found so far.
+typedef struct BatchParallelContext {
+    BatchProgram* batchProgram;
+    const double* const* columns;
+    double* results;
+    void** scratch;
+    atomic_size_t failed;
+} BatchParallelContext;
+
+
+// ThreadPoolTask evaluating the rows `firstRow` to `firstRow + rowCount - 1` with the scratch space of `worker`.
+static int evaluate_rows_task(void* context, int worker, size_t firstRow, size_t rowCount) {
+
+    BatchParallelContext* parallelContext = context;
+    size_t failed = evaluate_rows(parallelContext->batchProgram, parallelContext->columns, parallelContext->results,
+                                  firstRow, firstRow + rowCount, parallelContext->scratch[worker]);
+    if (failed > 0) {
+        atomic_fetch_add_explicit(&parallelContext->failed, failed, memory_order_relaxed);
+    }
+
+    return 0;
+}
+
+
+int evaluate_batchProgram_parallel(ThreadPool* threadPool, BatchProgram* batchProgram, const double* const* columns,
+                                   double* results, size_t rowCount, void** scratch, size_t* failedRows) {
+
+    // Validating function parameters
+    if (threadPool == NULL || batchProgram == NULL || batchProgram->instructions == NULL || results == NULL ||
+        scratch == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    BatchParallelContext parallelContext;
+    parallelContext.batchProgram = batchProgram;
+    parallelContext.columns = columns;
+    parallelContext.results = results;
+    parallelContext.scratch = scratch;
+    atomic_init(&parallelContext.failed, 0);
+
+    if (run_threadPool(threadPool, evaluate_rows_task, &parallelContext, rowCount, BATCH_PARALLEL_CHUNK_ROWS) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (failedRows != NULL) {
+        *failedRows = atomic_load_explicit(&parallelContext.failed, memory_order_relaxed);
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int free_batchProgram_memory(BatchProgram* batchProgram) {
+
+    // Validating function parameters
+    if (batchProgram == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    free(batchProgram->instructions);
+    batchProgram->instructions = NULL;
+    batchProgram->instructionCount = 0;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+void* allocate_batchScratch(size_t size) {
+    // Round up to the alignment, as aligned_alloc requires
+    size = (size + 63) / 64 * 64;
+#if defined(_WIN32)
+    void* scratch = _aligned_malloc(size, 64);
+#else
+    void* scratch = aligned_alloc(64, size);
+#endif
+    if (scratch != NULL) {
+        count_statistics_allocation(size);
+    }
+    return scratch;
+}
+
+
+void free_batchScratch_memory(void* scratch) {
+#if defined(_WIN32)
+    _aligned_free(scratch);
+#else
+    free(scratch);
+#endif
+}
+
+
+int evaluate_compiledExpression_batch(CompiledExpression* compiledExpression, const double* const* columns,
+                                      double* results, size_t rowCount, size_t* failedRows) {
+
+    // Validating function parameters
+    if (compiledExpression == NULL || compiledExpression->graph.nodes == NULL || results == NULL ||
+        (columns == NULL && compiledExpression->variableCount > 0)) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    BatchProgram batchProgram;
+    if (build_batchProgram(&compiledExpression->graph, &batchProgram) != 0) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    void* scratch = allocate_batchScratch(get_batchProgram_scratchSize(&batchProgram));
+    if (scratch == NULL) {
+        free_batchProgram_memory(&batchProgram);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    int evaluate = evaluate_batchProgram(&batchProgram, columns, results, rowCount, scratch, failedRows);
+
+    free_batchScratch_memory(scratch);
+    free_batchProgram_memory(&batchProgram);
+
+    return evaluate;
+}
+
+
+int evaluate_compiledExpression_parallel(ThreadPool* threadPool, CompiledExpression* compiledExpression,
+                                         const double* const* columns, double* results, size_t rowCount,
+                                         size_t* failedRows) {
+
+    // Validating function parameters
+    if (threadPool == NULL || compiledExpression == NULL || compiledExpression->graph.nodes == NULL ||
+        results == NULL || (columns == NULL && compiledExpression->variableCount > 0)) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // One program shared by the workers, one scratch space per worker
+    BatchProgram batchProgram;
+    if (build_batchProgram(&compiledExpression->graph, &batchProgram) != 0) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    void** scratch = calloc(threadPool->workerCount, sizeof(void*));
+    int status = scratch == NULL ? ERROR_MEMORY_ALLOCATION_FAILURE : 0;
+    if (scratch != NULL) {
+        count_statistics_allocation(threadPool->workerCount * sizeof(void*));
+    }
+    for (int i = 0; status == 0 && i < threadPool->workerCount; i++) {
+        scratch[i] = allocate_batchScratch(get_batchProgram_scratchSize(&batchProgram));
+        if (scratch[i] == NULL) {
+            status = ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+    }
+
+    if (status == 0) {
+        status = evaluate_batchProgram_parallel(threadPool, &batchProgram, columns, results, rowCount, scratch,
+                                                failedRows);
+    }
+
+    if (scratch != NULL) {
+        for (int i = 0; i < threadPool->workerCount; i++) {
+            if (scratch[i] != NULL) {
+                free_batchScratch_memory(scratch[i]);
+            }
+        }
+        free(scratch);
+    }
+    free_batchProgram_memory(&batchProgram);
+
+    return status;
+}
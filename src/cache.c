@@ -0,0 +1,335 @@
+#define _POSIX_C_SOURCE 200809L  // For pthread_rwlock_t under strict C11
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "errors.h"
+#include "statistics.h"
+#include "expression.h"
+#include "cache.h"
+
+
+// Returns 1 if `value` ends the token before it whatever precedes it (an operator or a parenthesis), 0 otherwise.
+static int is_separator(char value) {
+    return (value == '+' || value == '-' || value == '*' || value == '/' || value == '(' || value == ')');
+}
+
+
+// Writes the normalized key of `sourceString` into `key` (which has room for the whole source string) and returns
+// its hash. A run of spaces is dropped when it is at either end of the string, follows an operator or a parenthesis,
+// or comes before one that could not be part of the token before it. Any other run is kept as one space: it ends a
+// token in a place where the lexer treats a space differently (e.g. `2E +2` or `sin (x)` are syntax errors).
+static unsigned int normalize_key(char* sourceString, char* key) {
+
+    unsigned int hash = 2166136261u;  // FNV-1a
+    int length = 0;
+
+    for (char* traverser = sourceString; *traverser != '\0'; traverser++) {
+        if (*traverser == ' ') {
+            char* next = traverser;
+            while (*next == ' ') {
+                next++;
+            }
+            char previous = length > 0 ? key[length-1] : '\0';
+            int droppable = previous == '\0' || *next == '\0' || is_separator(previous) ||
+                            *next == ')' || *next == '*' || *next == '/' ||
+                            ((*next == '+' || *next == '-') && previous != 'E');
+            traverser = next - 1;
+            if (droppable) {
+                continue;
+            }
+        }
+        key[length++] = *traverser;
+        hash = (hash ^ (unsigned char)*traverser) * 16777619u;
+    }
+    key[length] = '\0';
+
+    return hash;
+}
+
+
+// Returns the slot of the entry of `expressionCache` with the normalized key `key`, -1 if there is none.
+// The caller must hold the lock.
+static int find_entry(ExpressionCache* expressionCache, char* key, unsigned int hash) {
+
+    int slot = expressionCache->buckets[hash & expressionCache->bucketMask];
+    while (slot != -1) {
+        CachedExpression* entry = expressionCache->entries[slot];
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            return slot;
+        }
+        slot = entry->next;
+    }
+    return -1;
+}
+
+
+// Frees a CachedExpression, its key and its compiled expression.
+static void free_entry(CachedExpression* entry) {
+    free_compiledExpression_memory(&entry->compiledExpression);
+    free(entry->key);
+    free(entry);
+}
+
+
+// Removes the entry in `slot` from its hash chain and frees it. The caller must hold the write lock.
+static void remove_entry(ExpressionCache* expressionCache, int slot) {
+
+    CachedExpression* entry = expressionCache->entries[slot];
+    int* link = &expressionCache->buckets[entry->hash & expressionCache->bucketMask];
+    while (*link != slot) {
+        link = &expressionCache->entries[*link]->next;
+    }
+    *link = entry->next;
+
+    expressionCache->entries[slot] = NULL;
+    expressionCache->count--;
+    free_entry(entry);
+}
+
+
+// Returns an empty slot of `expressionCache`, evicting the first entry the CLOCK hand finds that is not held by a
+// caller and was not used since the hand last passed it. Returns -1 if every entry is held.
+// The caller must hold the write lock.
+static int find_free_slot(ExpressionCache* expressionCache) {
+
+    if (expressionCache->count < expressionCache->capacity) {
+        for (int i = 0; i < expressionCache->capacity; i++) {
+            if (expressionCache->entries[i] == NULL) {
+                return i;
+            }
+        }
+    }
+
+    // Two turns of the hand: the first one may only clear the CLOCK bits
+    for (int i = 0; i < 2 * expressionCache->capacity; i++) {
+        int slot = expressionCache->clockHand;
+        expressionCache->clockHand = (expressionCache->clockHand + 1) % expressionCache->capacity;
+
+        CachedExpression* entry = expressionCache->entries[slot];
+        if (atomic_load(&entry->referenceCount) > 0) {
+            continue;
+        }
+        if (atomic_exchange_explicit(&entry->referenced, 0, memory_order_relaxed) != 0) {
+            continue;
+        }
+
+        remove_entry(expressionCache, slot);
+        atomic_fetch_add_explicit(&expressionCache->evictions, 1, memory_order_relaxed);
+        return slot;
+    }
+
+    return -1;
+}
+
+
+int init_expressionCache(ExpressionCache* expressionCache, int capacity) {
+
+    // Validating function parameters
+    if (expressionCache == NULL || capacity < 1) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Power of two number of buckets, at least one per entry
+    int bucketCount = 1;
+    while (bucketCount < capacity) {
+        bucketCount *= 2;
+    }
+
+    expressionCache->entries = calloc(capacity, sizeof(CachedExpression*));
+    expressionCache->buckets = malloc(bucketCount * sizeof(int));
+    if (expressionCache->entries == NULL || expressionCache->buckets == NULL) {
+        free(expressionCache->entries);
+        free(expressionCache->buckets);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(capacity * sizeof(CachedExpression*));
+    count_statistics_allocation(bucketCount * sizeof(int));
+    memset(expressionCache->buckets, -1, bucketCount * sizeof(int));
+
+    if (pthread_rwlock_init(&expressionCache->lock, NULL) != 0) {
+        free(expressionCache->entries);
+        free(expressionCache->buckets);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    expressionCache->bucketMask = bucketCount - 1;
+    expressionCache->capacity = capacity;
+    expressionCache->count = 0;
+    expressionCache->clockHand = 0;
+    atomic_init(&expressionCache->hits, 0);
+    atomic_init(&expressionCache->misses, 0);
+    atomic_init(&expressionCache->evictions, 0);
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int acquire_cachedExpression(ExpressionCache* expressionCache, char* sourceString, CachedExpression** cachedExpression) {
+
+    // Validating function parameters
+    if (expressionCache == NULL || expressionCache->entries == NULL || sourceString == NULL || cachedExpression == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    char* key = malloc(strlen(sourceString) + 1);
+    if (key == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(strlen(sourceString) + 1);
+    unsigned int hash = normalize_key(sourceString, key);
+
+    // Fast path, under the shared lock: the reference is taken before the lock is released so the entry cannot be
+    // evicted in between
+    pthread_rwlock_rdlock(&expressionCache->lock);
+    int slot = find_entry(expressionCache, key, hash);
+    if (slot != -1) {
+        CachedExpression* entry = expressionCache->entries[slot];
+        atomic_fetch_add(&entry->referenceCount, 1);
+        atomic_store_explicit(&entry->referenced, 1, memory_order_relaxed);
+        pthread_rwlock_unlock(&expressionCache->lock);
+
+        atomic_fetch_add_explicit(&expressionCache->hits, 1, memory_order_relaxed);
+        free(key);
+        *cachedExpression = entry;
+        return 0;
+    }
+    pthread_rwlock_unlock(&expressionCache->lock);
+    atomic_fetch_add_explicit(&expressionCache->misses, 1, memory_order_relaxed);
+
+    // Miss: compile without holding the lock (error messages refer to the original string)
+    CachedExpression* entry = malloc(sizeof(CachedExpression));
+    if (entry == NULL) {
+        free(key);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(sizeof(CachedExpression));
+    if (compile_expression(sourceString, &entry->compiledExpression) != 0) {
+        free(entry);
+        free(key);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    entry->key = key;
+    entry->hash = hash;
+    entry->next = -1;
+    atomic_init(&entry->referenceCount, 1);
+    atomic_init(&entry->referenced, 1);
+    entry->cached = 0;
+
+    // Insert under the exclusive lock, unless another thread inserted the same expression in the meantime
+    pthread_rwlock_wrlock(&expressionCache->lock);
+    slot = find_entry(expressionCache, key, hash);
+    if (slot != -1) {
+        CachedExpression* existingEntry = expressionCache->entries[slot];
+        atomic_fetch_add(&existingEntry->referenceCount, 1);
+        atomic_store_explicit(&existingEntry->referenced, 1, memory_order_relaxed);
+        pthread_rwlock_unlock(&expressionCache->lock);
+
+        free_entry(entry);
+        *cachedExpression = existingEntry;
+        return 0;
+    }
+
+    // If every entry is held, the new one is handed out without being cached (freed when released)
+    slot = find_free_slot(expressionCache);
+    if (slot != -1) {
+        int* bucket = &expressionCache->buckets[hash & expressionCache->bucketMask];
+        entry->next = *bucket;
+        entry->cached = 1;
+        *bucket = slot;
+        expressionCache->entries[slot] = entry;
+        expressionCache->count++;
+    }
+    pthread_rwlock_unlock(&expressionCache->lock);
+
+    *cachedExpression = entry;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int release_cachedExpression(ExpressionCache* expressionCache, CachedExpression* cachedExpression) {
+
+    // Validating function parameters
+    if (expressionCache == NULL || cachedExpression == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // `cached` does not change while the entry is held. Cached entries are freed by the cache, once no longer held.
+    int cached = cachedExpression->cached;
+    if (atomic_fetch_sub(&cachedExpression->referenceCount, 1) == 1 && !cached) {
+        free_entry(cachedExpression);
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int evaluate_cachedExpression(ExpressionCache* expressionCache, char* sourceString, double* variableValues,
+                              double* result) {
+
+    // Validating function parameters
+    if (expressionCache == NULL || sourceString == NULL || result == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    CachedExpression* cachedExpression;
+    if (acquire_cachedExpression(expressionCache, sourceString, &cachedExpression) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    int evaluate = evaluate_compiledExpression(&cachedExpression->compiledExpression, variableValues, result);
+    release_cachedExpression(expressionCache, cachedExpression);
+
+    return evaluate;
+}
+
+
+int get_expressionCache_statistics(ExpressionCache* expressionCache, CacheStatistics* cacheStatistics) {
+
+    // Validating function parameters
+    if (expressionCache == NULL || cacheStatistics == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    cacheStatistics->hits = atomic_load_explicit(&expressionCache->hits, memory_order_relaxed);
+    cacheStatistics->misses = atomic_load_explicit(&expressionCache->misses, memory_order_relaxed);
+    cacheStatistics->evictions = atomic_load_explicit(&expressionCache->evictions, memory_order_relaxed);
+
+    pthread_rwlock_rdlock(&expressionCache->lock);
+    cacheStatistics->count = expressionCache->count;
+    cacheStatistics->capacity = expressionCache->capacity;
+    pthread_rwlock_unlock(&expressionCache->lock);
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int free_expressionCache_memory(ExpressionCache* expressionCache) {
+
+    // Validating function parameters
+    if (expressionCache == NULL || expressionCache->entries == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    for (int i = 0; i < expressionCache->capacity; i++) {
+        if (expressionCache->entries[i] != NULL) {
+            free_entry(expressionCache->entries[i]);
+        }
+    }
+    free(expressionCache->entries);
+    free(expressionCache->buckets);
+    expressionCache->entries = NULL;
+    expressionCache->buckets = NULL;
+    expressionCache->count = 0;
+    pthread_rwlock_destroy(&expressionCache->lock);
+
+    // Subroutine ran successfully
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+
+#include "errors.h"
+
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+
+// The ErrorReport errors of the calling thread are captured into, NULL while they are printed
+static THREAD_LOCAL ErrorReport* capturedErrors = NULL;
+
+
+ErrorReport* capture_errors(ErrorReport* errorReport) {
+
+    ErrorReport* previous = capturedErrors;
+    if (errorReport != NULL) {
+        errorReport->code = ERROR_CODE_NONE;
+        errorReport->position = -1;
+        errorReport->length = 0;
+        errorReport->message[0] = '\0';
+    }
+    capturedErrors = errorReport;
+
+    return previous;
+}
+
+
+void report_error(TypeErrorCode errorCode, int position, int length, const char* format, ...) {
+
+    va_list arguments;
+    va_start(arguments, format);
+
+    ErrorReport* errorReport = capturedErrors;
+    if (errorReport == NULL) {
+        vfprintf(stderr, format, arguments);
+    }
+    else if (errorReport->code == ERROR_CODE_NONE) {
+        errorReport->code = errorCode;
+        errorReport->position = position;
+        errorReport->length = length;
+
+        // Keep the message itself: no blank lines, no "Error: " prefix, no trailing newlines
+        char message[ERROR_MESSAGE_SIZE + 16];
+        vsnprintf(message, sizeof(message), format, arguments);
+        char* start = message + strspn(message, "\n");
+        if (strncmp(start, "Error: ", 7) == 0) {
+            start += 7;
+        }
+        size_t messageLength = strcspn(start, "\n");
+        if (messageLength >= ERROR_MESSAGE_SIZE) {
+            messageLength = ERROR_MESSAGE_SIZE - 1;
+        }
+        memcpy(errorReport->message, start, messageLength);
+        errorReport->message[messageLength] = '\0';
+    }
+
+    va_end(arguments);
+}
+
+
+void shift_error_position(long long offset) {
+
+    ErrorReport* errorReport = capturedErrors;
+    if (errorReport == NULL || errorReport->code == ERROR_CODE_NONE || errorReport->position < 0) {
+        return;
+    }
+    long long position = errorReport->position + offset;
+    errorReport->position = (position <= INT_MAX) ? (int)position : -1;
+}
@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "statistics.h"
+#include "lex.h"
+#include "parser.h"
+#include "optimizer.h"
+#include "graph.h"
+#include "vm.h"
+#include "jit.h"
+#include "expression.h"
+
+
+#define LOCAL_NODE_VALUES 64  // evaluate_compiledExpression allocates no context for up to this many values
+
+
+// Searches the variable table of `compiledExpression` for a name equal to the `length` characters at `name`.
+// Returns the slot index of the variable, or -1 if it is not in the table.
+static int find_variable(CompiledExpression* compiledExpression, char* name, int length) {
+    for (int i = 0; i < compiledExpression->variableCount; i++) {
+        if (strncmp(compiledExpression->variableNames[i], name, length) == 0 &&
+            compiledExpression->variableNames[i][length] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+// Adds the variable called by the `length` characters at `name` to the variable table of `compiledExpression` as a
+// new slot. Returns the new slot index upon success, -1 if memory could not be allocated. Errors are fatal.
+static int add_variable(CompiledExpression* compiledExpression, char* name, int length) {
+
+    // Grow the table by one entry (expressions only have a handful of variables)
+    char** tempNames = realloc(compiledExpression->variableNames, (compiledExpression->variableCount + 1) * sizeof(char*));
+    if (tempNames == NULL) {
+        return -1;
+    }
+    compiledExpression->variableNames = tempNames;
+    count_statistics_allocation((compiledExpression->variableCount + 1) * sizeof(char*));
+
+    // Store a null-terminated copy of the variable name
+    char* nameCopy = malloc(length + 1);
+    if (nameCopy == NULL) {
+        return -1;
+    }
+    count_statistics_allocation(length + 1);
+    memcpy(nameCopy, name, length);
+    nameCopy[length] = '\0';
+
+    compiledExpression->variableNames[compiledExpression->variableCount] = nameCopy;
+    return compiledExpression->variableCount++;
+}
+
+
+// Binds every variable token in the token list of `compiledExpression` to a slot. Slots are assigned in order
+// of first appearance in the source string. Returns 0 upon success, 1 upon errors. Errors are fatal.
+static int bind_variable_slots(CompiledExpression* compiledExpression) {
+
+    TokenList* tokenList = &compiledExpression->tokenList;
+
+    for (int i = 0; i < tokenList->position + 1; i++) {
+        Token* token = &tokenList->array[i];
+        if (token->typeToken != TOKEN_VARIABLE) {
+            continue;
+        }
+
+        char* name = tokenList->sourceString + token->offset;
+        int slot = find_variable(compiledExpression, name, token->length);
+        if (slot == -1) {
+            slot = add_variable(compiledExpression, name, token->length);
+            if (slot == -1) {
+                return ERROR_MEMORY_ALLOCATION_FAILURE;
+            }
+        }
+        token->slot = slot;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int compile_expression(char* sourceString, CompiledExpression* compiledExpression) {
+
+    // Validating function parameters
+    if (sourceString == NULL || compiledExpression == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Start from an empty expression so that free_compiledExpression_memory can always be called on failure
+    compiledExpression->sourceString = NULL;
+    compiledExpression->tokenList.array = NULL;
+    compiledExpression->foldedTokenList.array = NULL;
+    compiledExpression->postfixTokenList.array = NULL;
+    compiledExpression->graph.nodes = NULL;
+    compiledExpression->vm.instructions = NULL;
+    compiledExpression->jit.code = NULL;
+    compiledExpression->jit.function = NULL;
+    compiledExpression->variableNames = NULL;
+    compiledExpression->variableCount = 0;
+
+    // Copy the source string, the tokens point into it for the lifetime of the compiled expression
+    size_t sourceLength = strlen(sourceString);
+    compiledExpression->sourceString = malloc(sourceLength + 1);
+    if (compiledExpression->sourceString == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(sourceLength + 1);
+    memcpy(compiledExpression->sourceString, sourceString, sourceLength + 1);
+
+    // Perform lexical analysis on the copied source string
+    if (init_tokenList(&compiledExpression->tokenList, (int)sourceLength) != 0) {
+        free_compiledExpression_memory(compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (lexical_analyzer(compiledExpression->sourceString, &compiledExpression->tokenList) != 0) {
+        free_compiledExpression_memory(compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // Bind each variable to a slot index
+    if (bind_variable_slots(compiledExpression) != 0) {
+        free_compiledExpression_memory(compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // Parse the token list into RPN
+    if (init_StackTokenList(&compiledExpression->tokenList, &compiledExpression->postfixTokenList) != 0) {
+        free_compiledExpression_memory(compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (shunting_yard_algorithm(&compiledExpression->tokenList, &compiledExpression->postfixTokenList) != 0) {
+        free_compiledExpression_memory(compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // An expression must contain at least one token to be evaluated
+    if (compiledExpression->postfixTokenList.top < 0) {
+        report_error(ERROR_CODE_SYNTAX, -1, 0, "\nError: empty expression.\n");
+        free_compiledExpression_memory(compiledExpression);
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    // Fold the constant subexpressions once, so evaluations only compute what depends on the variables. Folded tokens
+    // are rewritten in a copy of the token list, the lexer's one is kept as it was lexed
+    unsigned long long start = start_statistics_phase();
+    int fold = init_tokenList(&compiledExpression->foldedTokenList, (int)sourceLength);
+    fold = fold != 0 ? fold : copy_tokenList(&compiledExpression->tokenList, &compiledExpression->foldedTokenList);
+    fold = fold != 0 ? fold : fold_constants(&compiledExpression->foldedTokenList,
+                                             &compiledExpression->postfixTokenList);
+    end_statistics_phase(STATISTICS_PHASE_FOLD, start);
+    if (fold != 0) {
+        free_compiledExpression_memory(compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // Build the graph that is evaluated, with repeated subexpressions merged
+    start = start_statistics_phase();
+    int build = build_expressionGraph(&compiledExpression->foldedTokenList, &compiledExpression->postfixTokenList,
+                                      compiledExpression->variableNames, &compiledExpression->graph);
+    end_statistics_phase(STATISTICS_PHASE_GRAPH, start);
+    if (build != 0) {
+        free_compiledExpression_memory(compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // Translate the graph into the bytecode evaluated when there is no native code
+    if (compile_vmProgram(&compiledExpression->graph, &compiledExpression->vm) != 0) {
+        free_compiledExpression_memory(compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int get_variable_slot(CompiledExpression* compiledExpression, char* variableName) {
+
+    // Validating function parameters
+    if (compiledExpression == NULL || variableName == NULL) {
+        return -1;
+    }
+
+    return find_variable(compiledExpression, variableName, strlen(variableName));
+}
+
+
+int enable_jit_compiledExpression(CompiledExpression* compiledExpression) {
+
+    // Validating function parameters
+    if (compiledExpression == NULL || compiledExpression->graph.nodes == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    if (compiledExpression->jit.function != NULL) {
+        return 0;
+    }
+
+    return compile_jitExpression(&compiledExpression->graph, &compiledExpression->jit);
+}
+
+
+int get_compiledExpression_valueCount(CompiledExpression* compiledExpression) {
+
+    // Validating function parameters
+    if (compiledExpression == NULL) {
+        return 0;
+    }
+
+    return compiledExpression->jit.function != NULL ? compiledExpression->graph.nodeCount :
+                                                      compiledExpression->vm.registerCount;
+}
+
+
+int evaluate_compiledExpression_context(CompiledExpression* compiledExpression, double* variableValues,
+                                        DoubleStack* doubleStack, double* result) {
+
+    // Validating function parameters
+    if (compiledExpression == NULL || doubleStack == NULL || doubleStack->array == NULL || result == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // The context holds the value of every node with native code, the registers of the bytecode otherwise (far
+    // fewer). Once it is large enough, evaluations allocate nothing
+    unsigned long long start = start_statistics_phase();
+    int valueCount = get_compiledExpression_valueCount(compiledExpression);
+    if (reserve_doubleStack(doubleStack, valueCount) != 0) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    // Native code when there is some, the bytecode otherwise or when the native code gives up
+    int evaluate = 1;
+    if (compiledExpression->jit.function != NULL) {
+        evaluate = evaluate_jitExpression(&compiledExpression->jit, variableValues, doubleStack->array, result);
+    }
+    if (evaluate != 0) {
+        evaluate = evaluate_vmProgram(&compiledExpression->vm, variableValues, doubleStack->array, result);
+    }
+    raise_statistics_peak(STATISTICS_PEAK_VALUE_STACK, valueCount);
+    end_statistics_phase(STATISTICS_PHASE_EVALUATE, start);
+
+    return evaluate;
+}
+
+
+int evaluate_compiledExpression(CompiledExpression* compiledExpression, double* variableValues, double* result) {
+
+    // Validating function parameters
+    if (compiledExpression == NULL || result == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // A context on the stack for all but the largest expressions, which get one for this call
+    double localValues[LOCAL_NODE_VALUES];
+    DoubleStack doubleStack = {.array = localValues, .top = -1, .maxCapacity = LOCAL_NODE_VALUES};
+    int valueCount = get_compiledExpression_valueCount(compiledExpression);
+    if (valueCount > LOCAL_NODE_VALUES && init_doubleStack(&doubleStack, valueCount) != 0) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    int evaluate = evaluate_compiledExpression_context(compiledExpression, variableValues, &doubleStack, result);
+    if (doubleStack.array != localValues) {
+        free_doubleStack_memory(&doubleStack);
+    }
+
+    return evaluate;
+}
+
+
+int free_compiledExpression_memory(CompiledExpression* compiledExpression) {
+
+    // Validating function parameters
+    if (compiledExpression == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Free the native code, the bytecode, the graph and the token lists (postfix list first, it only references the
+    // tokens)
+    if (compiledExpression->jit.code != NULL) {
+        free_jitExpression_memory(&compiledExpression->jit);
+    }
+    if (compiledExpression->vm.instructions != NULL) {
+        free_vmProgram_memory(&compiledExpression->vm);
+    }
+    if (compiledExpression->graph.nodes != NULL) {
+        free_expressionGraph_memory(&compiledExpression->graph);
+    }
+    if (compiledExpression->postfixTokenList.array != NULL) {
+        free_stackTokenList_memory(&compiledExpression->postfixTokenList);
+    }
+    if (compiledExpression->tokenList.array != NULL) {
+        free_tokenList_memory(&compiledExpression->tokenList);
+    }
+    if (compiledExpression->foldedTokenList.array != NULL) {
+        free_tokenList_memory(&compiledExpression->foldedTokenList);
+    }
+
+    // Free the variable names and their table
+    for (int i = 0; i < compiledExpression->variableCount; i++) {
+        free(compiledExpression->variableNames[i]);
+    }
+    free(compiledExpression->variableNames);
+    compiledExpression->variableNames = NULL;
+    compiledExpression->variableCount = 0;
+
+    // Free the copied source string
+    free(compiledExpression->sourceString);
+    compiledExpression->sourceString = NULL;
+
+    // Subroutine ran successfully
+    return 0;
+}
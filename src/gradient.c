@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "errors.h"
+#include "statistics.h"
+#include "lex.h"
+#include "operations.h"
+#include "graph.h"
+#include "expression.h"
+#include "gradient.h"
+
+
+#define LOCAL_DUAL_VALUES 256  // Dual numbers of up to this many doubles in total are kept on the stack
+
+
+int evaluate_expressionGraph_gradient(ExpressionGraph* expressionGraph, double* variableValues, const int* slots,
+                                      int slotCount, double* nodeValues, double* result, double* gradient) {
+
+    // Validating function parameters
+    if (expressionGraph == NULL || expressionGraph->nodes == NULL || slotCount < 0 || nodeValues == NULL ||
+        result == NULL || (gradient == NULL && slotCount > 0)) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // The dual number of node i is its value followed by its derivatives, at nodeValues[i * stride]
+    int stride = slotCount + 1;
+    for (int i = 0; i < expressionGraph->nodeCount; i++) {
+
+        GraphNode* node = &expressionGraph->nodes[i];
+        double* dual = nodeValues + (size_t)i * stride;
+        int operandCount = node->typeToken == TOKEN_FUNCTION ? 1 :
+                           (node->typeToken == TOKEN_NUMBER || node->typeToken == TOKEN_VARIABLE ? 0 : 2);
+        double* a = operandCount > 0 ? nodeValues + (size_t)node->operands[0] * stride : NULL;
+        double* b = operandCount > 1 ? nodeValues + (size_t)node->operands[1] * stride : NULL;
+        double derivative;
+        TypeDomainError domainError;
+
+        switch (node->typeToken) {
+            case TOKEN_NUMBER:
+                dual[0] = node->value;
+                for (int j = 1; j < stride; j++) {
+                    dual[j] = 0.0;
+                }
+                break;
+            case TOKEN_VARIABLE:
+                if (variableValues == NULL) {
+                    if (expressionGraph->variableNames == NULL) {
+                        report_error(ERROR_CODE_UNBOUND_VARIABLE, -1, 0,
+                                     "Error: no value given for the variable in slot %d.\n", node->operands[0]);
+                    }
+                    else {
+                        report_error(ERROR_CODE_UNBOUND_VARIABLE, -1, 0, "Error: no value given for variable '%s'.\n",
+                                     expressionGraph->variableNames[node->operands[0]]);
+                    }
+                    return ERROR_INVALID_PROGRAM_USAGE;
+                }
+                dual[0] = variableValues[node->operands[0]];
+                for (int j = 0; j < slotCount; j++) {
+                    dual[j + 1] = (slots != NULL ? slots[j] : j) == node->operands[0] ? 1.0 : 0.0;
+                }
+                break;
+            case TOKEN_OPERATOR_PLUS:
+                for (int j = 0; j < stride; j++) {
+                    dual[j] = a[j] + b[j];
+                }
+                break;
+            case TOKEN_OPERATOR_MINUS:
+                for (int j = 0; j < stride; j++) {
+                    dual[j] = a[j] - b[j];
+                }
+                break;
+            case TOKEN_OPERATOR_MULTIPLY:
+                // (ab)' = a'b + ab'
+                for (int j = 1; j < stride; j++) {
+                    dual[j] = a[j] * b[0] + a[0] * b[j];
+                }
+                dual[0] = a[0] * b[0];
+                break;
+            case TOKEN_OPERATOR_DIVIDE:
+                // (a/b)' = (a' - (a/b)b') / b
+                if (b[0] == 0) {
+                    print_domain_error(DOMAIN_ERROR_DIVIDE_BY_ZERO, 0.0);
+                    return ERROR_INVALID_PROGRAM_USAGE;
+                }
+                dual[0] = a[0] / b[0];
+                for (int j = 1; j < stride; j++) {
+                    dual[j] = (a[j] - dual[0] * b[j]) / b[0];
+                }
+                break;
+            case TOKEN_FUNCTION:
+                // f(a)' = f'(a) a', sin and cos are each the derivative of the other
+                if (node->typeFunction == FUNCTION_SIN || node->typeFunction == FUNCTION_COS) {
+                    double sinValue, cosValue;
+                    apply_sincos(a[0], &sinValue, &cosValue);
+                    dual[0] = node->typeFunction == FUNCTION_SIN ? sinValue : cosValue;
+                    derivative = node->typeFunction == FUNCTION_SIN ? cosValue : -sinValue;
+                }
+                else {
+                    domainError = apply_function(node->typeFunction, a[0], &dual[0]);
+                    if (domainError != DOMAIN_VALID) {
+                        print_domain_error(domainError, a[0]);
+                        return ERROR_INVALID_PROGRAM_USAGE;
+                    }
+                    derivative = derive_function(node->typeFunction, a[0], dual[0]);
+                }
+                for (int j = 1; j < stride; j++) {
+                    dual[j] = derivative * a[j];
+                }
+                break;
+            default:
+                return ERROR_FATAL_FUNCTION_CALL;
+        }
+    }
+
+    double* root = nodeValues + (size_t)expressionGraph->root * stride;
+    *result = root[0];
+    for (int j = 0; j < slotCount; j++) {
+        gradient[j] = root[j + 1];
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int evaluate_compiledExpression_gradient(CompiledExpression* compiledExpression, double* variableValues,
+                                         const int* slots, int slotCount, double* result, double* gradient) {
+
+    // Validating function parameters
+    if (compiledExpression == NULL || result == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    if (slots == NULL) {
+        slotCount = compiledExpression->variableCount;
+    }
+
+    // Scratch space for the dual number of every node, on the stack for small expressions and few derivatives
+    unsigned long long start = start_statistics_phase();
+    double localValues[LOCAL_DUAL_VALUES];
+    double* nodeValues = localValues;
+    size_t valueCount = (size_t)compiledExpression->graph.nodeCount * (slotCount + 1);
+    if (valueCount > LOCAL_DUAL_VALUES) {
+        nodeValues = malloc(valueCount * sizeof(double));
+        if (nodeValues == NULL) {
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+        count_statistics_allocation(valueCount * sizeof(double));
+    }
+
+    int evaluate = evaluate_expressionGraph_gradient(&compiledExpression->graph, variableValues, slots, slotCount,
+                                                     nodeValues, result, gradient);
+    if (nodeValues != localValues) {
+        free(nodeValues);
+    }
+    end_statistics_phase(STATISTICS_PHASE_EVALUATE, start);
+
+    return evaluate;
+}
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "errors.h"
+#include "statistics.h"
+#include "lex.h"
+#include "parser.h"
+#include "operations.h"
+#include "graph.h"
+
+
+// Structure for the open-addressing hash table used to find existing nodes while the graph is built.
+// `slots` holds node indices (-1 for empty slots), `mask` is the capacity (a power of two) minus one.
+typedef struct NodeTable {
+    int* slots;
+    int mask;
+} NodeTable;
+
+
+// Returns the hash of the operation of `node` (everything but `sincosPartner`).
+static uint32_t hash_node(GraphNode* node) {
+
+    uint64_t bits;
+    memcpy(&bits, &node->value, sizeof(bits));
+
+    uint64_t hash = bits;
+    hash = (hash ^ (uint32_t)node->operands[0]) * 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ (uint32_t)node->operands[1]) * 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ ((uint32_t)node->typeToken << 8 | node->typeFunction)) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(hash >> 32);
+}
+
+
+// Returns 1 if the nodes `a` and `b` compute the same value (same operation on the same operands), 0 otherwise.
+// Constants are compared bit for bit, so 0.0 and -0.0 stay different nodes.
+static int same_node(GraphNode* a, GraphNode* b) {
+    return a->typeToken == b->typeToken && a->typeFunction == b->typeFunction &&
+           a->operands[0] == b->operands[0] && a->operands[1] == b->operands[1] &&
+           memcmp(&a->value, &b->value, sizeof(double)) == 0;
+}
+
+
+// Returns the slot of `nodeTable` holding the node of `expressionGraph` equal to `node`, or the empty slot where it
+// belongs if there is no such node.
+static int find_node(NodeTable* nodeTable, ExpressionGraph* expressionGraph, GraphNode* node) {
+
+    int slot = hash_node(node) & nodeTable->mask;
+    while (nodeTable->slots[slot] != -1 && !same_node(&expressionGraph->nodes[nodeTable->slots[slot]], node)) {
+        slot = (slot + 1) & nodeTable->mask;
+    }
+    return slot;
+}
+
+
+// Returns the index of the node of `expressionGraph` equal to `node`, appending `node` to the graph if there is none.
+static int intern_node(NodeTable* nodeTable, ExpressionGraph* expressionGraph, GraphNode* node) {
+
+    int slot = find_node(nodeTable, expressionGraph, node);
+    if (nodeTable->slots[slot] == -1) {
+        expressionGraph->nodes[expressionGraph->nodeCount] = *node;
+        nodeTable->slots[slot] = expressionGraph->nodeCount++;
+    }
+    return nodeTable->slots[slot];
+}
+
+
+// Pairs every `sin` node of `expressionGraph` with the `cos` node of the same argument, if there is one.
+static void fuse_sincos(NodeTable* nodeTable, ExpressionGraph* expressionGraph) {
+
+    for (int i = 0; i < expressionGraph->nodeCount; i++) {
+        GraphNode* node = &expressionGraph->nodes[i];
+        if (node->typeToken != TOKEN_FUNCTION || node->typeFunction != FUNCTION_SIN) {
+            continue;
+        }
+
+        GraphNode cosNode = *node;
+        cosNode.typeFunction = FUNCTION_COS;
+        int partner = nodeTable->slots[find_node(nodeTable, expressionGraph, &cosNode)];
+        if (partner != -1) {
+            node->sincosPartner = partner;
+            expressionGraph->nodes[partner].sincosPartner = i;
+        }
+    }
+}
+
+
+int build_expressionGraph(TokenList* lexicalTokenList, StackTokenList* postfixTokenList, char** variableNames,
+                          ExpressionGraph* expressionGraph) {
+
+    // Validating function parameters
+    if (lexicalTokenList == NULL || lexicalTokenList->array == NULL || postfixTokenList == NULL ||
+        postfixTokenList->array == NULL || postfixTokenList->top < 0 || expressionGraph == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Every token creates at most one node, and the table is kept at most half full
+    int tokenCount = postfixTokenList->top + 1;
+    int tableCapacity = 2;
+    while (tableCapacity < 2 * tokenCount) {
+        tableCapacity *= 2;
+    }
+
+    expressionGraph->nodes = malloc(tokenCount * sizeof(GraphNode));
+    expressionGraph->nodeCount = 0;
+    expressionGraph->root = -1;
+    expressionGraph->variableNames = variableNames;
+    NodeTable nodeTable;
+    nodeTable.slots = malloc(tableCapacity * sizeof(int));
+    nodeTable.mask = tableCapacity - 1;
+    int* operandStack = malloc(tokenCount * sizeof(int));
+    if (expressionGraph->nodes == NULL || nodeTable.slots == NULL || operandStack == NULL) {
+        free(nodeTable.slots);
+        free(operandStack);
+        free_expressionGraph_memory(expressionGraph);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(tokenCount * sizeof(GraphNode));
+    count_statistics_allocation(tableCapacity * sizeof(int));
+    count_statistics_allocation(tokenCount * sizeof(int));
+    memset(nodeTable.slots, -1, tableCapacity * sizeof(int));
+    int operandCount = 0;
+
+    // Main loop for iterating over the tokens in postfixTokenList, each one pops its operands and pushes its node
+    int status = 0;
+    for (int i = 0; i < tokenCount && status == 0; i++) {
+
+        Token* token = &lexicalTokenList->array[postfixTokenList->array[i]];
+        GraphNode node;
+        node.value = 0.0;
+        node.operands[0] = -1;
+        node.operands[1] = -1;
+        node.sincosPartner = -1;
+        node.typeToken = token->typeToken;
+        node.typeFunction = FUNCTION_INVALID;
+
+        int arity = 0;
+        switch (token->typeToken) {
+            case TOKEN_NUMBER:
+                node.value = lexicalTokenList->numberValues[token->slot];
+                break;
+            case TOKEN_KEYWORD_PI:
+                node.typeToken = TOKEN_NUMBER;
+                node.value = CONSTANT_PI;
+                break;
+            case TOKEN_KEYWORD_E:
+                node.typeToken = TOKEN_NUMBER;
+                node.value = CONSTANT_E;
+                break;
+            case TOKEN_VARIABLE:
+                if (token->slot < 0) {
+                    report_error(ERROR_CODE_UNBOUND_VARIABLE, token->offset, token->length,
+                                 "Error: variable '%.*s' is not bound to a slot.\n", token->length,
+                                 lexicalTokenList->sourceString + token->offset);
+                    status = ERROR_INVALID_PROGRAM_USAGE;
+                }
+                node.operands[0] = token->slot;
+                break;
+            case TOKEN_FUNCTION:
+                node.typeFunction = token->typeFunction;
+                arity = 1;
+                break;
+            case TOKEN_OPERATOR_PLUS:
+            case TOKEN_OPERATOR_MINUS:
+            case TOKEN_OPERATOR_MULTIPLY:
+            case TOKEN_OPERATOR_DIVIDE:
+                arity = 2;
+                break;
+            default:
+                continue;
+        }
+
+        if (arity > operandCount) {
+            report_error(ERROR_CODE_SYNTAX, token->offset, token->length,
+                         "Error: invalid expression, missing operand.\n");
+            status = ERROR_INVALID_PROGRAM_USAGE;
+            break;
+        }
+        for (int j = 0; j < arity; j++) {
+            node.operands[j] = operandStack[operandCount - arity + j];
+        }
+        operandCount -= arity;
+
+        // Addition and multiplication are commutative (exactly, in floating point), so `x*k` and `k*x` are one node
+        if ((node.typeToken == TOKEN_OPERATOR_PLUS || node.typeToken == TOKEN_OPERATOR_MULTIPLY) &&
+            node.operands[0] > node.operands[1]) {
+            int swap = node.operands[0];
+            node.operands[0] = node.operands[1];
+            node.operands[1] = swap;
+        }
+
+        operandStack[operandCount++] = intern_node(&nodeTable, expressionGraph, &node);
+    }
+
+    if (status == 0 && operandCount != 1) {
+        report_error(ERROR_CODE_SYNTAX, -1, 0, "Error: invalid expression, missing operator.\n");
+        status = ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    if (status == 0) {
+        expressionGraph->root = operandStack[0];
+        fuse_sincos(&nodeTable, expressionGraph);
+    }
+    else {
+        free_expressionGraph_memory(expressionGraph);
+    }
+
+    free(nodeTable.slots);
+    free(operandStack);
+
+    return status;
+}
+
+
+int evaluate_expressionGraph(ExpressionGraph* expressionGraph, double* variableValues, double* nodeValues,
+                             double* result) {
+
+    // Validating function parameters
+    if (expressionGraph == NULL || expressionGraph->nodes == NULL || nodeValues == NULL || result == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Nodes are in topological order, so operands are always computed before they are used
+    for (int i = 0; i < expressionGraph->nodeCount; i++) {
+
+        GraphNode* node = &expressionGraph->nodes[i];
+        double value;
+        TypeDomainError domainError;
+
+        switch (node->typeToken) {
+            case TOKEN_NUMBER:
+                value = node->value;
+                break;
+            case TOKEN_VARIABLE:
+                if (variableValues == NULL) {
+                    if (expressionGraph->variableNames == NULL) {
+                        report_error(ERROR_CODE_UNBOUND_VARIABLE, -1, 0,
+                                     "Error: no value given for the variable in slot %d.\n", node->operands[0]);
+                    }
+                    else {
+                        report_error(ERROR_CODE_UNBOUND_VARIABLE, -1, 0, "Error: no value given for variable '%s'.\n",
+                                     expressionGraph->variableNames[node->operands[0]]);
+                    }
+                    return ERROR_INVALID_PROGRAM_USAGE;
+                }
+                value = variableValues[node->operands[0]];
+                break;
+            case TOKEN_OPERATOR_PLUS:
+                value = nodeValues[node->operands[0]] + nodeValues[node->operands[1]];
+                break;
+            case TOKEN_OPERATOR_MINUS:
+                value = nodeValues[node->operands[0]] - nodeValues[node->operands[1]];
+                break;
+            case TOKEN_OPERATOR_MULTIPLY:
+                value = nodeValues[node->operands[0]] * nodeValues[node->operands[1]];
+                break;
+            case TOKEN_OPERATOR_DIVIDE:
+                if (nodeValues[node->operands[1]] == 0) {
+                    print_domain_error(DOMAIN_ERROR_DIVIDE_BY_ZERO, 0.0);
+                    return ERROR_INVALID_PROGRAM_USAGE;
+                }
+                value = nodeValues[node->operands[0]] / nodeValues[node->operands[1]];
+                break;
+            case TOKEN_FUNCTION:
+                // Fused sin and cos: the first node of the pair computes both values, the second has nothing left to do
+                if (node->sincosPartner != -1) {
+                    if (node->sincosPartner > i) {
+                        double sinValue, cosValue;
+                        apply_sincos(nodeValues[node->operands[0]], &sinValue, &cosValue);
+                        value = node->typeFunction == FUNCTION_SIN ? sinValue : cosValue;
+                        nodeValues[node->sincosPartner] = node->typeFunction == FUNCTION_SIN ? cosValue : sinValue;
+                        break;
+                    }
+                    continue;
+                }
+                domainError = apply_function(node->typeFunction, nodeValues[node->operands[0]], &value);
+                if (domainError != DOMAIN_VALID) {
+                    print_domain_error(domainError, nodeValues[node->operands[0]]);
+                    return ERROR_INVALID_PROGRAM_USAGE;
+                }
+                break;
+            default:
+                return ERROR_FATAL_FUNCTION_CALL;
+        }
+
+        nodeValues[i] = value;
+    }
+
+    *result = nodeValues[expressionGraph->root];
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int free_expressionGraph_memory(ExpressionGraph* expressionGraph) {
+
+    // Validating function parameters
+    if (expressionGraph == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    free(expressionGraph->nodes);
+    expressionGraph->nodes = NULL;
+    expressionGraph->nodeCount = 0;
+    expressionGraph->root = -1;
+
+    // Subroutine ran successfully
+    return 0;
+}
@@ -0,0 +1,433 @@
+#define _DEFAULT_SOURCE  // For MAP_ANONYMOUS in glibc
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "errors.h"
+#include "lex.h"
+#include "operations.h"
+#include "statistics.h"
+#include "graph.h"
+#include "jit.h"
+
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+static const int MAX_NODE_CODE_SIZE = 64;    // No node is translated into more bytes of machine code than this
+static const int MAX_FRAME_CODE_SIZE = 64;   // Bytes of the prologue and of the epilogue of the generated function
+
+
+// Structure for the machine code being generated. Includes the buffer written into, the number of bytes written, and
+// the positions of the rel32 jumps to the error exit, patched once the position of the exit is known.
+typedef struct CodeBuffer {
+    unsigned char* bytes;
+    int size;
+    int* errorJumps;
+    int errorJumpCount;
+} CodeBuffer;
+
+
+// The generated code keeps the variable values pointer in rbx and the node values pointer in r12 (both callee-saved,
+// so they survive the calls into libm). Node values are addressed as [r12 + 8*node], variables as [rbx + 8*slot].
+
+
+// Functions with a domain, called by the generated code. They return NaN on domain errors, which makes the generated
+// code give up and leave the error to the interpreter.
+static double checked_function(TypeFunction typeFunction, double x) {
+    double value;
+    return apply_function(typeFunction, x, &value) == DOMAIN_VALID ? value : NAN;
+}
+static double checked_tan(double x) { return checked_function(FUNCTION_TAN, x); }
+static double checked_asin(double x) { return checked_function(FUNCTION_ASIN, x); }
+static double checked_acos(double x) { return checked_function(FUNCTION_ACOS, x); }
+static double checked_ln(double x) { return checked_function(FUNCTION_LN, x); }
+static double checked_log(double x) { return checked_function(FUNCTION_LOG, x); }
+
+// Fused sin and cos, called by the generated code: returns the sine and writes the cosine into `cosValue`
+static double jit_sincos(double x, double* cosValue) {
+    double sinValue;
+    apply_sincos(x, &sinValue, cosValue);
+    return sinValue;
+}
+
+
+// Returns the address of the function called for `typeFunction`, and whether its result must be checked for NaN.
+static void* function_address(TypeFunction typeFunction, int* checked) {
+
+    *checked = 1;
+    switch (typeFunction) {
+        case FUNCTION_TAN:  return (void*)checked_tan;
+        case FUNCTION_ASIN: return (void*)checked_asin;
+        case FUNCTION_ACOS: return (void*)checked_acos;
+        case FUNCTION_LN:   return (void*)checked_ln;
+        case FUNCTION_LOG:  return (void*)checked_log;
+        default: break;
+    }
+
+    // The functions defined everywhere are called in libm directly, they never raise domain errors
+    *checked = 0;
+    switch (typeFunction) {
+        case FUNCTION_SIN:  return (void*)sin;
+        case FUNCTION_COS:  return (void*)cos;
+        case FUNCTION_ATAN: return (void*)atan;
+        case FUNCTION_EXP:  return (void*)exp;
+        default: return NULL;
+    }
+}
+
+
+static void emit_bytes(CodeBuffer* codeBuffer, const unsigned char* bytes, int count) {
+    memcpy(codeBuffer->bytes + codeBuffer->size, bytes, count);
+    codeBuffer->size += count;
+}
+
+static void emit_int32(CodeBuffer* codeBuffer, int32_t value) {
+    memcpy(codeBuffer->bytes + codeBuffer->size, &value, sizeof(value));
+    codeBuffer->size += sizeof(value);
+}
+
+static void emit_int64(CodeBuffer* codeBuffer, int64_t value) {
+    memcpy(codeBuffer->bytes + codeBuffer->size, &value, sizeof(value));
+    codeBuffer->size += sizeof(value);
+}
+
+
+// movsd xmm`xmmRegister`, [r12 + 8*node]
+static void emit_load_node(CodeBuffer* codeBuffer, int xmmRegister, int node) {
+    unsigned char bytes[] = {0xF2, 0x41, 0x0F, 0x10, (unsigned char)(0x84 | xmmRegister << 3), 0x24};
+    emit_bytes(codeBuffer, bytes, sizeof(bytes));
+    emit_int32(codeBuffer, node * 8);
+}
+
+// movsd [r12 + 8*node], xmm0
+static void emit_store_node(CodeBuffer* codeBuffer, int node) {
+    unsigned char bytes[] = {0xF2, 0x41, 0x0F, 0x11, 0x84, 0x24};
+    emit_bytes(codeBuffer, bytes, sizeof(bytes));
+    emit_int32(codeBuffer, node * 8);
+}
+
+// movsd xmm0, [rbx + 8*slot]
+static void emit_load_variable(CodeBuffer* codeBuffer, int slot) {
+    unsigned char bytes[] = {0xF2, 0x0F, 0x10, 0x83};
+    emit_bytes(codeBuffer, bytes, sizeof(bytes));
+    emit_int32(codeBuffer, slot * 8);
+}
+
+// mov rax, imm64 ; movq xmm0, rax
+static void emit_load_constant(CodeBuffer* codeBuffer, double value) {
+    int64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    unsigned char movRax[] = {0x48, 0xB8};
+    unsigned char movqXmm0[] = {0x66, 0x48, 0x0F, 0x6E, 0xC0};
+    emit_bytes(codeBuffer, movRax, sizeof(movRax));
+    emit_int64(codeBuffer, bits);
+    emit_bytes(codeBuffer, movqXmm0, sizeof(movqXmm0));
+}
+
+// mov rax, imm64 ; call rax
+static void emit_call(CodeBuffer* codeBuffer, void* function) {
+    unsigned char movRax[] = {0x48, 0xB8};
+    unsigned char callRax[] = {0xFF, 0xD0};
+    emit_bytes(codeBuffer, movRax, sizeof(movRax));
+    emit_int64(codeBuffer, (int64_t)(intptr_t)function);
+    emit_bytes(codeBuffer, callRax, sizeof(callRax));
+}
+
+// Conditional jump (0F `condition` rel32) to the error exit, patched by patch_error_jumps
+static void emit_jump_to_error(CodeBuffer* codeBuffer, unsigned char condition) {
+    unsigned char bytes[] = {0x0F, condition};
+    emit_bytes(codeBuffer, bytes, sizeof(bytes));
+    codeBuffer->errorJumps[codeBuffer->errorJumpCount++] = codeBuffer->size;
+    emit_int32(codeBuffer, 0);
+}
+
+static void patch_error_jumps(CodeBuffer* codeBuffer, int errorExit) {
+    for (int i = 0; i < codeBuffer->errorJumpCount; i++) {
+        int32_t relative = errorExit - (codeBuffer->errorJumps[i] + 4);
+        memcpy(codeBuffer->bytes + codeBuffer->errorJumps[i], &relative, sizeof(relative));
+    }
+}
+
+
+// Generates the machine code of the node `index` of `expressionGraph`. `xmm0Node` is the node whose value is in
+// xmm0 when the code starts (-1 if none), it is updated to the node whose value is in xmm0 when the code ends.
+static void emit_node(CodeBuffer* codeBuffer, ExpressionGraph* expressionGraph, int index, int* xmm0Node) {
+
+    GraphNode* node = &expressionGraph->nodes[index];
+    int operand = node->operands[0];
+
+    switch (node->typeToken) {
+        case TOKEN_NUMBER:
+            emit_load_constant(codeBuffer, node->value);
+            break;
+        case TOKEN_VARIABLE:
+            emit_load_variable(codeBuffer, node->operands[0]);
+            break;
+        case TOKEN_OPERATOR_PLUS:
+        case TOKEN_OPERATOR_MINUS:
+        case TOKEN_OPERATOR_MULTIPLY:
+        case TOKEN_OPERATOR_DIVIDE: {
+            if (*xmm0Node != operand) {
+                emit_load_node(codeBuffer, 0, operand);
+            }
+            emit_load_node(codeBuffer, 1, node->operands[1]);
+
+            // addsd / subsd / mulsd / divsd xmm0, xmm1
+            unsigned char opcode = node->typeToken == TOKEN_OPERATOR_PLUS ? 0x58 :
+                                   node->typeToken == TOKEN_OPERATOR_MINUS ? 0x5C :
+                                   node->typeToken == TOKEN_OPERATOR_MULTIPLY ? 0x59 : 0x5E;
+            if (node->typeToken == TOKEN_OPERATOR_DIVIDE) {
+                // xorpd xmm2, xmm2 ; ucomisd xmm1, xmm2 ; jp +6 (NaN is not zero) ; je error
+                unsigned char zeroCheck[] = {0x66, 0x0F, 0x57, 0xD2, 0x66, 0x0F, 0x2E, 0xCA, 0x7A, 0x06};
+                emit_bytes(codeBuffer, zeroCheck, sizeof(zeroCheck));
+                emit_jump_to_error(codeBuffer, 0x84);
+            }
+            unsigned char arithmetic[] = {0xF2, 0x0F, opcode, 0xC1};
+            emit_bytes(codeBuffer, arithmetic, sizeof(arithmetic));
+            break;
+        }
+        case TOKEN_FUNCTION:
+            if (node->sincosPartner != -1) {
+                // The second node of a fused pair was already computed by the first one
+                if (node->sincosPartner < index) {
+                    return;
+                }
+                if (*xmm0Node != operand) {
+                    emit_load_node(codeBuffer, 0, operand);
+                }
+
+                // The cosine is written by jit_sincos through its second argument, the sine is returned in xmm0
+                int cosNode = node->typeFunction == FUNCTION_COS ? index : node->sincosPartner;
+                int sinNode = node->typeFunction == FUNCTION_SIN ? index : node->sincosPartner;
+#if defined(_WIN64)
+                unsigned char leaCos[] = {0x49, 0x8D, 0x94, 0x24};  // lea rdx, [r12 + 8*cosNode]
+#else
+                unsigned char leaCos[] = {0x49, 0x8D, 0xBC, 0x24};  // lea rdi, [r12 + 8*cosNode]
+#endif
+                emit_bytes(codeBuffer, leaCos, sizeof(leaCos));
+                emit_int32(codeBuffer, cosNode * 8);
+                emit_call(codeBuffer, (void*)jit_sincos);
+                emit_store_node(codeBuffer, sinNode);
+                *xmm0Node = sinNode;
+                return;
+            }
+            else {
+                if (*xmm0Node != operand) {
+                    emit_load_node(codeBuffer, 0, operand);
+                }
+                int checked;
+                emit_call(codeBuffer, function_address(node->typeFunction, &checked));
+                if (checked) {
+                    // ucomisd xmm0, xmm0 ; jp error (NaN)
+                    unsigned char nanCheck[] = {0x66, 0x0F, 0x2E, 0xC0};
+                    emit_bytes(codeBuffer, nanCheck, sizeof(nanCheck));
+                    emit_jump_to_error(codeBuffer, 0x8A);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+
+    emit_store_node(codeBuffer, index);
+    *xmm0Node = index;
+}
+
+
+// Generates the whole function evaluating `expressionGraph` into `codeBuffer`.
+static void emit_function(CodeBuffer* codeBuffer, ExpressionGraph* expressionGraph) {
+
+    // push rbx ; push r12 ; sub rsp, 40 (keeps rsp 16-byte aligned for the calls, and leaves the Win64 shadow space)
+    unsigned char prologue[] = {0x53, 0x41, 0x54, 0x48, 0x83, 0xEC, 0x28};
+    emit_bytes(codeBuffer, prologue, sizeof(prologue));
+#if defined(_WIN64)
+    unsigned char arguments[] = {0x48, 0x89, 0xCB, 0x49, 0x89, 0xD4};  // mov rbx, rcx ; mov r12, rdx
+#else
+    unsigned char arguments[] = {0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4};  // mov rbx, rdi ; mov r12, rsi
+#endif
+    emit_bytes(codeBuffer, arguments, sizeof(arguments));
+
+    int xmm0Node = -1;
+    for (int i = 0; i < expressionGraph->nodeCount; i++) {
+        emit_node(codeBuffer, expressionGraph, i, &xmm0Node);
+    }
+
+    // Success: xor eax, eax. Then the shared exit: add rsp, 40 ; pop r12 ; pop rbx ; ret
+    unsigned char success[] = {0x31, 0xC0};
+    emit_bytes(codeBuffer, success, sizeof(success));
+    int exitPosition = codeBuffer->size;
+    unsigned char epilogue[] = {0x48, 0x83, 0xC4, 0x28, 0x41, 0x5C, 0x5B, 0xC3};
+    emit_bytes(codeBuffer, epilogue, sizeof(epilogue));
+
+    // Error: mov eax, 1 ; jmp exit
+    int errorExit = codeBuffer->size;
+    unsigned char error[] = {0xB8, 0x01, 0x00, 0x00, 0x00, 0xEB, 0x00};
+    error[6] = (unsigned char)(exitPosition - (errorExit + (int)sizeof(error)));
+    emit_bytes(codeBuffer, error, sizeof(error));
+
+    patch_error_jumps(codeBuffer, errorExit);
+}
+
+
+// Allocates `size` bytes of writable memory for the code. Returns NULL upon failure.
+static void* allocate_code_memory(size_t size) {
+#if defined(_WIN32)
+    return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return memory == MAP_FAILED ? NULL : memory;
+#endif
+}
+
+
+// Makes the code memory executable (and no longer writable). Returns 0 upon success, 1 upon failure.
+static int protect_code_memory(void* memory, size_t size) {
+#if defined(_WIN32)
+    DWORD oldProtection;
+    if (!VirtualProtect(memory, size, PAGE_EXECUTE_READ, &oldProtection)) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    FlushInstructionCache(GetCurrentProcess(), memory, size);
+    return 0;
+#else
+    return mprotect(memory, size, PROT_READ | PROT_EXEC) == 0 ? 0 : ERROR_FATAL_FUNCTION_CALL;
+#endif
+}
+
+
+static void release_code_memory(void* memory, size_t size) {
+#if defined(_WIN32)
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, size);
+#endif
+}
+
+
+int compile_jitExpression(ExpressionGraph* expressionGraph, JitExpression* jitExpression) {
+
+    // Validating function parameters
+    if (expressionGraph == NULL || expressionGraph->nodes == NULL || jitExpression == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    jitExpression->code = NULL;
+    jitExpression->codeSize = 0;
+    jitExpression->function = NULL;
+    jitExpression->root = expressionGraph->root;
+    jitExpression->hasVariables = 0;
+    for (int i = 0; i < expressionGraph->nodeCount; i++) {
+        if (expressionGraph->nodes[i].typeToken == TOKEN_VARIABLE) {
+            jitExpression->hasVariables = 1;
+        }
+    }
+
+    // Upper bound of the size of the code, rounded up to whole pages
+#if defined(_WIN32)
+    size_t pageSize = 4096;
+#else
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    size_t codeSize = (size_t)expressionGraph->nodeCount * MAX_NODE_CODE_SIZE + 2 * MAX_FRAME_CODE_SIZE;
+    codeSize = (codeSize + pageSize - 1) / pageSize * pageSize;
+
+    CodeBuffer codeBuffer;
+    codeBuffer.bytes = allocate_code_memory(codeSize);
+    codeBuffer.size = 0;
+    codeBuffer.errorJumps = malloc((expressionGraph->nodeCount + 1) * sizeof(int));
+    codeBuffer.errorJumpCount = 0;
+    if (codeBuffer.bytes == NULL || codeBuffer.errorJumps == NULL) {
+        if (codeBuffer.bytes != NULL) {
+            release_code_memory(codeBuffer.bytes, codeSize);
+        }
+        free(codeBuffer.errorJumps);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(codeSize);
+    count_statistics_allocation((expressionGraph->nodeCount + 1) * sizeof(int));
+
+    emit_function(&codeBuffer, expressionGraph);
+    free(codeBuffer.errorJumps);
+
+    if (protect_code_memory(codeBuffer.bytes, codeSize) != 0) {
+        release_code_memory(codeBuffer.bytes, codeSize);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    jitExpression->code = codeBuffer.bytes;
+    jitExpression->codeSize = codeSize;
+    jitExpression->function = (JitFunction)codeBuffer.bytes;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int free_jitExpression_memory(JitExpression* jitExpression) {
+
+    // Validating function parameters
+    if (jitExpression == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    if (jitExpression->code != NULL) {
+        release_code_memory(jitExpression->code, jitExpression->codeSize);
+    }
+    jitExpression->code = NULL;
+    jitExpression->codeSize = 0;
+    jitExpression->function = NULL;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+#else
+
+// No code generator for this architecture, compiled expressions are always evaluated by the interpreter
+
+int compile_jitExpression(ExpressionGraph* expressionGraph, JitExpression* jitExpression) {
+    if (jitExpression != NULL) {
+        jitExpression->code = NULL;
+        jitExpression->codeSize = 0;
+        jitExpression->function = NULL;
+    }
+    return ERROR_FATAL_FUNCTION_CALL;
+}
+
+
+int free_jitExpression_memory(JitExpression* jitExpression) {
+    return jitExpression == NULL ? ERROR_INVALID_FUNCTION_PARAMETERS : 0;
+}
+
+#endif
+
+
+int evaluate_jitExpression(JitExpression* jitExpression, double* variableValues, double* nodeValues, double* result) {
+
+    // Validating function parameters
+    if (jitExpression == NULL || jitExpression->function == NULL || nodeValues == NULL || result == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Missing variable values are reported by the interpreter
+    if (variableValues == NULL && jitExpression->hasVariables) {
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    if (jitExpression->function(variableValues, nodeValues) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    *result = nodeValues[jitExpression->root];
+
+    // Subroutine ran successfully
+    return 0;
+}
@@ -1,12 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 #include "errors.h"
+#include "statistics.h"
 #include "lex.h"
 
-static const int INITIAL_TOKEN_CAPACITY = 10;  // Initial capacity for the tokenArr in lexer_Output instance
-static const float FACTOR_TOKEN_INCREASE = 1.5;  // Factor by which to increase token capacity
-
 
 // Returns the string version of the input token type's name.
 // Returns NULL upon failure (invalid token type inputted). Errors are fatal.
@@ -32,18 +34,22 @@ static char* token_type_to_string(TypeToken typeToken) {
             return "TOKEN_KEYWORD_E";
         case TOKEN_KEYWORD_PI: 
             return "TOKEN_KEYWORD_PI";
+        case TOKEN_VARIABLE: 
+            return "TOKEN_VARIABLE";
         case TOKEN_EOF: 
             return "TOKEN_EOF";
+        case TOKEN_OPERATOR_POWER:
+            return "TOKEN_OPERATOR_POWER";
         default: 
             return NULL;
     }
 }
 
 
-int print_token(Token* token) {
+int print_token(TokenList* tokenList, Token* token) {
 
     // Validating the fields of the input token struct
-    if (token == NULL || token->pLexemmeStart == NULL || token->length < 1) {
+    if (tokenList == NULL || tokenList->sourceString == NULL || token == NULL || token->length < 1) {
         return ERROR_INVALID_FUNCTION_PARAMETERS;
     }
 
@@ -55,85 +61,89 @@ int print_token(Token* token) {
 
     // Print the token data. Token value is printed on character at a time
     printf("Token(type: %s, value: '", tokenTypeString);
-    printf("%.*s", token->length, token->pLexemmeStart);
+    printf("%.*s", token->length, tokenList->sourceString + token->offset);
     printf("')\n");
 
     return 0; 
 }
 
 
-// Allocates memory for a token struct on the heap. Takes in parameters for the new token's fields.
-// Returns a pointer to the new token. Returns NULL upon errors, this error is fatal.
-static Token* create_token(TypeToken typeToken, char* pLexemmeStart, int length) {
+// Returns the number of bytes needed for the token array of a TokenList with room for `maxCapacity` tokens,
+// rounded up so that the number values stored after it in the same allocation are aligned.
+static size_t token_array_size(int maxCapacity) {
+    size_t size = (size_t)maxCapacity * sizeof(Token);
+    return (size + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+}
 
-    // Validating function parameters
-    if (pLexemmeStart == NULL || length < 1) {
-        return NULL;
-    }
 
-    // Allocate memory on heap for the new token structure
-    Token* token = malloc(sizeof(Token)); 
-    if (token == NULL) {
-        return NULL;
+// Allocates the single block holding the token array and the number values of `tokenList`, with room for the tokens
+// of a source string of `sourceLength` characters. Any previous block is freed. 
+// Returns 0 upon successful call, and 1 if errors encountered. Errors are fatal.
+static int allocate_tokenList(TokenList* tokenList, int sourceLength) {
+
+    // Every token is at least one character long (plus the EOF token), and every operand (number or keyword constant)
+    // but the last is followed by at least one other character, so these capacities can never be exceeded. This also
+    // leaves room for the values of the constants folded by the optimizer, which never outnumber the operands.
+    int maxCapacity = sourceLength + 1;
+    int maxNumbers = sourceLength / 2 + 1;
+
+    Token* block = malloc(token_array_size(maxCapacity) + (size_t)maxNumbers * sizeof(double));
+    if (block == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
     }
+    count_statistics_allocation(token_array_size(maxCapacity) + (size_t)maxNumbers * sizeof(double));
 
-    // Initialize the token's fields
-    token->typeToken = typeToken;
-    token->pLexemmeStart = pLexemmeStart;
-    token->length = length;
+    free(tokenList->array);
+    tokenList->array = block;
+    tokenList->numberValues = (double*)((char*)block + token_array_size(maxCapacity));
+    tokenList->maxCapacity = maxCapacity;
 
-    return token; 
+    return 0;
 }
 
 
-int init_tokenList(TokenList* tokenList) {
+int init_tokenList(TokenList* tokenList, int sourceLength) {
 
     // Validating function parameters
-    if (tokenList == NULL) {
+    if (tokenList == NULL || sourceLength < 0) {
         return ERROR_INVALID_FUNCTION_PARAMETERS;
     }
 
-    tokenList->maxCapacity = INITIAL_TOKEN_CAPACITY;
-    tokenList->array = malloc(tokenList->maxCapacity*sizeof(Token*));
-    if (tokenList->array == NULL) {
-        // fprintf(stderr, "Fatal error: memory could not be allocated.\n\n");
-        return ERROR_MEMORY_ALLOCATION_FAILURE;
-    }
+    tokenList->array = NULL;
+    tokenList->numberValues = NULL;
+    tokenList->sourceString = NULL;
     tokenList->position = -1;
+    tokenList->numberCount = 0;
+    tokenList->maxCapacity = 0;
 
+    return allocate_tokenList(tokenList, sourceLength);
 }
 
 
-// Adds a pre-created token pointer to the dynamic pointer array of token pointers in the TokenList struct.
-// Returns 0 upon successful call, and 1 if errors encountered. Errors are fatal.
-static int add_token_to_list(TokenList* tokenList, Token* token) {
+// Appends a new token to the array of the TokenList struct. Takes in parameters for the new token's fields.
+// Returns a pointer to the new token (valid until the list is reallocated). Returns NULL upon errors, this error is fatal.
+static inline Token* add_token(TokenList* tokenList, TypeToken typeToken, char* pLexemmeStart, int length) {
 
     // Validating function parameters
-    if (tokenList == NULL || tokenList->array == NULL || token == NULL || token->pLexemmeStart == NULL || token->length < 1) {
-        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    if (pLexemmeStart == NULL || length < 1 || tokenList->position + 1 >= tokenList->maxCapacity) {
+        return NULL;
     }
-
-    // Increment position along array and check if resizing required
-    tokenList->position++;
-    if (tokenList->position >= (tokenList->maxCapacity-1)) {
-
-        tokenList->maxCapacity *= FACTOR_TOKEN_INCREASE; 
-
-        // Resize the memory and store returned pointer in temporary variable
-        Token** tempArray = realloc(tokenList->array, tokenList->maxCapacity * sizeof(Token*));
-        if (tempArray == NULL) {
-            return ERROR_MEMORY_ALLOCATION_FAILURE;
-        }
-
-        // Assign the resized array to the original array pointer
-        tokenList->array = tempArray;
+    if (length > MAX_LEXEMME_LENGTH) {
+        report_error(ERROR_CODE_SYNTAX, (int)(pLexemmeStart - tokenList->sourceString), length,
+                     "\nError: lexemme too long at '%.*s'.\n", 16, pLexemmeStart);
+        return NULL;
     }
 
-    // Add token to the array
-    tokenList->array[tokenList->position] = token;
-
-    return 0; 
+    // Initialize the token's fields
+    tokenList->position++;
+    Token* token = &tokenList->array[tokenList->position];
+    token->offset = (int)(pLexemmeStart - tokenList->sourceString);
+    token->length = (unsigned short)length;
+    token->typeToken = (unsigned char)typeToken;
+    token->typeFunction = FUNCTION_INVALID;
+    token->slot = -1;
 
+    return token; 
 }
 
 
@@ -143,9 +153,10 @@ static int is_digit(char value) {
 }
 
 
-// Checks if input character is an operator or paranthesis. 1 if yes, else 0.
+// Checks if input character is an operator or paranthesis. 1 if yes, else 0. ('^' is only an operator for
+// scan_token, but may follow any operand: the token list lexer reports it as an invalid character itself)
 static int is_operator_or_paren(char value) {
-    return (value == '+' || value == '-' || value == '*' || value == '/' || 
+    return (value == '+' || value == '-' || value == '*' || value == '/' || value == '^' ||
             value == '(' || value == ')');
 }
 
@@ -156,33 +167,86 @@ static int is_alpha(char value) {
 }
 
 
+// Checks if input character ends the source string: the null terminator, or a line ending for source strings that are
+// lines of a larger text (see lexical_analyzer_length). 1 if yes, else 0.
+static int is_source_end(char value) {
+    return (value == '\0' || value == '\n' || value == '\r');
+}
+
+
+// Checks if input character may continue an identifier (a-z, 0-9 or '_'). 1 if yes, else 0.
+static int is_identifier_char(char value) {
+    return (is_alpha(value) || is_digit(value) || value == '_');
+}
+
+
 // Checks if input character is a plus '+' or '-'. 1 if yes, else 0.
 static int is_plus_or_minus(char value) {
     return (value == '+' || value == '-');
 }
 
 
+// Exact powers of ten representable as doubles, used by the fast path of the number conversion
+static const double powersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int MAX_EXACT_POWER_OF_TEN = 22;
+static const unsigned long long MAX_EXACT_MANTISSA = 1ULL << 53;  // Largest integer range exactly stored in a double
+static const int MAX_MANTISSA_DIGITS = 19;  // Significant digits that always fit in an unsigned long long
+static const int MAX_EXPONENT_DIGITS_VALUE = 100000;  // Exponents beyond this over/underflow anyway
+
+
+// Accumulates the digit `value` into the `mantissa` of a number being converted. Once the mantissa holds
+// MAX_MANTISSA_DIGITS significant digits, further digits are dropped and `truncated` is set instead. 
+// Dropped digits of the integer part still scale the number, so they increment `decimalExponent`.
+static void accumulate_digit(char value, int isFraction, unsigned long long* mantissa, int* significantDigits,
+                             int* decimalExponent, int* truncated) {
+    if (*significantDigits < MAX_MANTISSA_DIGITS) {
+        *mantissa = *mantissa * 10 + (value - '0');
+        if (*mantissa != 0) {
+            (*significantDigits)++;  // Leading zeros are not significant
+        }
+        if (isFraction) {
+            (*decimalExponent)--;
+        }
+    }
+    else {
+        *truncated = 1;
+        if (!isFraction) {
+            (*decimalExponent)++;
+        }
+    }
+}
+
+
 /*
 - Is called when lexer identifies a number. Traverses string section pointed to by `lexemmeStart` and checks if number.
 - Supports integers, floating-point numbers (with '.'), and scientific notation ('E+' or 'E-'). Valid numbers must be
-  immediately followed by whitespace, an operator, a parenthesis, or the null terminator.
-- Upon detection of invaid syntax, an error message is printed, and NULL is returned.
-- If valid number found, creates a new token and `returns` its pointer. All errors are fatal.
+  immediately followed by whitespace, an operator, a parenthesis, or the end of the source string.
+- The value of the number is converted during the same traversal, without copying the lexemme. When the digits and
+  exponent fit in a double exactly (at most 2^53 and 10^22) a single multiplication or division gives the correctly
+  rounded value. Rarer numbers fall back to strtod, which reads the lexemme directly from the source string.
+- Upon detection of invaid syntax, an error message is reported (positions are relative to `sourceString`), and -1 is
+  returned.
+- If valid number found, writes its value into `value` and returns the length of its lexemme. All errors are fatal.
 *
 */
-static Token* scan_number(char* lexemmeStart) {
-
-    // Validating function parameters
-    if (lexemmeStart == NULL) {
-        return NULL;
-    }
+static inline int read_number(char* lexemmeStart, char* sourceString, double* value) {
 
     // For number length and string traversal
     int counter = 0;
     char* traverser = lexemmeStart;
 
+    // For the conversion of the number to a double
+    unsigned long long mantissa = 0;
+    int significantDigits = 0;
+    int decimalExponent = 0;
+    int truncated = 0;
+
     // Scan for integer part of potential number until non-digit character encountered
     while (is_digit(*traverser)) {
+        accumulate_digit(*traverser, 0, &mantissa, &significantDigits, &decimalExponent, &truncated);
         counter++; 
         traverser++; 
     }
@@ -196,13 +260,15 @@ static Token* scan_number(char* lexemmeStart) {
 
             // Scan fractional part of potential number until non-digit character encountered
             while (is_digit(*traverser)) {
+                accumulate_digit(*traverser, 1, &mantissa, &significantDigits, &decimalExponent, &truncated);
                 counter++;
                 traverser++;
             }
         }
         else {
-            fprintf(stderr, "\nError: invalid floating-point number at '%.*s'.\n", counter+2, lexemmeStart);
-            return NULL; // Report invalid syntax
+            report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), counter+2,
+                         "\nError: invalid floating-point number at '%.*s'.\n", counter+2, lexemmeStart);
+            return -1; // Report invalid syntax
         }
     }
 
@@ -210,201 +276,654 @@ static Token* scan_number(char* lexemmeStart) {
     if (*traverser == 'E') {
         if (is_plus_or_minus(*(traverser+1))) {
             if (is_digit(*(traverser+2))) {
+                int exponentSign = (*(traverser+1) == '-') ? -1 : 1;
+                int exponent = 0;
+
                 //consume the 'E+' or 'E-'
                 counter += 2;
                 traverser += 2;
 
                 // Scan the scientific notation part of potential number
                 while (is_digit(*traverser)) {
+                    if (exponent < MAX_EXPONENT_DIGITS_VALUE) {
+                        exponent = exponent * 10 + (*traverser - '0');
+                    }
                     counter++;
                     traverser++;
                 }
+                decimalExponent += exponentSign * exponent;
             }
             else {
-                fprintf(stderr, "\nError: invalid scientific notation at '%.*s'.\n", counter+3, lexemmeStart);
-                return NULL; // Report invalid syntax
+                report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), counter+3,
+                             "\nError: invalid scientific notation at '%.*s'.\n", counter+3, lexemmeStart);
+                return -1; // Report invalid syntax
             }
         }
         else {
-            fprintf(stderr, "\nError: invalid scientific notation at '%.*s'.\n", counter+2, lexemmeStart);
-            return NULL; // Report invalid syntax
+            report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), counter+2,
+                         "\nError: invalid scientific notation at '%.*s'.\n", counter+2, lexemmeStart);
+            return -1; // Report invalid syntax
         }
     }
 
     // Check if the number is not followed by a valid character
-    if (*traverser != ' ' && *traverser != '\0' && !is_operator_or_paren(*traverser)) { 
+    if (*traverser != ' ' && !is_source_end(*traverser) && !is_operator_or_paren(*traverser)) { 
         // Report the invalid number syntax and terminate the program
-        fprintf(stderr, "\nError: invalid character after number at '%.*s'.\n", counter+1, lexemmeStart);
-        return NULL;
+        report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), counter+1,
+                     "\nError: invalid character after number at '%.*s'.\n", counter+1, lexemmeStart);
+        return -1;
     }
 
-    // Create and return valid number token. // If NULL, lexer_analyzer will flag it.
-    return create_token(TOKEN_NUMBER, lexemmeStart, counter);
+    // Convert the number. Fast path when both mantissa and power of ten are exact doubles
+    if (mantissa == 0) {
+        *value = 0.0;
+    }
+    else if (!truncated && mantissa <= MAX_EXACT_MANTISSA &&
+             decimalExponent >= -MAX_EXACT_POWER_OF_TEN && decimalExponent <= MAX_EXACT_POWER_OF_TEN) {
+        *value = (decimalExponent < 0) ? (double)mantissa / powersOfTen[-decimalExponent]
+                                       : (double)mantissa * powersOfTen[decimalExponent];
+    }
+    else {
+        *value = strtod(lexemmeStart, NULL);
+        count_statistics(STATISTICS_SLOW_NUMBERS, 1);
+    }
+
+    return counter;
 
 }  
 
 
-/*
-- Is called when lexer identifies a letter. Traverses string section pointed to by `lexemmeStart` and checks if potential function
-- Functions may ONLY include letter characters (a-z) and must be immediately followed by a left parenthesis
-- Upon detection of invaid syntax, an error message is printed, and NULL is returned.
-- If potentially valid function found, creates a new token and `returns` its pointer. All errors are fatal.
-*
-*/
-static Token* scan_function(char* lexemmeStart) {
+// Is called when lexer identifies a number: reads it (see read_number), then adds a new number token to `tokenList`
+// whose value is stored in the number values of the list. Returns its pointer, or NULL upon errors (fatal).
+static inline Token* scan_number(char* lexemmeStart, TokenList* tokenList) {
 
-    // Validating function parameters
-    if (lexemmeStart == NULL) {
+    double value;
+    int length = read_number(lexemmeStart, tokenList->sourceString, &value);
+    if (length < 0) {
         return NULL;
     }
 
-    // For number length and string traversal
+    // If NULL, lexer_analyzer will flag it.
+    Token* token = add_token(tokenList, TOKEN_NUMBER, lexemmeStart, length);
+    if (token != NULL) {
+        token->slot = tokenList->numberCount;
+        tokenList->numberValues[tokenList->numberCount++] = value;
+    }
+    return token;
+}
+
+
+// Entry of the table of reserved names (keyword constants and function names)
+typedef struct ReservedName {
+    const char* name;
+    int length;
+    TypeToken typeToken;
+    TypeFunction typeFunction;
+} ReservedName;
+
+
+// Perfect hash table of the reserved names, indexed by hash_reserved_name. The multiplier of the second character
+// was chosen (by trying small multipliers) so that every reserved name lands in a distinct bucket; when adding a
+// name, check its bucket is free or pick a new multiplier and re-index the table. Empty buckets have length 0.
+#define RESERVED_NAMES_TABLE_SIZE 32
+static const ReservedName reservedNames[RESERVED_NAMES_TABLE_SIZE] = {
+    [5] = {"e", 1, TOKEN_KEYWORD_E, FUNCTION_INVALID},
+    [10] = {"acos", 4, TOKEN_FUNCTION, FUNCTION_ACOS},
+    [11] = {"pi", 2, TOKEN_KEYWORD_PI, FUNCTION_INVALID},
+    [13] = {"exp", 3, TOKEN_FUNCTION, FUNCTION_EXP},
+    [14] = {"sin", 3, TOKEN_FUNCTION, FUNCTION_SIN},
+    [16] = {"cos", 3, TOKEN_FUNCTION, FUNCTION_COS},
+    [22] = {"ln", 2, TOKEN_FUNCTION, FUNCTION_LN},
+    [23] = {"tan", 3, TOKEN_FUNCTION, FUNCTION_TAN},
+    [25] = {"log", 3, TOKEN_FUNCTION, FUNCTION_LOG},
+    [26] = {"asin", 4, TOKEN_FUNCTION, FUNCTION_ASIN},
+    [29] = {"atan", 4, TOKEN_FUNCTION, FUNCTION_ATAN},
+};
+
+
+// Returns the bucket of the name made of the `length` letters at `name` in the reservedNames table.
+static int hash_reserved_name(char* name, int length) {
+    int second = (length > 1) ? name[1] : 0;
+    return (name[0] + 3 * second) & (RESERVED_NAMES_TABLE_SIZE - 1);
+}
+
+
+// Looks up the name made of the `length` letters at `name` in the reservedNames table, in O(1).
+// Returns a pointer to the table entry if the name is reserved, NULL otherwise.
+static const ReservedName* find_reserved_name(char* name, int length) {
+
+    const ReservedName* entry = &reservedNames[hash_reserved_name(name, length)];
+    if (entry->length != length) {
+        return NULL;
+    }
+    for (int i = 0; i < length; i++) {
+        if (entry->name[i] != name[i]) {
+            return NULL;
+        }
+    }
+    return entry;
+}
+
+
+/*
+- Is called when lexer identifies a letter. Traverses string section pointed to by `lexemmeStart` and checks if potential
+  function, keyword constant or variable.
+- Names made of letters only are looked up in the reserved names table, which gives the keyword or function directly.
+- Functions must be immediately followed by a left parenthesis, keywords by whitespace, an operator, a parenthesis,
+  or the null terminator.
+- Any other name (letters, then letters, digits or '_') is a variable. Variables must be immediately followed by 
+  whitespace, an operator, a parenthesis, or the null terminator.
+- Upon detection of invaid syntax, an error message is reported (positions are relative to `sourceString`), and -1 is
+  returned.
+- If potentially valid name found, writes its token type (and function) and returns the length of its lexemme. All
+  errors are fatal.
+*
+*/
+static inline int read_name(char* lexemmeStart, char* sourceString, TypeToken* typeToken, TypeFunction* typeFunction) {
+
+    // For name length and string traversal
     int counter = 0;
+    int letterCounter = 0;
     char* traverser = lexemmeStart;
 
-    // Scan for the entire function.
+    // Scan for the entire name. Keep track of how many of the leading characters are letters
     while (is_alpha(*traverser)) {
-        counter++; 
+        letterCounter++;
         traverser++; 
     }
+    counter = letterCounter;
+    while (is_identifier_char(*traverser)) {
+        counter++;
+        traverser++;
+    }
 
-    // Check if the function name is a known keyword constant (e or pi)
+    // Check if the name is a known keyword constant (e or pi) or function
+    const ReservedName* reserved = (counter == letterCounter) ? find_reserved_name(lexemmeStart, counter) : NULL;
 
-    if (counter == 1 && (strncmp(lexemmeStart, "e", 1) == 0)) {
+    if (reserved != NULL && reserved->typeToken != TOKEN_FUNCTION) {
         // Check if the keyword is not followed by a valid character
-        if (!is_operator_or_paren(*traverser) && *traverser != ' ' && *traverser != '\0') { 
+        if (!is_operator_or_paren(*traverser) && *traverser != ' ' && !is_source_end(*traverser)) { 
             // Report the invalid keyword syntax and terminate the program
-            fprintf(stderr, "\nError: invalid character after keyword at '%.*s'.\n", counter+1, lexemmeStart);
-            return NULL;
+            report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), counter+1,
+                         "\nError: invalid character after keyword at '%.*s'.\n", counter+1, lexemmeStart);
+            return -1;
         }
-        // Create and return valid number token. If NULL, lexer_analyzer will flag it.
-        return create_token(TOKEN_KEYWORD_E, lexemmeStart, counter);
+        *typeToken = reserved->typeToken;
+        *typeFunction = FUNCTION_INVALID;
+        return counter;
     }
-    if (counter == 2 && (strncmp(lexemmeStart, "pi", 2) == 0)) {
-        // Check if the keyword is not followed by a valid character
-        if (!is_operator_or_paren(*traverser) && *traverser != ' ' && *traverser != '\0') { 
-            // Report the invalid keyword syntax and terminate the program
-            fprintf(stderr, "\nError: invalid character after keyword at '%.*s'.\n", counter+1, lexemmeStart);
-            return NULL;
+
+    if (reserved != NULL) {
+        // Check if the function is not followed by a valid character
+        if (*traverser != '(') { 
+            // Report the invalid function syntax and terminate the program
+            report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), counter+1,
+                         "\nError: invalid character after function at '%.*s'.\n", counter+1, lexemmeStart);
+            return -1;
         }
-        // Create and return valid number token. If NULL, lexer_analyzer will flag it.
-        return create_token(TOKEN_KEYWORD_PI, lexemmeStart, counter);
+        *typeToken = TOKEN_FUNCTION;
+        *typeFunction = reserved->typeFunction;
+        return counter;
+    }
+
+    // Any name followed by a parenthesis that is not a reserved function is an unknown function
+    if (*traverser == '(') {
+        report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), counter,
+                     "\nError: invalid function name at '%.*s'.\n", counter, lexemmeStart);
+        return -1;
+    }
+
+    // Otherwise the name is a variable. Check if the variable is not followed by a valid character
+    if (!is_operator_or_paren(*traverser) && *traverser != ' ' && !is_source_end(*traverser)) { 
+        // Report the invalid variable syntax and terminate the program
+        report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), counter+1,
+                     "\nError: invalid character after variable at '%.*s'.\n", counter+1, lexemmeStart);
+        return -1;
     }
 
+    *typeToken = TOKEN_VARIABLE;
+    *typeFunction = FUNCTION_INVALID;
+    return counter;
+
+}
+
 
-    // Check if the function is not followed by a valid character
-    if (*traverser != '(') { 
-        // Report the invalid function syntax and terminate the program
-        fprintf(stderr, "\nError: invalid character after function at '%.*s'.\n", counter+1, lexemmeStart);
+// Is called when lexer identifies a letter: reads the name (see read_name), then adds a new function, keyword or
+// variable token to `tokenList`. Returns its pointer, or NULL upon errors (fatal).
+static inline Token* scan_function(char* lexemmeStart, TokenList* tokenList) {
+
+    TypeToken typeToken;
+    TypeFunction typeFunction;
+    int length = read_name(lexemmeStart, tokenList->sourceString, &typeToken, &typeFunction);
+    if (length < 0) {
         return NULL;
     }
 
-    // Create and return valid function token. If NULL, lexer_analyzer will flag it.
-    return create_token(TOKEN_FUNCTION, lexemmeStart, counter);
+    // If NULL, lexer_analyzer will flag it.
+    Token* token = add_token(tokenList, typeToken, lexemmeStart, length);
+    if (token != NULL) {
+        token->typeFunction = (unsigned char)typeFunction;
+    }
+    return token;
+}
+
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define LEX_BLOCKS
+
+// Source strings are classified LEX_BLOCK_BYTES characters at a time into one bit per character for each class, with
+// SSE2 (16 characters per instruction, always available on x86-64) or AVX2 (32) when the CPU supports it
+#define LEX_BLOCK_BYTES 64
+
+
+// Structure for the classes of the characters of a block: bit i is set when character i is a space, an operator or
+// parenthesis, a digit, or a letter. Characters in none of the classes are invalid.
+typedef struct LexBlock {
+    unsigned long long spaces;
+    unsigned long long punctuation;
+    unsigned long long digits;
+    unsigned long long letters;
+} LexBlock;
+
+
+// Token types of the operators and parentheses, indexed by character - '(' ("()*+,-./")
+static const unsigned char PUNCTUATION_TYPES[8] = {
+    TOKEN_OPEN_PARENTHESIS, TOKEN_CLOSED_PARENTHESIS, TOKEN_OPERATOR_MULTIPLY, TOKEN_OPERATOR_PLUS,
+    TOKEN_EOF, TOKEN_OPERATOR_MINUS, TOKEN_EOF, TOKEN_OPERATOR_DIVIDE
+};
+
+
+// Classifies the LEX_BLOCK_BYTES characters at `block` into `lexBlock`, 16 at a time. Ranges are compared as signed
+// bytes, characters above 127 are negative and fall in no class.
+static void classify_block_sse2(const char* block, LexBlock* lexBlock) {
+
+    lexBlock->spaces = 0;
+    lexBlock->punctuation = 0;
+    lexBlock->digits = 0;
+    lexBlock->letters = 0;
+    for (int i = 0; i < LEX_BLOCK_BYTES; i += 16) {
+        __m128i characters = _mm_loadu_si128((const __m128i*)(block + i));
+        __m128i punctuation = _mm_and_si128(_mm_cmpgt_epi8(characters, _mm_set1_epi8('(' - 1)),
+                                            _mm_cmplt_epi8(characters, _mm_set1_epi8('/' + 1)));
+        punctuation = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi8(characters, _mm_set1_epi8(',')),
+                                                    _mm_cmpeq_epi8(characters, _mm_set1_epi8('.'))), punctuation);
+        __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(characters, _mm_set1_epi8('0' - 1)),
+                                       _mm_cmplt_epi8(characters, _mm_set1_epi8('9' + 1)));
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(characters, _mm_set1_epi8('a' - 1)),
+                                        _mm_cmplt_epi8(characters, _mm_set1_epi8('z' + 1)));
+
+        lexBlock->spaces |= (unsigned long long)(unsigned)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(characters, _mm_set1_epi8(' '))) << i;
+        lexBlock->punctuation |= (unsigned long long)(unsigned)_mm_movemask_epi8(punctuation) << i;
+        lexBlock->digits |= (unsigned long long)(unsigned)_mm_movemask_epi8(digits) << i;
+        lexBlock->letters |= (unsigned long long)(unsigned)_mm_movemask_epi8(letters) << i;
+    }
 }
 
 
-int lexical_analyzer(char* sourceString, TokenList* tokenList) {
+// Same as classify_block_sse2, 32 characters at a time.
+__attribute__((target("avx2")))
+static void classify_block_avx2(const char* block, LexBlock* lexBlock) {
+
+    lexBlock->spaces = 0;
+    lexBlock->punctuation = 0;
+    lexBlock->digits = 0;
+    lexBlock->letters = 0;
+    for (int i = 0; i < LEX_BLOCK_BYTES; i += 32) {
+        __m256i characters = _mm256_loadu_si256((const __m256i*)(block + i));
+        __m256i punctuation = _mm256_and_si256(_mm256_cmpgt_epi8(characters, _mm256_set1_epi8('(' - 1)),
+                                               _mm256_cmpgt_epi8(_mm256_set1_epi8('/' + 1), characters));
+        punctuation = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi8(characters, _mm256_set1_epi8(',')),
+                                                          _mm256_cmpeq_epi8(characters, _mm256_set1_epi8('.'))),
+                                          punctuation);
+        __m256i digits = _mm256_and_si256(_mm256_cmpgt_epi8(characters, _mm256_set1_epi8('0' - 1)),
+                                          _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), characters));
+        __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(characters, _mm256_set1_epi8('a' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), characters));
+
+        lexBlock->spaces |= (unsigned long long)(unsigned)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(characters, _mm256_set1_epi8(' '))) << i;
+        lexBlock->punctuation |= (unsigned long long)(unsigned)_mm256_movemask_epi8(punctuation) << i;
+        lexBlock->digits |= (unsigned long long)(unsigned)_mm256_movemask_epi8(digits) << i;
+        lexBlock->letters |= (unsigned long long)(unsigned)_mm256_movemask_epi8(letters) << i;
+    }
+}
 
-    // Validating function parameters
-    if (sourceString == NULL || tokenList == NULL || tokenList->array == NULL) {
-        return ERROR_INVALID_FUNCTION_PARAMETERS; 
+
+// Returns the index of the first character from character `i` of a block whose bit is not set in `classMask`, or
+// LEX_BLOCK_BYTES when the run reaches the end of the block (a run filling the whole block stops at its last character,
+// which is then still in the class: callers only end tokens before a space or punctuation character).
+static inline int find_run_end(unsigned long long classMask, int i) {
+    return i + __builtin_ctzll(~(classMask >> i) | (1ULL << (LEX_BLOCK_BYTES - 1)));
+}
+
+
+// Digits of a number that always convert exactly through the fast path of read_number (below 2^53)
+#define MAX_BLOCK_NUMBER_DIGITS 15
+
+
+// Scans the number starting at character `i` of a block from the digit bits of `lexBlock`. Plain numbers ending within
+// the block before a space, an operator or a parenthesis, with at most MAX_BLOCK_NUMBER_DIGITS digits, are converted
+// directly (to the same value as read_number); any other number is read by scan_number. Returns the new token, NULL
+// upon errors (fatal).
+static inline Token* scan_block_number(char* block, int i, LexBlock* lexBlock, TokenList* tokenList) {
+
+    int end = find_run_end(lexBlock->digits, i);
+    int digitCount = end - i;
+    if (end < LEX_BLOCK_BYTES - 1 && block[end] == '.') {
+        int fractionEnd = find_run_end(lexBlock->digits, end + 1);
+        if (fractionEnd == end + 1) {
+            return scan_number(block + i, tokenList);  // Reports the missing fractional digits
+        }
+        digitCount += fractionEnd - end - 1;
+        end = fractionEnd;
+    }
+    if (end >= LEX_BLOCK_BYTES || digitCount > MAX_BLOCK_NUMBER_DIGITS ||
+        !((lexBlock->spaces | lexBlock->punctuation) & (1ULL << end))) {
+        return scan_number(block + i, tokenList);
     }
 
-    // Pointer to traverse the source string
+    unsigned long long mantissa = 0;
+    int fractionDigits = 0;
+    for (char* traverser = block + i; traverser < block + end; traverser++) {
+        if (*traverser == '.') {
+            fractionDigits = (int)(block + end - traverser) - 1;
+            continue;
+        }
+        mantissa = mantissa * 10 + (unsigned long long)(*traverser - '0');
+    }
+
+    Token* token = add_token(tokenList, TOKEN_NUMBER, block + i, end - i);
+    if (token != NULL) {
+        token->slot = tokenList->numberCount;
+        tokenList->numberValues[tokenList->numberCount++] = (double)mantissa / powersOfTen[fractionDigits];
+    }
+    return token;
+}
+
+
+// Scans the name starting at character `i` of a block from the letter bits of `lexBlock`. Names of letters only ending
+// within the block before a space, an operator or a parenthesis are looked up directly: functions followed by '(',
+// keywords, and variables not followed by '(' are added; any other name is read by scan_function (which reports the
+// errors). Returns the new token, NULL upon errors (fatal).
+static inline Token* scan_block_name(char* block, int i, LexBlock* lexBlock, TokenList* tokenList) {
+
+    int end = find_run_end(lexBlock->letters, i);
+    if (end >= LEX_BLOCK_BYTES || !((lexBlock->spaces | lexBlock->punctuation) & (1ULL << end))) {
+        return scan_function(block + i, tokenList);
+    }
+
+    const ReservedName* reserved = find_reserved_name(block + i, end - i);
+    TypeToken typeToken = (reserved != NULL) ? reserved->typeToken : TOKEN_VARIABLE;
+    if ((typeToken == TOKEN_FUNCTION) != (block[end] == '(')) {
+        return scan_function(block + i, tokenList);
+    }
+
+    Token* token = add_token(tokenList, typeToken, block + i, end - i);
+    if (token != NULL && reserved != NULL) {
+        token->typeFunction = (unsigned char)reserved->typeFunction;
+    }
+    return token;
+}
+
+
+// Scans the tokens starting in the LEX_BLOCK_BYTES characters at `block` into `tokenList`, finding the class of each
+// character from the bits of the block (classified with AVX2 if `avx2` is set): runs of spaces are skipped at once,
+// operators and parentheses are added directly, plain numbers and names are delimited by the digit and letter bits
+// (scan_block_number, scan_block_name), other ones are read as by the scalar loop (a token may end past the block).
+// Returns the number of characters consumed, -1 upon errors (fatal).
+static int scan_block(char* block, TokenList* tokenList, int avx2) {
+
+    LexBlock lexBlock;
+    if (avx2) {
+        classify_block_avx2(block, &lexBlock);
+    }
+    else {
+        classify_block_sse2(block, &lexBlock);
+    }
+
+    int i = 0;
+    while (i < LEX_BLOCK_BYTES) {
+        unsigned long long bit = 1ULL << i;
+        Token* newToken;
+
+        if (lexBlock.spaces & bit) {
+            unsigned long long nonSpaces = ~lexBlock.spaces >> i;
+            if (nonSpaces == 0) {
+                return LEX_BLOCK_BYTES;
+            }
+            i += __builtin_ctzll(nonSpaces);
+            continue;
+        }
+        if (lexBlock.punctuation & bit) {
+            newToken = add_token(tokenList, (TypeToken)PUNCTUATION_TYPES[block[i] - '('], block + i, 1);
+        }
+        else if (lexBlock.digits & bit) {
+            newToken = scan_block_number(block, i, &lexBlock, tokenList);
+        }
+        else if (lexBlock.letters & bit) {
+            newToken = scan_block_name(block, i, &lexBlock, tokenList);
+        }
+        else {
+            report_error(ERROR_CODE_SYNTAX, (int)(block + i - tokenList->sourceString), 1,
+                         "\nError: invalid character at '%.*s'.\n", 1, block + i);
+            return -1;
+        }
+        if (newToken == NULL) {
+            return -1;
+        }
+        i += newToken->length;
+    }
+
+    return i;
+}
+
+#endif
+
+
+// Scans the `sourceLength` characters of `sourceString` into `tokenList`, see lexical_analyzer_length.
+// Returns 0 upon success, 1 upon errors.
+static int scan_source(char* sourceString, int sourceLength, TokenList* tokenList) {
+
+    // Make sure the list has room for every token of the source string, growing it only if needed
+    if (sourceLength + 1 > tokenList->maxCapacity) {
+        if (allocate_tokenList(tokenList, sourceLength) == 1) {
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+    }
+
+    // Discard the tokens of any previous source string
+    tokenList->sourceString = sourceString;
+    tokenList->position = -1;
+    tokenList->numberCount = 0;
+
+    // Pointer to traverse the source string, up to its end
     char* pTraverse = sourceString;
+    char* pSourceEnd = sourceString + sourceLength;
+
+#if defined(LEX_BLOCKS)
+    int avx2 = __builtin_cpu_supports("avx2");
+#endif
 
     // Main scanning loop for the lexer.
-    while (*pTraverse != '\0') {
+    while (pTraverse < pSourceEnd) {
+
+#if defined(LEX_BLOCKS)
+        // While a whole block is left, tokens are found from the classes of its characters
+        if (pSourceEnd - pTraverse >= LEX_BLOCK_BYTES) {
+            int scanned = scan_block(pTraverse, tokenList, avx2);
+            if (scanned < 0) {
+                return ERROR_FATAL_FUNCTION_CALL;
+            }
+            pTraverse += scanned;
+            continue;
+        }
+#endif
 
-        // Check if token found in current loop iteration and declare potential token struct
-        int tokenFound = 0;
+        // Declare potential token struct found in current loop iteration 
         Token* newToken = NULL; 
 
         // Switch case to determine the token type of the current character
         switch (*pTraverse) {
             case ' ': 
-                pTraverse++; break; //current element is whitespace, ignore it and move on
+                pTraverse++; continue; //current element is whitespace, ignore it and move on
             case '(': 
-                newToken = create_token(TOKEN_OPEN_PARENTHESIS, pTraverse, 1); tokenFound = 1;
+                newToken = add_token(tokenList, TOKEN_OPEN_PARENTHESIS, pTraverse, 1);
                 pTraverse++; break;
             case ')':
-                newToken = create_token(TOKEN_CLOSED_PARENTHESIS, pTraverse, 1); tokenFound = 1;
+                newToken = add_token(tokenList, TOKEN_CLOSED_PARENTHESIS, pTraverse, 1);
                 pTraverse++; break;
             case '*':
-                newToken = create_token(TOKEN_OPERATOR_MULTIPLY, pTraverse, 1); tokenFound = 1;
+                newToken = add_token(tokenList, TOKEN_OPERATOR_MULTIPLY, pTraverse, 1);
                 pTraverse++; break;
             case '/':
-                newToken = create_token(TOKEN_OPERATOR_DIVIDE, pTraverse, 1); tokenFound = 1;
+                newToken = add_token(tokenList, TOKEN_OPERATOR_DIVIDE, pTraverse, 1);
                 pTraverse++; break;
             case '+':
-                newToken = create_token(TOKEN_OPERATOR_PLUS, pTraverse, 1); tokenFound = 1;
+                newToken = add_token(tokenList, TOKEN_OPERATOR_PLUS, pTraverse, 1);
                 pTraverse++; break;
             case '-':
-                newToken = create_token(TOKEN_OPERATOR_MINUS, pTraverse, 1); tokenFound = 1;
+                newToken = add_token(tokenList, TOKEN_OPERATOR_MINUS, pTraverse, 1);
                 pTraverse++; break;
             default:
                 // When digit is encountered, run following logic to determine if number
                 if (is_digit(*pTraverse)) {
-                    newToken = scan_number(pTraverse);
+                    newToken = scan_number(pTraverse, tokenList);
                     if (newToken == NULL) {
                         // NULL return from this function should terminate the program
                         return ERROR_FATAL_FUNCTION_CALL;
                     }
-                    tokenFound = 1;
                     pTraverse += newToken->length;
                     break;
                 }
-                // When letter is encountered, run following logic to determine if function
+                // When letter is encountered, run following logic to determine if function, keyword or variable
                 else if (is_alpha(*pTraverse)) {
-                    newToken = scan_function(pTraverse);
+                    newToken = scan_function(pTraverse, tokenList);
                     if (newToken == NULL) {
                         return ERROR_FATAL_FUNCTION_CALL;
                     }
-                    tokenFound = 1;
                     pTraverse += newToken->length;
                     break;
                 }
                 // Current character is unrecognizeable. Report and terminate the program.
-                fprintf(stderr, "\nError: invalid character at '%.*s'.\n", 1, pTraverse);
+                report_error(ERROR_CODE_SYNTAX, (int)(pTraverse - sourceString), 1,
+                             "\nError: invalid character at '%.*s'.\n", 1, pTraverse);
                 return ERROR_INVALID_PROGRAM_USAGE;
         }
 
-        if (tokenFound) {
-        
-            // Checks for fatal create_token errors for non-default cases in switch-case
-            if (newToken == NULL) {
-                return ERROR_FATAL_FUNCTION_CALL;
-            }
-
-            // Add token to the TokenList struct. Any errors here should terminate the program
-            int addToken = add_token_to_list(tokenList, newToken);
-            if (addToken == 1) {
-                free(newToken);
-                newToken = NULL;
-                return ERROR_FATAL_FUNCTION_CALL;
-            }
+        // Checks for fatal add_token errors for non-default cases in switch-case
+        if (newToken == NULL) {
+            return ERROR_FATAL_FUNCTION_CALL;
         }
     
     }
 
-    // Create an EOF token after main scanning loop has ran. 
+    // Add an EOF token (the end of the source string) after main scanning loop has ran. 
     // Upon error, terminate program and free TokenList struct and related memory in main.c.
-    Token* lastToken = create_token(TOKEN_EOF, "\0", 1);
+    Token* lastToken = add_token(tokenList, TOKEN_EOF, pTraverse, 1);
     if (lastToken == NULL) {
         return ERROR_FATAL_FUNCTION_CALL; 
     }
 
-    // Add EOF token to TokenList struct. 
-    // Upon error, terminate program and free TokenList struct and related memory in main.c.
-    int addToken = add_token_to_list(tokenList, lastToken);
-    if (addToken == 1) {
-        free(lastToken);
-        lastToken = NULL; 
-        return ERROR_FATAL_FUNCTION_CALL;
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int lexical_analyzer(char* sourceString, TokenList* tokenList) {
+
+    // Validating function parameters
+    if (sourceString == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS; 
+    }
+
+    size_t sourceLength = strlen(sourceString);
+    if (sourceLength >= INT_MAX) {
+        report_error(ERROR_CODE_SYNTAX, -1, 0, "\nError: expression too long.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    return lexical_analyzer_length(sourceString, (int)sourceLength, tokenList);
+}
+
+
+int lexical_analyzer_length(char* sourceString, int sourceLength, TokenList* tokenList) {
+
+    // Validating function parameters
+    if (sourceString == NULL || sourceLength < 0 || sourceLength == INT_MAX || tokenList == NULL ||
+        tokenList->array == NULL || !is_source_end(sourceString[sourceLength])) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS; 
+    }
+
+    unsigned long long start = start_statistics_phase();
+    int scan = scan_source(sourceString, sourceLength, tokenList);
+    end_statistics_phase(STATISTICS_PHASE_LEX, start);
+
+    if (scan == 0 && start != 0) {
+        count_statistics(STATISTICS_TOKENS, tokenList->position + 1);
+        count_statistics(STATISTICS_NUMBERS, tokenList->numberCount);
+    }
+    return scan;
+}
+
+
+int scan_token(char* sourceString, int offset, Token* token, double* number) {
+
+    // Validating function parameters
+    if (sourceString == NULL || offset < 0 || token == NULL || number == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Skip the whitespace before the token
+    char* lexemmeStart = sourceString + offset;
+    while (*lexemmeStart == ' ') {
+        lexemmeStart++;
     }
 
+    TypeToken typeToken;
+    TypeFunction typeFunction = FUNCTION_INVALID;
+    int length = 1;
+    switch (*lexemmeStart) {
+        case '(': typeToken = TOKEN_OPEN_PARENTHESIS; break;
+        case ')': typeToken = TOKEN_CLOSED_PARENTHESIS; break;
+        case '*': typeToken = TOKEN_OPERATOR_MULTIPLY; break;
+        case '/': typeToken = TOKEN_OPERATOR_DIVIDE; break;
+        case '+': typeToken = TOKEN_OPERATOR_PLUS; break;
+        case '-': typeToken = TOKEN_OPERATOR_MINUS; break;
+        case '^': typeToken = TOKEN_OPERATOR_POWER; break;
+        default:
+            if (is_source_end(*lexemmeStart)) {
+                typeToken = TOKEN_EOF;
+                break;
+            }
+            if (is_digit(*lexemmeStart)) {
+                typeToken = TOKEN_NUMBER;
+                length = read_number(lexemmeStart, sourceString, number);
+            }
+            else if (is_alpha(*lexemmeStart)) {
+                length = read_name(lexemmeStart, sourceString, &typeToken, &typeFunction);
+            }
+            else {
+                report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), 1,
+                             "\nError: invalid character at '%.*s'.\n", 1, lexemmeStart);
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            if (length < 0) {
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            if (length > MAX_LEXEMME_LENGTH) {
+                report_error(ERROR_CODE_SYNTAX, (int)(lexemmeStart - sourceString), length,
+                             "\nError: lexemme too long at '%.*s'.\n", 16, lexemmeStart);
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            break;
+    }
+
+    token->offset = (int)(lexemmeStart - sourceString);
+    token->length = (unsigned short)length;
+    token->typeToken = (unsigned char)typeToken;
+    token->typeFunction = (unsigned char)typeFunction;
+    token->slot = -1;
+
     // Subroutine ran successfully
     return 0;
 }
@@ -419,7 +938,7 @@ int print_tokenList(TokenList* tokenList) {
 
     printf("\n");
     for (int i = 0; i < tokenList->position + 1; i++) {
-        int printOutput = print_token(tokenList->array[i]); 
+        int printOutput = print_token(tokenList, &tokenList->array[i]); 
         if (printOutput == 1) {
             // Errors are fatal and memory is freed in main.c
             return ERROR_FATAL_FUNCTION_CALL;
@@ -431,30 +950,45 @@ int print_tokenList(TokenList* tokenList) {
 }
 
 
+int copy_tokenList(TokenList* tokenList, TokenList* tokenListCopy) {
+
+    // Validating function parameters
+    if (tokenList == NULL || tokenList->array == NULL || tokenListCopy == NULL || tokenListCopy->array == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // The copy gets the same capacities, so it also has room for the values of folded constants
+    if (tokenListCopy->maxCapacity < tokenList->maxCapacity &&
+        allocate_tokenList(tokenListCopy, tokenList->maxCapacity - 1) != 0) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    memcpy(tokenListCopy->array, tokenList->array, (size_t)(tokenList->position + 1) * sizeof(Token));
+    memcpy(tokenListCopy->numberValues, tokenList->numberValues, (size_t)tokenList->numberCount * sizeof(double));
+    tokenListCopy->sourceString = tokenList->sourceString;
+    tokenListCopy->position = tokenList->position;
+    tokenListCopy->numberCount = tokenList->numberCount;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
 int free_tokenList_memory(TokenList* tokenList) {
 
     // Validating function parameters. Errors are fatal and should terminate program.
-    if (tokenList == NULL || tokenList->array == NULL || tokenList->position < 0) {
+    if (tokenList == NULL || tokenList->array == NULL) {
         return ERROR_INVALID_FUNCTION_PARAMETERS; 
     }
 
-    // Free each token in the array
-    for (int i = 0; i < tokenList->position + 1; i++) {
-        if (tokenList->array[i] != NULL) { // Check if token is valid before freeing
-            tokenList->array[i]->pLexemmeStart = NULL; 
-            free(tokenList->array[i]); 
-            tokenList->array[i] = NULL; 
-        }
-    }
-
-    // Free the token array itself (recall its a dynamic (pointer) array of pointers to tokens)
+    // Free the single block holding the tokens and the number values
     free(tokenList->array);
     tokenList->array = NULL;
+    tokenList->numberValues = NULL;
+    tokenList->sourceString = NULL;
+    tokenList->position = -1;
 
     // Subroutine ran successfully
     return 0;
 
 }
-
-
-
@@ -1,103 +1,587 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <windows.h>
 #include <errno.h>
 
 #include "errors.h"
 #include "lex.h"
 #include "parser.h"
+#include "expression.h"
+#include "thread_pool.h"
+#include "timer.h"
+#include "statistics.h"
+#include "stream.h"
+#include "mapped_file.h"
+#include "program_file.h"
+#include "gradient.h"
+#include "pratt.h"
 
 
+// Splits the "name=value" string `argument` at the '=' (`argument` is left holding the name) and converts the value
+// into `value`. Returns 0 upon success, 1 upon errors (an error message is printed). Errors are fatal.
+static int split_variable_argument(char* argument, double* value) {
 
-int main(int argc, char *argv[]) {
+    char* equals = strchr(argument, '=');
+    if (equals == NULL || equals == argument || *(equals+1) == '\0') {
+        fprintf(stderr, "\nError: invalid variable assignment '%s'. Expected name=value.\n\n", argument);
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    *equals = '\0';
+
+    // Convert the value, the whole remaining string must be a number
+    char* valueEnd;
+    *value = strtod(equals+1, &valueEnd);
+    if (*valueEnd != '\0') {
+        fprintf(stderr, "\nError: invalid value '%s' for variable '%s'.\n\n", equals+1, argument);
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
 
+    // Subroutine ran successfully
+    return 0;
+}
 
-    // To benchmark the performance of the executable
-    LARGE_INTEGER frequency, start, end;
-    double elapsedTime;
-    QueryPerformanceFrequency(&frequency); // Get the high-resolution counter's frequency (ticks per second)
-    QueryPerformanceCounter(&start); // Start timing
 
-    // Check for incorrect program call
-    if (argc < 2) {
-        fprintf(stderr, "\nError: Incorrect usage. Correct usage: .\\math_evaluator.exe \"expression\".\n\n");
+// Parses the `argumentCount` "name=value" strings in `arguments` and stores each value in `variableValues` at the
+// slot of the named variable, its index in the `variableCount` names of `variableNames`. Every variable of the
+// expression must be given a value. Returns 0 upon success, 1 upon errors (an error message is printed). Errors are
+// fatal.
+static int bind_variable_arguments(char** variableNames, int variableCount, int argumentCount, char** arguments,
+                                   double* variableValues, int* variableBound) {
+
+    for (int i = 0; i < argumentCount; i++) {
+
+        double value;
+        if (split_variable_argument(arguments[i], &value) != 0) {
+            return ERROR_INVALID_PROGRAM_USAGE;
+        }
+        int slot = 0;
+        while (slot < variableCount && strcmp(variableNames[slot], arguments[i]) != 0) {
+            slot++;
+        }
+        if (slot == variableCount) {
+            fprintf(stderr, "\nError: expression has no variable named '%s'.\n\n", arguments[i]);
+            return ERROR_INVALID_PROGRAM_USAGE;
+        }
+        variableValues[slot] = value;
+        variableBound[slot] = 1;
+    }
+
+    // Check that every variable in the expression was given a value
+    for (int slot = 0; slot < variableCount; slot++) {
+        if (!variableBound[slot]) {
+            fprintf(stderr, "\nError: no value given for variable '%s'.\n\n", variableNames[slot]);
+            return ERROR_INVALID_PROGRAM_USAGE;
+        }
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+
+// File the statistics are written to when the program exits (stderr if NULL), set by --stats=file
+static char* statisticsFileName = NULL;
+
+
+// Writes the statistics recorded during the run as JSON (registered with atexit by the --stats option).
+static void write_statistics_at_exit(void) {
+
+    Statistics statistics;
+    get_statistics(&statistics);
+
+    FILE* output = statisticsFileName != NULL ? fopen(statisticsFileName, "w") : stderr;
+    if (output == NULL) {
+        fprintf(stderr, "\nError: could not open '%s'.\n\n", statisticsFileName);
+        return;
+    }
+    write_statistics_json(&statistics, output);
+    if (output != stderr) {
+        fclose(output);
+    }
+}
+
+
+
+// Runs the streaming mode: `--stream [file] [--threads count]`. Reads expressions from `file`, or from stdin if no file
+// (or "-") is given. With `--threads`, the lines are evaluated by `count` threads (0 for one per processor).
+// Returns 0 if every line was evaluated, 1 if some lines failed or the input could not be read.
+static int run_stream_mode(int argc, char *argv[]) {
+
+    // Split the arguments after --stream into the file name and the thread count
+    char* fileName = NULL;
+    int threadCount = -1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc && threadCount == -1) {
+            char* countEnd;
+            long count = strtol(argv[++i], &countEnd, 10);
+            if (*countEnd != '\0' || count < 0 || count > 1024) {
+                fprintf(stderr, "\nError: invalid thread count '%s'.\n\n", argv[i]);
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            threadCount = (int)count;
+        }
+        else if (fileName == NULL) {
+            fileName = argv[i];
+        }
+        else {
+            fprintf(stderr, "\nError: Incorrect usage. Correct usage: .\\math_evaluator.exe --stream [file] "
+                            "[--threads count].\n\n");
+            return ERROR_INVALID_PROGRAM_USAGE;
+        }
+    }
+
+    // Map the input file into memory when possible, otherwise open it (stdin is used when no file is given)
+    MappedFile mappedFile;
+    int mapped = fileName != NULL && strcmp(fileName, "-") != 0 &&
+                 map_file(fileName, ACCESS_SEQUENTIAL, &mappedFile) == 0;
+    FILE* input = stdin;
+    if (!mapped && fileName != NULL && strcmp(fileName, "-") != 0) {
+        input = fopen(fileName, "r");
+        if (input == NULL) {
+            fprintf(stderr, "\nError: could not open '%s'.\n\n", fileName);
+            return ERROR_INVALID_PROGRAM_USAGE;
+        }
+    }
+
+    // Results are written in large blocks rather than line by line
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+
+    int failedLines;
+    int streamOutput;
+    ThreadPool threadPool;
+    if (threadCount == -1) {
+        streamOutput = mapped ? evaluate_text(mappedFile.data, mappedFile.size, mappedFile.nullTerminated, stdout,
+                                              NULL, &failedLines)
+                              : evaluate_stream(input, stdout, &failedLines);
+    }
+    else if ((streamOutput = init_threadPool(&threadPool, threadCount)) == 0) {
+        streamOutput = mapped ? evaluate_text(mappedFile.data, mappedFile.size, mappedFile.nullTerminated, stdout,
+                                              &threadPool, &failedLines)
+                              : evaluate_stream_parallel(input, stdout, &threadPool, &failedLines);
+        free_threadPool_memory(&threadPool);
+    }
+    if (mapped) {
+        free_mappedFile_memory(&mappedFile);
+    }
+    if (input != stdin) {
+        fclose(input);
+    }
+    fflush(stdout);
+
+    if (streamOutput == 1) {
+        fprintf(stderr, "Fatal error: input stream could not be processed.\n\n");
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    return (failedLines > 0) ? ERROR_INVALID_PROGRAM_USAGE : 0;
+}
+
+
+
+// Runs the expression streaming mode: `--stream-expression file [name=value ...]` (`-` for stdin). Evaluates the
+// expression on the first line of the file as it is read, in memory bounded by its nesting depth rather than its
+// length, and prints the result like the streaming mode. Returns 0 upon success, 1 upon errors (a message is printed).
+static int run_stream_expression_mode(int argc, char *argv[]) {
+
+    if (argc < 3) {
+        fprintf(stderr, "\nError: Incorrect usage. Correct usage: .\\math_evaluator.exe --stream-expression file "
+                        "[name=value ...].\n\n");
         return ERROR_INVALID_PROGRAM_USAGE;
     }
-    else if (argc > 2) {
-        fprintf(stderr, "\nError: Incorrect usage. Maximum of one expression allowed.\n\n");
+
+    // The variables are named by the arguments, each name is looked up as the expression is read
+    int variableCount = argc - 3;
+    char** variableNames = &argv[3];
+    double* variableValues = calloc(variableCount + 1, sizeof(double));
+    if (variableValues == NULL) {
+        fprintf(stderr, "Fatal error: memory could not be allocated.\n\n");
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    for (int i = 0; i < variableCount; i++) {
+        if (split_variable_argument(variableNames[i], &variableValues[i]) != 0) {
+            free(variableValues);
+            return ERROR_INVALID_PROGRAM_USAGE;
+        }
+    }
+
+    FILE* input = strcmp(argv[2], "-") == 0 ? stdin : fopen(argv[2], "rb");
+    if (input == NULL) {
+        fprintf(stderr, "\nError: could not open '%s'.\n\n", argv[2]);
+        free(variableValues);
         return ERROR_INVALID_PROGRAM_USAGE;
     }
 
+    double result;
+    int status = evaluate_stream_expression(input, variableNames, variableValues, variableCount, &result);
+    if (status == 0) {
+        printf("%.17g\n", result);
+    }
+    else {
+        fprintf(stderr, "Fatal error: expression could not be evaluated.\n\n");
+    }
 
-    //-----------------------------------------------------------------------------------------------------------//
-    //-----------------------------------------  MAIN LOGIC BEGINS  ---------------------------------------------//
-    //-----------------------------------------------------------------------------------------------------------//
+    if (input != stdin) {
+        fclose(input);
+    }
+    free(variableValues);
 
+    return status;
+}
 
-    // Begin the lexical analysis part
 
-    // Create and initialize instance of TokenList
-    TokenList tokenList;
-    int initTokenList = init_tokenList(&tokenList);
-    if (initTokenList == 1) {
-        fprintf(stderr, "Fatal error: token list could not be created.\n\n");
-        return ERROR_FATAL_FUNCTION_CALL;
+
+// Runs the compile mode: `--compile file output`. Compiles every non-blank line of `file` and writes the compiled
+// expressions to the program file `output` (see program_file.h), which later runs map instead of compiling again
+// (see the program mode).
+// Returns 0 if every line was compiled and the file written, 1 otherwise.
+static int run_compile_mode(int argc, char *argv[]) {
+
+    if (argc != 4) {
+        fprintf(stderr, "\nError: Incorrect usage. Correct usage: .\\math_evaluator.exe --compile file output.\n\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    FILE* input = fopen(argv[2], "rb");
+    if (input == NULL) {
+        fprintf(stderr, "\nError: could not open '%s'.\n\n", argv[2]);
+        return ERROR_INVALID_PROGRAM_USAGE;
     }
 
-    // Perform lexical analysis on input string (argv[1])
-    int lexerOutput = lexical_analyzer(argv[1], &tokenList);
-    if (lexerOutput == 1) {
-        fprintf(stderr, "Fatal error: lexical analysis could not be run.\n\n");
-        free_tokenList_memory(&tokenList);
+    // Read the whole file, the lines are compiled where they are once their line endings are replaced
+    size_t textLength = 0;
+    size_t textCapacity = 1 << 16;
+    char* text = malloc(textCapacity);
+    while (text != NULL) {
+        textLength += fread(text + textLength, 1, textCapacity - 1 - textLength, input);
+        if (textLength < textCapacity - 1) {
+            break;
+        }
+        char* grownText = realloc(text, textCapacity * 2);
+        if (grownText == NULL) {
+            free(text);
+        }
+        text = grownText;
+        textCapacity *= 2;
+    }
+    int readError = ferror(input);
+    fclose(input);
+    CompiledExpression* compiledExpressions = text != NULL ? malloc((textLength / 2 + 1) * sizeof(CompiledExpression))
+                                                           : NULL;
+    if (compiledExpressions == NULL || readError) {
+        fprintf(stderr, "Fatal error: '%s' could not be read.\n\n", argv[2]);
+        free(text);
+        free(compiledExpressions);
         return ERROR_FATAL_FUNCTION_CALL;
     }
+    text[textLength] = '\0';
 
-    // Print the tokenList 
-    int printTokenListOutput = print_tokenList(&tokenList);
-    if (printTokenListOutput == 1) {
-        fprintf(stderr, "Fatal error: token list could not be printed.\n\n");
-        free_tokenList_memory(&tokenList);
+    int status = 0;
+    int count = 0;
+    char* line = text;
+    for (int lineNumber = 1; status == 0 && line < text + textLength; lineNumber++) {
+        char* end = line + strcspn(line, "\r\n");
+        char* next = *end == '\r' && *(end+1) == '\n' ? end + 2 : (*end != '\0' ? end + 1 : end);
+        *end = '\0';
+        if (!is_blank_line(line, (int)(end - line))) {
+            if (compile_expression(line, &compiledExpressions[count]) != 0) {
+                fprintf(stderr, "Error on line %d.\n\n", lineNumber);
+                status = ERROR_INVALID_PROGRAM_USAGE;
+                break;
+            }
+            count++;
+        }
+        line = next;
+    }
+    if (status == 0 && write_programFile(argv[3], compiledExpressions, count) != 0) {
+        fprintf(stderr, "Fatal error: program file '%s' could not be written.\n\n", argv[3]);
+        status = ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    for (int i = 0; i < count; i++) {
+        free_compiledExpression_memory(&compiledExpressions[i]);
+    }
+    free(compiledExpressions);
+    free(text);
+
+    return status;
+}
+
+
+// Runs the program mode: `--program file "expression" [name=value ...]`. Loads the program file `file` (written by
+// the compile mode), finds the program compiled from the expression (written as it was on its line) and evaluates its
+// graph where it is mapped, without compiling anything, then prints the answer.
+// Returns 0 upon success, 1 upon errors (an error message is printed).
+static int run_program_mode(int argc, char *argv[]) {
+
+    if (argc < 4) {
+        fprintf(stderr, "\nError: Incorrect usage. Correct usage: .\\math_evaluator.exe --program file \"expression\" "
+                        "[name=value ...].\n\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    ProgramFile programFile;
+    if (load_programFile(argv[2], &programFile) != 0) {
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    int index = find_programFile_program(&programFile, argv[3]);
+    ExpressionGraph graph;
+    if (index == -1 || get_programFile_graph(&programFile, index, &graph) != 0) {
+        fprintf(stderr, "\nError: '%s' has no program for '%s'.\n\n", argv[2], argv[3]);
+        free_programFile_memory(&programFile);
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    int variableCount = get_programFile_variables(&programFile, index, NULL);
+    const char** variableNames = calloc(variableCount + 1, sizeof(char*));
+    double* variableValues = calloc(variableCount + 1, sizeof(double));
+    int* variableBound = calloc(variableCount + 1, sizeof(int));
+    double* nodeValues = malloc(graph.nodeCount * sizeof(double));
+    int status = 0;
+    if (variableNames == NULL || variableValues == NULL || variableBound == NULL || nodeValues == NULL) {
+        fprintf(stderr, "Fatal error: memory could not be allocated.\n\n");
+        status = ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    else if (get_programFile_variables(&programFile, index, variableNames) != variableCount ||
+             bind_variable_arguments((char**)variableNames, variableCount, argc - 4, &argv[4], variableValues,
+                                     variableBound) != 0) {
+        status = ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    double finalAnswer;
+    if (status == 0 && evaluate_expressionGraph(&graph, variableValues, nodeValues, &finalAnswer) != 0) {
+        fprintf(stderr, "Fatal error: expression could not be evaluated.\n\n");
+        status = ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (status == 0) {
+        printf("\nFinal answer: %.10f.\n\n", finalAnswer);
+    }
+
+    free(variableNames);
+    free(variableValues);
+    free(variableBound);
+    free(nodeValues);
+    free_programFile_memory(&programFile);
+
+    return status;
+}
+
+
+// Runs the gradient mode: `--gradient "expression" [name=value ...]`. Evaluates the expression and its partial
+// derivative with respect to each of its variables in one pass, and prints them.
+// Returns 0 upon success, 1 upon errors (an error message is printed).
+static int run_gradient_mode(int argc, char *argv[]) {
+
+    if (argc < 3) {
+        fprintf(stderr, "\nError: Incorrect usage. Correct usage: .\\math_evaluator.exe --gradient \"expression\" "
+                        "[name=value ...].\n\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    CompiledExpression compiledExpression;
+    if (compile_expression(argv[2], &compiledExpression) != 0) {
+        fprintf(stderr, "Fatal error: expression could not be compiled.\n\n");
         return ERROR_FATAL_FUNCTION_CALL;
     }
+    double* variableValues = calloc(compiledExpression.variableCount + 1, sizeof(double));
+    double* gradient = calloc(compiledExpression.variableCount + 1, sizeof(double));
+    int* variableBound = calloc(compiledExpression.variableCount + 1, sizeof(int));
+    int status = 0;
+    if (variableValues == NULL || gradient == NULL || variableBound == NULL) {
+        fprintf(stderr, "Fatal error: memory could not be allocated.\n\n");
+        status = ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    else if (bind_variable_arguments(compiledExpression.variableNames, compiledExpression.variableCount, argc - 3,
+                                     &argv[3], variableValues, variableBound) != 0) {
+        status = ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    // Value and derivatives with respect to every variable, in slot order
+    double finalAnswer;
+    if (status == 0 && evaluate_compiledExpression_gradient(&compiledExpression, variableValues, NULL, 0, &finalAnswer,
+                                                            gradient) != 0) {
+        fprintf(stderr, "Fatal error: expression could not be evaluated.\n\n");
+        status = ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (status == 0) {
+        printf("\nFinal answer: %.10f.\n", finalAnswer);
+        for (int slot = 0; slot < compiledExpression.variableCount; slot++) {
+            printf("d/d%s: %.10f\n", compiledExpression.variableNames[slot], gradient[slot]);
+        }
+        printf("\n");
+    }
+
+    free(variableValues);
+    free(gradient);
+    free(variableBound);
+    free_compiledExpression_memory(&compiledExpression);
 
+    return status;
+}
 
-    // Begin parsing parting
 
-    // Create and initialize an instance of StackTokenList to represent postfix form of the lexer TokenList.
-    StackTokenList postfixTokenList;
-    int initPostfixList = init_StackTokenList(&tokenList, &postfixTokenList);
-    if (initPostfixList == 1) {
-        fprintf(stderr, "Fatal error: postfix token list could not be initialized.\n\n");
+// Runs the Pratt mode: `--pratt "expression" [name=value ...]`. Compiles the expression into bytecode in a single pass
+// (PRATT module, which also accepts `^` and the unary minus), evaluates it and prints the answer.
+// Returns 0 upon success, 1 upon errors (an error message is printed).
+static int run_pratt_mode(int argc, char *argv[]) {
+
+    if (argc < 3) {
+        fprintf(stderr, "\nError: Incorrect usage. Correct usage: .\\math_evaluator.exe --pratt \"expression\" "
+                        "[name=value ...].\n\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    PrattExpression prattExpression;
+    if (compile_prattExpression(argv[2], &prattExpression) != 0) {
+        fprintf(stderr, "Fatal error: expression could not be compiled.\n\n");
         return ERROR_FATAL_FUNCTION_CALL;
     }
+    double* variableValues = calloc(prattExpression.variableCount + 1, sizeof(double));
+    int* variableBound = calloc(prattExpression.variableCount + 1, sizeof(int));
+    int status = 0;
+    if (variableValues == NULL || variableBound == NULL) {
+        fprintf(stderr, "Fatal error: memory could not be allocated.\n\n");
+        status = ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    else if (bind_variable_arguments(prattExpression.variableNames, prattExpression.variableCount, argc - 3,
+                                     &argv[3], variableValues, variableBound) != 0) {
+        status = ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    double finalAnswer;
+    if (status == 0 && evaluate_prattExpression(&prattExpression, variableValues, &finalAnswer) != 0) {
+        fprintf(stderr, "Fatal error: expression could not be evaluated.\n\n");
+        status = ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (status == 0) {
+        printf("\nFinal answer: %.10f.\n\n", finalAnswer);
+    }
+
+    free(variableValues);
+    free(variableBound);
+    free_prattExpression_memory(&prattExpression);
+
+    return status;
+}
+
+
+int main(int argc, char *argv[]) {
+
+
+    // To time the whole run (see the benchmark target for repeated measurements of each phase)
+    unsigned long long start = get_timer_nanoseconds();
+
+    // Statistics: `--stats` (written to stderr) or `--stats=file` before the other arguments
+    if (argc >= 2 && strncmp(argv[1], "--stats", 7) == 0 && (argv[1][7] == '\0' || argv[1][7] == '=')) {
+        statisticsFileName = argv[1][7] == '=' ? argv[1] + 8 : NULL;
+        enable_statistics(1);
+        atexit(write_statistics_at_exit);
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
+    // Check for incorrect program call
+    if (argc < 2) {
+        fprintf(stderr, "\nError: Incorrect usage. Correct usage: .\\math_evaluator.exe \"expression\" [name=value ...].\n\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    // Streaming mode: evaluate one expression per line of a file (or stdin) and print one result per line
+    if (strcmp(argv[1], "--stream") == 0) {
+        return run_stream_mode(argc, argv);
+    }
+
+    // Expression streaming mode: evaluate one expression too long to hold in memory as it is read
+    if (strcmp(argv[1], "--stream-expression") == 0) {
+        return run_stream_expression_mode(argc, argv);
+    }
+
+    // Gradient mode: evaluate an expression and its derivatives with respect to its variables
+    if (strcmp(argv[1], "--gradient") == 0) {
+        return run_gradient_mode(argc, argv);
+    }
+
+    // Pratt mode: compile an expression straight into bytecode and evaluate it
+    if (strcmp(argv[1], "--pratt") == 0) {
+        return run_pratt_mode(argc, argv);
+    }
+
+    // Compile mode: compile one expression per line of a file into a program file
+    if (strcmp(argv[1], "--compile") == 0) {
+        return run_compile_mode(argc, argv);
+    }
 
-    // Carry out the shunting yard algorithm to parse the lexer token list into RPF
-    int parser = shunting_yard_algorithm(&tokenList, &postfixTokenList);
-    if (parser == 1) {
-        fprintf(stderr, "Fatal error: parser could not be run.\n\n");
-        free_tokenList_memory(&tokenList);
-        free_stackTokenList_memory(&postfixTokenList);
+    // Program mode: evaluate an expression of a program file without compiling it
+    if (strcmp(argv[1], "--program") == 0) {
+        return run_program_mode(argc, argv);
+    }
+
+
+    //-----------------------------------------------------------------------------------------------------------//
+    //-----------------------------------------  MAIN LOGIC BEGINS  ---------------------------------------------//
+    //-----------------------------------------------------------------------------------------------------------//
+
+
+    // Compile the input string (argv[1]): lexical analysis, variable slot binding and parsing into RPF
+    CompiledExpression compiledExpression;
+    int compileOutput = compile_expression(argv[1], &compiledExpression);
+    if (compileOutput == 1) {
+        fprintf(stderr, "Fatal error: expression could not be compiled.\n\n");
         return ERROR_FATAL_FUNCTION_CALL;
     }
 
     // Print the tokenList 
-    int printPostfixTokenList = print_stackTokenList(&postfixTokenList);
+    int printTokenListOutput = print_tokenList(&compiledExpression.tokenList);
+    if (printTokenListOutput == 1) {
+        fprintf(stderr, "Fatal error: token list could not be printed.\n\n");
+        free_compiledExpression_memory(&compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // Print the postfix tokenList 
+    int printPostfixTokenList = print_stackTokenList(&compiledExpression.foldedTokenList,
+                                                     &compiledExpression.postfixTokenList);
     if (printPostfixTokenList == 1) {
         fprintf(stderr, "Fatal error: token list could not be printed.\n\n");
-        free_tokenList_memory(&tokenList);
-        free_stackTokenList_memory(&postfixTokenList);
+        free_compiledExpression_memory(&compiledExpression);
         return ERROR_FATAL_FUNCTION_CALL;
     }
 
+    // Bind the variable values given as the remaining arguments ("name=value")
+    double* variableValues = calloc(compiledExpression.variableCount + 1, sizeof(double));
+    int* variableBound = calloc(compiledExpression.variableCount + 1, sizeof(int));
+    if (variableValues == NULL || variableBound == NULL) {
+        fprintf(stderr, "Fatal error: memory could not be allocated.\n\n");
+        free(variableValues);
+        free(variableBound);
+        free_compiledExpression_memory(&compiledExpression);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    int bindOutput = bind_variable_arguments(compiledExpression.variableNames, compiledExpression.variableCount,
+                                             argc - 2, &argv[2], variableValues, variableBound);
+    if (bindOutput == 1) {
+        free(variableValues);
+        free(variableBound);
+        free_compiledExpression_memory(&compiledExpression);
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
     // Do the final evaluation
-    double finalAnswer = evaluate_postfixTokenList(&postfixTokenList);
+    double finalAnswer;
+    int evaluateOutput = evaluate_compiledExpression(&compiledExpression, variableValues, &finalAnswer);
+    if (evaluateOutput == 1) {
+        fprintf(stderr, "Fatal error: expression could not be evaluated.\n\n");
+        free(variableValues);
+        free(variableBound);
+        free_compiledExpression_memory(&compiledExpression);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
     printf("\n\nFinal answer: %.10f.\n\n", finalAnswer);
 
 
     // Free all memory
-    free_tokenList_memory(&tokenList);
-    free_stackTokenList_memory(&postfixTokenList);
+    free(variableValues);
+    free(variableBound);
+    free_compiledExpression_memory(&compiledExpression);
 
 
 
@@ -107,8 +591,7 @@ int main(int argc, char *argv[]) {
 
 
 
-    QueryPerformanceCounter(&end); // End timing
-    elapsedTime = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart; // Calculate elapsed time in seconds
+    double elapsedTime = (get_timer_nanoseconds() - start) * 1e-9; // Elapsed time in seconds
     printf("Execution Time: %.8f seconds\n\n", elapsedTime); // Print execution time
 
 
@@ -0,0 +1,120 @@
+#define _POSIX_C_SOURCE 200809L  // For posix_madvise under strict C11
+
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "errors.h"
+#include "mapped_file.h"
+
+
+int map_file(const char* fileName, TypeAccess typeAccess, MappedFile* mappedFile) {
+
+    // Validating function parameters
+    if (fileName == NULL || mappedFile == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    mappedFile->data = NULL;
+    mappedFile->size = 0;
+    mappedFile->nullTerminated = 0;
+    mappedFile->fileHandle = NULL;
+    mappedFile->mappingHandle = NULL;
+
+#if defined(_WIN32)
+    DWORD flags = FILE_ATTRIBUTE_NORMAL | (typeAccess == ACCESS_SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : 0);
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+    LARGE_INTEGER fileSize;
+    if (file == INVALID_HANDLE_VALUE) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    mappedFile->fileHandle = file;
+    if (fileSize.QuadPart == 0) {
+        return 0;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* data = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (data == NULL) {
+        if (mapping != NULL) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        mappedFile->fileHandle = NULL;
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    mappedFile->mappingHandle = mapping;
+    mappedFile->data = data;
+    mappedFile->size = (size_t)fileSize.QuadPart;
+    mappedFile->nullTerminated = mappedFile->size % systemInfo.dwPageSize != 0;
+#else
+    int file = open(fileName, O_RDONLY);
+    struct stat fileStatus;
+    if (file == -1) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (fstat(file, &fileStatus) != 0 || !S_ISREG(fileStatus.st_mode)) {
+        close(file);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // The mapping stays valid once the file is closed
+    if (fileStatus.st_size > 0) {
+        void* data = mmap(NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED) {
+            close(file);
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        posix_madvise(data, fileStatus.st_size,
+                      typeAccess == ACCESS_SEQUENTIAL ? POSIX_MADV_SEQUENTIAL : POSIX_MADV_NORMAL);
+        mappedFile->data = data;
+        mappedFile->size = (size_t)fileStatus.st_size;
+        mappedFile->nullTerminated = mappedFile->size % (size_t)sysconf(_SC_PAGESIZE) != 0;
+    }
+    close(file);
+#endif
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int free_mappedFile_memory(MappedFile* mappedFile) {
+
+    // Validating function parameters
+    if (mappedFile == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+#if defined(_WIN32)
+    if (mappedFile->data != NULL) {
+        UnmapViewOfFile(mappedFile->data);
+        CloseHandle(mappedFile->mappingHandle);
+    }
+    if (mappedFile->fileHandle != NULL) {
+        CloseHandle(mappedFile->fileHandle);
+    }
+#else
+    if (mappedFile->data != NULL) {
+        munmap(mappedFile->data, mappedFile->size);
+    }
+#endif
+    mappedFile->data = NULL;
+    mappedFile->size = 0;
+    mappedFile->fileHandle = NULL;
+    mappedFile->mappingHandle = NULL;
+
+    // Subroutine ran successfully
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+
+#include "errors.h"
+#include "expression.h"
+#include "gradient.h"
+#include "matheval.h"
+
+
+// Fills out `errorReport` for a call that failed without reporting why: its parameters were invalid, or memory could
+// not be allocated (allocation failures are not reported by the modules)
+static void report_silent_failure(ErrorReport* errorReport, int invalidArgument) {
+    if (errorReport->code != ERROR_CODE_NONE) {
+        return;
+    }
+    errorReport->code = invalidArgument ? ERROR_CODE_INVALID_ARGUMENT : ERROR_CODE_MEMORY;
+    errorReport->position = -1;
+    errorReport->length = 0;
+    snprintf(errorReport->message, ERROR_MESSAGE_SIZE, "%s",
+             invalidArgument ? "invalid function parameters." : "memory allocation failure.");
+}
+
+
+int matheval_compile(char* sourceString, CompiledExpression* compiledExpression, ErrorReport* errorReport) {
+
+    // Errors go into a local report when the caller does not want them
+    ErrorReport localReport;
+    if (errorReport == NULL) {
+        errorReport = &localReport;
+    }
+    ErrorReport* previousReport = capture_errors(errorReport);
+
+    // Validating function parameters
+    if (sourceString == NULL || compiledExpression == NULL) {
+        report_silent_failure(errorReport, 1);
+        capture_errors(previousReport);
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    int compile = compile_expression(sourceString, compiledExpression);
+    if (compile != 0) {
+        report_silent_failure(errorReport, 0);
+    }
+    capture_errors(previousReport);
+
+    return compile;
+}
+
+
+int matheval_evaluate(CompiledExpression* compiledExpression, double* variableValues, double* result,
+                      ErrorReport* errorReport) {
+
+    ErrorReport localReport;
+    if (errorReport == NULL) {
+        errorReport = &localReport;
+    }
+    ErrorReport* previousReport = capture_errors(errorReport);
+
+    // Validating function parameters
+    if (compiledExpression == NULL || result == NULL) {
+        report_silent_failure(errorReport, 1);
+        capture_errors(previousReport);
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    int evaluate = evaluate_compiledExpression(compiledExpression, variableValues, result);
+    if (evaluate != 0) {
+        report_silent_failure(errorReport, 0);
+    }
+    capture_errors(previousReport);
+
+    return evaluate;
+}
+
+
+int matheval_evaluate_context(CompiledExpression* compiledExpression, double* variableValues, DoubleStack* doubleStack,
+                              double* result, ErrorReport* errorReport) {
+
+    ErrorReport localReport;
+    if (errorReport == NULL) {
+        errorReport = &localReport;
+    }
+    ErrorReport* previousReport = capture_errors(errorReport);
+
+    // Validating function parameters
+    if (compiledExpression == NULL || doubleStack == NULL || doubleStack->array == NULL || result == NULL) {
+        report_silent_failure(errorReport, 1);
+        capture_errors(previousReport);
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    int evaluate = evaluate_compiledExpression_context(compiledExpression, variableValues, doubleStack, result);
+    if (evaluate != 0) {
+        report_silent_failure(errorReport, 0);
+    }
+    capture_errors(previousReport);
+
+    return evaluate;
+}
+
+
+int matheval_evaluate_gradient(CompiledExpression* compiledExpression, double* variableValues, double* result,
+                               double* gradient, ErrorReport* errorReport) {
+
+    ErrorReport localReport;
+    if (errorReport == NULL) {
+        errorReport = &localReport;
+    }
+    ErrorReport* previousReport = capture_errors(errorReport);
+
+    // Validating function parameters
+    if (compiledExpression == NULL || result == NULL || (gradient == NULL && compiledExpression->variableCount > 0)) {
+        report_silent_failure(errorReport, 1);
+        capture_errors(previousReport);
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    int evaluate = evaluate_compiledExpression_gradient(compiledExpression, variableValues, NULL, 0, result, gradient);
+    if (evaluate != 0) {
+        report_silent_failure(errorReport, 0);
+    }
+    capture_errors(previousReport);
+
+    return evaluate;
+}
+
+
+int matheval_free(CompiledExpression* compiledExpression) {
+    return free_compiledExpression_memory(compiledExpression);
+}
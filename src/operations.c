@@ -0,0 +1,182 @@
+#define _GNU_SOURCE  // For sincos in glibc
+
+#include <stdio.h>
+#include <math.h>
+
+#include "errors.h"
+#include "lex.h"
+#include "statistics.h"
+#include "operations.h"
+
+
+const double CONSTANT_PI = 3.14159265358979;
+const double CONSTANT_E = 2.71828182845905;
+static const double EPSILON = 1e-10;
+
+
+TypeDomainError apply_operator(TypeToken typeToken, double a, double b, double* result) {
+
+    switch (typeToken) {
+        case TOKEN_OPERATOR_PLUS:
+            *result = a + b;
+            return DOMAIN_VALID;
+        case TOKEN_OPERATOR_MINUS:
+            *result = a - b;
+            return DOMAIN_VALID;
+        case TOKEN_OPERATOR_MULTIPLY:
+            *result = a * b;
+            return DOMAIN_VALID;
+        case TOKEN_OPERATOR_DIVIDE:
+            if (b == 0) {
+                return DOMAIN_ERROR_DIVIDE_BY_ZERO;
+            }
+            *result = a / b;
+            return DOMAIN_VALID;
+        case TOKEN_OPERATOR_POWER:
+            if (a == 0 && b < 0) {
+                return DOMAIN_ERROR_DIVIDE_BY_ZERO;
+            }
+            if (a < 0 && b != floor(b)) {
+                return DOMAIN_ERROR_POWER;
+            }
+            *result = pow(a, b);
+            return DOMAIN_VALID;
+        default:
+            return DOMAIN_ERROR_UNKNOWN_OPERATION;
+    }
+}
+
+
+// Computes the function `typeFunction` of `x` into `result`, see apply_function.
+static TypeDomainError compute_function(TypeFunction typeFunction, double x, double* result) {
+
+    switch (typeFunction) {
+        case FUNCTION_SIN:
+            *result = sin(x);
+            return DOMAIN_VALID;
+        case FUNCTION_COS:
+            *result = cos(x);
+            return DOMAIN_VALID;
+        case FUNCTION_TAN:
+            // tan = sin/cos => undefined when cos = 0 or cos = REALLY close to 0
+            if (fabs(cos(x)) < EPSILON) {
+                return DOMAIN_ERROR_TAN;
+            }
+            *result = tan(x);
+            return DOMAIN_VALID;
+        case FUNCTION_ASIN:
+            if (x < -1.0 || x > 1.0) {
+                return DOMAIN_ERROR_ASIN;
+            }
+            *result = asin(x);
+            return DOMAIN_VALID;
+        case FUNCTION_ACOS:
+            if (x < -1.0 || x > 1.0) {
+                return DOMAIN_ERROR_ACOS;
+            }
+            *result = acos(x);
+            return DOMAIN_VALID;
+        case FUNCTION_ATAN:
+            *result = atan(x);
+            return DOMAIN_VALID;
+        case FUNCTION_LN:
+            if (x < 0.0 + EPSILON) {
+                return DOMAIN_ERROR_LN;
+            }
+            *result = log(x); // log means log_e
+            return DOMAIN_VALID;
+        case FUNCTION_LOG:
+            if (x < 0.0 + EPSILON) {
+                return DOMAIN_ERROR_LOG;
+            }
+            *result = log10(x);
+            return DOMAIN_VALID;
+        case FUNCTION_EXP:
+            *result = exp(x);
+            return DOMAIN_VALID;
+        default:
+            return DOMAIN_ERROR_UNKNOWN_OPERATION;
+    }
+}
+
+
+TypeDomainError apply_function(TypeFunction typeFunction, double x, double* result) {
+
+    unsigned long long start = start_statistics_phase();
+    TypeDomainError domainError = compute_function(typeFunction, x, result);
+    end_statistics_phase(STATISTICS_PHASE_FUNCTIONS, start);
+
+    return domainError;
+}
+
+
+void apply_sincos(double x, double* sinValue, double* cosValue) {
+    unsigned long long start = start_statistics_phase();
+#if defined(__GLIBC__)
+    sincos(x, sinValue, cosValue);
+#else
+    *sinValue = sin(x);
+    *cosValue = cos(x);
+#endif
+    end_statistics_phase(STATISTICS_PHASE_FUNCTIONS, start);
+}
+
+
+double derive_function(TypeFunction typeFunction, double x, double value) {
+
+    switch (typeFunction) {
+        case FUNCTION_SIN:
+            return cos(x);
+        case FUNCTION_COS:
+            return -sin(x);
+        case FUNCTION_TAN:
+            return 1.0 + value * value;
+        case FUNCTION_ASIN:
+            return 1.0 / sqrt(1.0 - x * x);
+        case FUNCTION_ACOS:
+            return -1.0 / sqrt(1.0 - x * x);
+        case FUNCTION_ATAN:
+            return 1.0 / (1.0 + x * x);
+        case FUNCTION_LN:
+            return 1.0 / x;
+        case FUNCTION_LOG:
+            return 1.0 / (x * log(10.0));
+        case FUNCTION_EXP:
+            return value;
+        default:
+            return NAN;
+    }
+}
+
+
+void print_domain_error(TypeDomainError domainError, double x) {
+
+    switch (domainError) {
+        case DOMAIN_VALID:
+            return;
+        case DOMAIN_ERROR_DIVIDE_BY_ZERO:
+            report_error(ERROR_CODE_DOMAIN, -1, 0, "Error: divide by zero.\n");
+            return;
+        case DOMAIN_ERROR_TAN:
+            report_error(ERROR_CODE_DOMAIN, -1, 0, "Error: tan(x) is undefined for x = %.4f.\n", x);
+            return;
+        case DOMAIN_ERROR_ASIN:
+            report_error(ERROR_CODE_DOMAIN, -1, 0, "Error: asin(x) is undefined for x = %.4f.\n", x);
+            return;
+        case DOMAIN_ERROR_ACOS:
+            report_error(ERROR_CODE_DOMAIN, -1, 0, "Error: acos(x) is undefined for x = %.4f.\n", x);
+            return;
+        case DOMAIN_ERROR_LN:
+            report_error(ERROR_CODE_DOMAIN, -1, 0, "Error: ln(x) is undefined for x <= 0.\n");
+            return;
+        case DOMAIN_ERROR_LOG:
+            report_error(ERROR_CODE_DOMAIN, -1, 0, "Error: log(x) is undefined for x <= 0.\n");
+            return;
+        case DOMAIN_ERROR_POWER:
+            report_error(ERROR_CODE_DOMAIN, -1, 0, "Error: x^y is undefined for x = %.4f and y not an integer.\n", x);
+            return;
+        default:
+            report_error(ERROR_CODE_INVALID_ARGUMENT, -1, 0, "Error: Unknown function.\n");
+            return;
+    }
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "errors.h"
+#include "statistics.h"
+#include "lex.h"
+#include "parser.h"
+#include "operations.h"
+#include "optimizer.h"
+
+
+// Structure for one operand on the stack simulated while folding: the subexpression ending at the current token.
+// `start` is the index in the rewritten postfix list where the subexpression begins, `[startOffset, endOffset)` is
+// the part of the source string it was read from. Constant subexpressions also keep their value, and the slot in
+// `numberValues` they can reuse (-1 for the keywords `pi` and `e`, which have none).
+typedef struct FoldOperand {
+    int start;
+    int isConstant;
+    double value;
+    int slot;
+    int startOffset;
+    int endOffset;
+} FoldOperand;
+
+
+// Widens the lexemme of `token` to the source characters `[startOffset, endOffset)` of a folded subexpression,
+// extended over the parentheses left open or closed inside it so the printed lexemme is balanced.
+// The lexemme is not changed if the widened one would be too long to store.
+static void widen_lexemme(TokenList* lexicalTokenList, Token* token, int startOffset, int endOffset) {
+
+    char* sourceString = lexicalTokenList->sourceString;
+
+    // Count the parentheses closed before being opened inside the subexpression, and those left open at its end
+    int depth = 0, minDepth = 0;
+    for (int i = startOffset; i < endOffset; i++) {
+        if (sourceString[i] == '(') {
+            depth++;
+        }
+        else if (sourceString[i] == ')') {
+            depth--;
+            minDepth = depth < minDepth ? depth : minDepth;
+        }
+    }
+    int unopened = -minDepth;
+    int unclosed = depth - minDepth;
+
+    // Open the parentheses closed inside the subexpression
+    while (unopened > 0 && startOffset > 0) {
+        startOffset--;
+        if (sourceString[startOffset] == '(') {
+            unopened--;
+        }
+    }
+    // Close the parentheses opened inside the subexpression (function calls)
+    while (unclosed > 0 && sourceString[endOffset] != '\0') {
+        if (sourceString[endOffset] == ')') {
+            unclosed--;
+        }
+        endOffset++;
+    }
+
+    if (endOffset - startOffset <= MAX_LEXEMME_LENGTH) {
+        token->offset = startOffset;
+        token->length = (unsigned short)(endOffset - startOffset);
+    }
+}
+
+
+int fold_constants(TokenList* lexicalTokenList, StackTokenList* postfixTokenList) {
+
+    // Validating function parameters
+    if (lexicalTokenList == NULL || lexicalTokenList->array == NULL || postfixTokenList == NULL ||
+        postfixTokenList->array == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // The stack never holds more operands than there are tokens in the postfix list
+    int tokenCount = postfixTokenList->top + 1;
+    FoldOperand* operands = malloc((tokenCount > 0 ? tokenCount : 1) * sizeof(FoldOperand));
+    if (operands == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation((tokenCount > 0 ? tokenCount : 1) * sizeof(FoldOperand));
+    int operandCount = 0;
+
+    // The postfix list is rewritten in place: `output` is where the next kept token index is written. Folding only
+    // ever removes tokens, so it never overtakes the token being read.
+    int output = 0;
+    int i;
+    for (i = 0; i < tokenCount; i++) {
+
+        int tokenIndex = postfixTokenList->array[i];
+        Token* token = &lexicalTokenList->array[tokenIndex];
+        FoldOperand operand;
+        operand.start = output;
+        operand.startOffset = token->offset;
+        operand.endOffset = token->offset + token->length;
+
+        int arity;
+        switch (token->typeToken) {
+            case TOKEN_NUMBER:
+                operand.isConstant = 1;
+                operand.value = lexicalTokenList->numberValues[token->slot];
+                operand.slot = token->slot;
+                arity = 0;
+                break;
+            case TOKEN_KEYWORD_PI:
+                operand.isConstant = 1;
+                operand.value = CONSTANT_PI;
+                operand.slot = -1;
+                arity = 0;
+                break;
+            case TOKEN_KEYWORD_E:
+                operand.isConstant = 1;
+                operand.value = CONSTANT_E;
+                operand.slot = -1;
+                arity = 0;
+                break;
+            case TOKEN_FUNCTION:
+                arity = 1;
+                break;
+            case TOKEN_OPERATOR_PLUS:
+            case TOKEN_OPERATOR_MINUS:
+            case TOKEN_OPERATOR_MULTIPLY:
+            case TOKEN_OPERATOR_DIVIDE:
+                arity = 2;
+                break;
+            default:
+                // Variables (and anything unexpected) are never constant
+                operand.isConstant = 0;
+                arity = 0;
+                break;
+        }
+
+        // Malformed RPN, stop folding and leave the rest of the list for the evaluator to report
+        if (arity > operandCount) {
+            break;
+        }
+
+        if (arity > 0) {
+            FoldOperand* first = &operands[operandCount - arity];
+            FoldOperand* last = &operands[operandCount - 1];
+            operand.start = first->start;
+            operand.startOffset = first->startOffset < token->offset ? first->startOffset : token->offset;
+            operand.endOffset = last->endOffset > operand.endOffset ? last->endOffset : operand.endOffset;
+            operand.isConstant = first->isConstant && last->isConstant;
+
+            // Compute the value, a domain error means the subexpression must stay for the evaluator to report
+            if (operand.isConstant) {
+                TypeDomainError domainError = arity == 1 ?
+                    apply_function(token->typeFunction, last->value, &operand.value) :
+                    apply_operator(token->typeToken, first->value, last->value, &operand.value);
+                operand.isConstant = domainError == DOMAIN_VALID;
+            }
+
+            // Replace the subexpression by its root token, turned into a number. The value takes the slot of one of
+            // the folded numbers when there is one, so `numberValues` never holds more values than there are operands.
+            if (operand.isConstant) {
+                operand.slot = first->slot >= 0 ? first->slot : last->slot;
+                if (operand.slot < 0) {
+                    operand.slot = lexicalTokenList->numberCount++;
+                }
+                lexicalTokenList->numberValues[operand.slot] = operand.value;
+                token->typeToken = TOKEN_NUMBER;
+                token->typeFunction = FUNCTION_INVALID;
+                token->slot = operand.slot;
+                widen_lexemme(lexicalTokenList, token, operand.startOffset, operand.endOffset);
+                output = operand.start;
+            }
+            operandCount -= arity;
+        }
+
+        postfixTokenList->array[output++] = tokenIndex;
+        operands[operandCount++] = operand;
+    }
+
+    // Keep any tokens left after malformed RPN as they were
+    for (; i < tokenCount; i++) {
+        postfixTokenList->array[output++] = postfixTokenList->array[i];
+    }
+    postfixTokenList->top = output - 1;
+
+    free(operands);
+
+    // Subroutine ran successfully
+    return 0;
+}
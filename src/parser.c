@@ -4,13 +4,10 @@
 #include <math.h>
 
 #include "errors.h"
+#include "statistics.h"
 #include "lex.h"
 #include "parser.h"
-
-
-const static double pi = 3.14159265358979;
-const static double  e = 2.71828182845905;
-const static double EPSILON = 1e-10;
+#include "operations.h"
 
 
 int init_StackTokenList(TokenList* lexicalTokenList, StackTokenList* stackTokenList) {
@@ -20,71 +17,73 @@ int init_StackTokenList(TokenList* lexicalTokenList, StackTokenList* stackTokenL
         return ERROR_INVALID_FUNCTION_PARAMETERS;
     }
 
-    // Initialize postfixTokenList fields
-    stackTokenList->array = malloc((lexicalTokenList->position + 1) * sizeof(Token*));
+    // Initialize postfixTokenList fields (room for every token twice, the upper half is the operator stack of
+    // shunting_yard_algorithm, and for at least one token so that lists made before lexing are valid)
+    stackTokenList->maxCapacity = (lexicalTokenList->position + 1 > 0) ? 2 * (lexicalTokenList->position + 1) : 2;
+    stackTokenList->array = malloc(stackTokenList->maxCapacity * sizeof(int));
     if (stackTokenList->array == NULL) {
         return ERROR_MEMORY_ALLOCATION_FAILURE;
     }
+    count_statistics_allocation(stackTokenList->maxCapacity * sizeof(int));
     stackTokenList->top = -1;
+    stackTokenList->evaluationDepth = 0;
 
     // Subroutine ran successfully
     return 0;
 }
 
 
-// Function for pushing a token pointer onto the `stackTokenList`. 
+// Makes sure the initialized `stackTokenList` can hold `capacity` token indices, growing its array only if needed.
 // Returns 0 upon successful call. 1 if errors encountered. Errors are fatal.
-static int push_StackTokenList(StackTokenList* stackTokenList, Token* token) {
+static int reserve_StackTokenList(StackTokenList* stackTokenList, int capacity) {
 
-    // Validating function parameters
-    if (stackTokenList == NULL || stackTokenList->array == NULL || token == NULL) {
-        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    if (capacity <= stackTokenList->maxCapacity) {
+        return 0;
     }
 
-    // Push the token pointer to the stack
-    stackTokenList->top++;  
-    stackTokenList->array[stackTokenList->top] = token;
+    int* tempArray = realloc(stackTokenList->array, capacity * sizeof(int));
+    if (tempArray == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(capacity * sizeof(int));
+    stackTokenList->array = tempArray;
+    stackTokenList->maxCapacity = capacity;
 
     // Subroutine ran successfully
     return 0;
 }
 
 
-// Function for popping a token pointer from the `stackTokenList`. 
-// Returns the token pointer upon successful call. 1 if errors encountered. Errors are fatal.
-static Token* pop_StackTokenList(StackTokenList* stackTokenList) {
+// Function for pushing a token index onto the `stackTokenList`. The caller makes sure there is room (the arrays are
+// sized for every token before conversion starts).
+static void push_StackTokenList(StackTokenList* stackTokenList, int tokenIndex) {
+    stackTokenList->top++;
+    stackTokenList->array[stackTokenList->top] = tokenIndex;
+}
 
-    // Validating function parameters
-    if (stackTokenList == NULL || stackTokenList->array == NULL || stackTokenList->top < 0) {
-        return NULL;
-    }
 
-    // Pop a token pointer off the stack
-    Token* poppedToken = stackTokenList->array[stackTokenList->top];
-    stackTokenList->array[stackTokenList->top] = NULL;
+// Function for popping a token index from the non-empty `stackTokenList`. Returns the token index.
+static int pop_StackTokenList(StackTokenList* stackTokenList) {
+    int poppedToken = stackTokenList->array[stackTokenList->top];
     stackTokenList->top--;
-
-    // Subroutine ran successfully
     return poppedToken;
-
 }
 
 
-// Function for initializing the fields for an instance of a doubleStack
-// Assumes the max # of elements needed for the array is the # of tokens in the postfix array
-// Returns 0 upon success, and 1 upon failure/
-static int init_doubleStack(StackTokenList* stackTokenList, DoubleStack* doubleStack) {
+int init_doubleStack(DoubleStack* doubleStack, int capacity) {
 
     // Validating function parameters
-    if (stackTokenList == NULL || stackTokenList->array == NULL || doubleStack == NULL) {
+    if (doubleStack == NULL) {
         return ERROR_INVALID_FUNCTION_PARAMETERS;
     }
 
-    // Initialize doubleStack fields
-    doubleStack->array = malloc((stackTokenList->top + 1) * sizeof(double));
+    // Initialize doubleStack fields (room for at least one value)
+    doubleStack->maxCapacity = (capacity > 0) ? capacity : 1;
+    doubleStack->array = malloc(doubleStack->maxCapacity * sizeof(double));
     if (doubleStack->array == NULL) {
         return ERROR_MEMORY_ALLOCATION_FAILURE;
     }
+    count_statistics_allocation(doubleStack->maxCapacity * sizeof(double));
     doubleStack->top = -1;
 
     // Subroutine ran successfully
@@ -92,40 +91,41 @@ static int init_doubleStack(StackTokenList* stackTokenList, DoubleStack* doubleS
 }
 
 
-// Function for pushing a double val onto the `doubleStack`. 
-// Returns 0 upon successful call. 1 if errors encountered. Errors are fatal.
-static int push_doubleStack(DoubleStack* doubleStack, double number) {
+int reserve_doubleStack(DoubleStack* doubleStack, int capacity) {
 
     // Validating function parameters
     if (doubleStack == NULL || doubleStack->array == NULL) {
         return ERROR_INVALID_FUNCTION_PARAMETERS;
     }
+    if (capacity <= doubleStack->maxCapacity) {
+        return 0;
+    }
 
-    // Push the token pointer to the stack
-    doubleStack->top++;  
-    doubleStack->array[doubleStack->top] = number;
+    double* tempArray = realloc(doubleStack->array, capacity * sizeof(double));
+    if (tempArray == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(capacity * sizeof(double));
+    doubleStack->array = tempArray;
+    doubleStack->maxCapacity = capacity;
 
     // Subroutine ran successfully
     return 0;
 }
 
 
-// Function for popping an element off of the `doubleStack`. 
-// Returns the value (double) of tbe popped element
-static double pop_doubleStack(DoubleStack* doubleStack) {
+int free_doubleStack_memory(DoubleStack* doubleStack) {
 
-    // Validating function parameters
-    if (doubleStack == NULL || doubleStack->array == NULL || doubleStack->top < 0) {
-        return 0;
+    // Validate function parameters
+    if (doubleStack == NULL || doubleStack->array == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
     }
 
-    // Push the token pointer to the stack
-    double popped = doubleStack->array[doubleStack->top];  
-    doubleStack->array[doubleStack->top] = 0;
-    doubleStack->top--;
+    free(doubleStack->array);
+    doubleStack->array = NULL;
 
     // Subroutine ran successfully
-    return popped;
+    return 0;
 }
 
 
@@ -153,93 +153,103 @@ static int get_precedence(TypeToken typeOperator) {
 // }
 
 
-static const char* allowedFunctions[] = {"sin", "cos", "tan", "asin", "acos", "atan", "ln", "log", "exp"};
-static const int numFunctions = sizeof(allowedFunctions) / sizeof(allowedFunctions[0]);
-
-
-// Returns 1 if a potential function is supported. 0 if not, and -1 if error. // OPTIMIZE WITH HASHMAP
-static int is_valid_function(char* pLexemmeStart, int length) {
-    if (pLexemmeStart == NULL || length < 1) {
-        return -ERROR_INVALID_FUNCTION_PARAMETERS;
+// Returns the number of values the token type `typeToken` pops off the evaluation stack (it pushes one).
+static int get_arity(TypeToken typeToken) {
+    switch (typeToken) {
+        case TOKEN_OPERATOR_PLUS:
+        case TOKEN_OPERATOR_MINUS:
+        case TOKEN_OPERATOR_MULTIPLY:
+        case TOKEN_OPERATOR_DIVIDE:
+            return 2;
+        case TOKEN_FUNCTION:
+            return 1;
+        default:
+            return 0;
     }
+}
 
-    for (int i = 0; i < numFunctions; i++) {
-        if (length == strlen(allowedFunctions[i]) && strncmp(pLexemmeStart, allowedFunctions[i], length) == 0) {
-            return 1;  // Function is valid
-        }
-    }
-    return 0;  // Function is invalid
+
+// Reports the operator or function `token` that has fewer operands than it needs (kept out of emit_postfix, which
+// runs for every token)
+static void report_missing_operand(Token* token) {
+    report_error(ERROR_CODE_SYNTAX, token->offset, token->length, "Error: invalid expression, missing operand.\n");
 }
 
 
-int shunting_yard_algorithm(TokenList* lexicalTokenList, StackTokenList* postfixTokenList) {
+// Appends the token at `tokenIndex` to `postfixTokenList`, following the number of values the evaluation stack holds
+// once it is evaluated (`*depth`) and their maximum (`evaluationDepth` of the list). Returns 0 upon success, 1 if
+// the token has fewer operands than it needs (errors are fatal).
+static inline int emit_postfix(Token* tokens, StackTokenList* postfixTokenList, int tokenIndex, int* depth) {
 
-    // Validating function parameters
-    if (lexicalTokenList == NULL || lexicalTokenList->array == NULL || postfixTokenList == NULL) {
-        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    int arity = get_arity(tokens[tokenIndex].typeToken);
+    if (*depth < arity) {
+        report_missing_operand(&tokens[tokenIndex]);
+        return ERROR_INVALID_PROGRAM_USAGE;
     }
-
-    // Create and initialize the operator stack
-    StackTokenList operatorStack;
-    int initOperatorStack = init_StackTokenList(lexicalTokenList, &operatorStack);
-    if (initOperatorStack == 1) {
-        return ERROR_FATAL_FUNCTION_CALL;
+    *depth += 1 - arity;
+    if (*depth > postfixTokenList->evaluationDepth) {
+        postfixTokenList->evaluationDepth = *depth;
     }
+    push_StackTokenList(postfixTokenList, tokenIndex);
+
+    return 0;
+}
+
+
+// Performs the shunting yard algorithm on `lexicalTokenList`, filling out the emptied `postfixTokenList` and using
+// `operatorStack` (able to hold every token) for the operators. Returns 0 upon success. 1 if errors encountered.
+static int convert_to_postfix(TokenList* lexicalTokenList, StackTokenList* postfixTokenList, StackTokenList* operatorStack) {
+
+    // Tokens are referenced by their index in the lexer's token array
+    Token* tokens = lexicalTokenList->array;
+    int peakDepth = 0;
+    int depth = 0;
 
     // Iterate over all tokens in lexicalTokenList EXCEPT TOKEN_EOF
     for (int i = 0; i < lexicalTokenList->position; i++) {
 
-        Token* currentToken = lexicalTokenList->array[i];
-        int push;
-        Token* popped = NULL;
+        Token* currentToken = &tokens[i];
 
         switch (currentToken->typeToken) {
             case (TOKEN_NUMBER):
             case (TOKEN_KEYWORD_E):
             case (TOKEN_KEYWORD_PI):
-                push = push_StackTokenList(postfixTokenList, currentToken);
+            case (TOKEN_VARIABLE):
+                emit_postfix(tokens, postfixTokenList, i, &depth);  // Operands take no operands, this cannot fail
                 break;
             case TOKEN_FUNCTION:
-                int valid = is_valid_function(currentToken->pLexemmeStart, currentToken->length);
-                if (valid == 1) {
-                    push = push_StackTokenList(&operatorStack, currentToken);
-                }
-                else if (valid == 0) {
-                    fprintf(stderr, "\nError: invalid function name at '%.*s'.\n", currentToken->length, currentToken->pLexemmeStart);
-                    return ERROR_INVALID_PROGRAM_USAGE;
-                }
-                else {
-                    return ERROR_FATAL_FUNCTION_CALL;
-                }
+                // Function names were already resolved to a TypeFunction by the lexer
+                push_StackTokenList(operatorStack, i);
                 break;
             case TOKEN_OPEN_PARENTHESIS:
-                push = push_StackTokenList(&operatorStack, currentToken);
+                push_StackTokenList(operatorStack, i);
                 break;
             case TOKEN_CLOSED_PARENTHESIS:
-                while (!stack_empty(&operatorStack)) {
-                    if (operatorStack.array[operatorStack.top]->typeToken == TOKEN_OPEN_PARENTHESIS) {
+                while (!stack_empty(operatorStack)) {
+                    if (tokens[operatorStack->array[operatorStack->top]].typeToken == TOKEN_OPEN_PARENTHESIS) {
                         break;
                     }
-                    push = push_StackTokenList(postfixTokenList, pop_StackTokenList(&operatorStack));
-                    if (push == 1) {
-                        return ERROR_FATAL_FUNCTION_CALL;
+                    if (emit_postfix(tokens, postfixTokenList, pop_StackTokenList(operatorStack), &depth) != 0) {
+                        return ERROR_INVALID_PROGRAM_USAGE;
                     }
                 }
                 // Check for mismatched parentheses
-                if (stack_empty(&operatorStack) || operatorStack.array[operatorStack.top]->typeToken != TOKEN_OPEN_PARENTHESIS) {
-                    fprintf(stderr, "\nError: mismatched parentheses.\n");
+                if (stack_empty(operatorStack) || tokens[operatorStack->array[operatorStack->top]].typeToken != TOKEN_OPEN_PARENTHESIS) {
+                    report_error(ERROR_CODE_SYNTAX, tokens[i].offset, 1, "\nError: mismatched parentheses.\n");
                     return ERROR_INVALID_PROGRAM_USAGE;
                 }
                 // Pop the matching '(' but do not push onto output
-                popped = pop_StackTokenList(&operatorStack);
+                pop_StackTokenList(operatorStack);
                 // If the top of the stack is a function, pop it into output
-                if (!stack_empty(&operatorStack) && operatorStack.array[operatorStack.top]->typeToken == TOKEN_FUNCTION) {
-                    push_StackTokenList(postfixTokenList, pop_StackTokenList(&operatorStack));
+                if (!stack_empty(operatorStack) && tokens[operatorStack->array[operatorStack->top]].typeToken == TOKEN_FUNCTION) {
+                    if (emit_postfix(tokens, postfixTokenList, pop_StackTokenList(operatorStack), &depth) != 0) {
+                        return ERROR_INVALID_PROGRAM_USAGE;
+                    }
                 }
                 break;
             default:
-                while (!stack_empty(&operatorStack)) {
-                    TypeToken topStackOperator = operatorStack.array[operatorStack.top]->typeToken;
+                while (!stack_empty(operatorStack)) {
+                    TypeToken topStackOperator = tokens[operatorStack->array[operatorStack->top]].typeToken;
 
                     if (topStackOperator == TOKEN_OPEN_PARENTHESIS) {
                         break;
@@ -249,34 +259,47 @@ int shunting_yard_algorithm(TokenList* lexicalTokenList, StackTokenList* postfix
                     int currentTokenPrecedence = get_precedence(currentToken->typeToken);
 
                     if (topStackPrecedence >= currentTokenPrecedence) { // LATER ADD IMPLEMTATION FOR ASSOCIATIVITY (EXPONENT)
-                        push_StackTokenList(postfixTokenList, pop_StackTokenList(&operatorStack));
+                        if (emit_postfix(tokens, postfixTokenList, pop_StackTokenList(operatorStack), &depth) != 0) {
+                            return ERROR_INVALID_PROGRAM_USAGE;
+                        }
                     }
                     else {
                         break;
                     }
 
                 }
-                push = push_StackTokenList(&operatorStack, currentToken);
+                push_StackTokenList(operatorStack, i);
                 break;
         }
 
-        if (push == 1) {
-            return ERROR_FATAL_FUNCTION_CALL;
+        if (operatorStack->top + 1 > peakDepth) {
+            peakDepth = operatorStack->top + 1;
         }
         
     }
+    raise_statistics_peak(STATISTICS_PEAK_OPERATOR_STACK, peakDepth);
 
     // Pop remaining operators
-    while (!stack_empty(&operatorStack)) {
-        TypeToken topStackOperator = operatorStack.array[operatorStack.top]->typeToken;
+    while (!stack_empty(operatorStack)) {
+        TypeToken topStackOperator = tokens[operatorStack->array[operatorStack->top]].typeToken;
 
         // If parentheses remain, mismatched error
         if (topStackOperator == TOKEN_OPEN_PARENTHESIS || topStackOperator == TOKEN_CLOSED_PARENTHESIS) {
-            fprintf(stderr, "\nError: mismatched parentheses.\n");
+            report_error(ERROR_CODE_SYNTAX, tokens[operatorStack->array[operatorStack->top]].offset, 1,
+                         "\nError: mismatched parentheses.\n");
             return ERROR_INVALID_PROGRAM_USAGE;
         }
 
-        push_StackTokenList(postfixTokenList, pop_StackTokenList(&operatorStack));
+        if (emit_postfix(tokens, postfixTokenList, pop_StackTokenList(operatorStack), &depth) != 0) {
+            return ERROR_INVALID_PROGRAM_USAGE;
+        }
+    }
+
+    // Exactly one value must be left, more means two operands were never combined (an empty list is reported as an
+    // empty expression by the callers)
+    if (postfixTokenList->top >= 0 && depth != 1) {
+        report_error(ERROR_CODE_SYNTAX, -1, 0, "Error: invalid expression, missing operator.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
     }
 
     // Subroutine ran successfully
@@ -285,15 +308,47 @@ int shunting_yard_algorithm(TokenList* lexicalTokenList, StackTokenList* postfix
 }
 
 
-int print_stackTokenList(StackTokenList* stackTokenList) {
+int shunting_yard_algorithm(TokenList* lexicalTokenList, StackTokenList* postfixTokenList) {
+
+    // Validating function parameters
+    if (lexicalTokenList == NULL || lexicalTokenList->array == NULL || postfixTokenList == NULL || postfixTokenList->array == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    unsigned long long start = start_statistics_phase();
+
+    // Empty the postfix list (it may be reused from a previous call) and make sure it can hold every token twice
+    int tokenCapacity = lexicalTokenList->position + 1;
+    postfixTokenList->top = -1;
+    postfixTokenList->evaluationDepth = 0;
+    if (reserve_StackTokenList(postfixTokenList, 2 * tokenCapacity) == 1) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    // The operator stack is the upper half of the postfix array, so converting allocates nothing
+    StackTokenList operatorStack;
+    operatorStack.array = postfixTokenList->array + tokenCapacity;
+    operatorStack.top = -1;
+    operatorStack.maxCapacity = tokenCapacity;
+    operatorStack.evaluationDepth = 0;
+
+    int convert = convert_to_postfix(lexicalTokenList, postfixTokenList, &operatorStack);
+    end_statistics_phase(STATISTICS_PHASE_PARSE, start);
+
+    return convert;
+
+}
+
+
+int print_stackTokenList(TokenList* lexicalTokenList, StackTokenList* stackTokenList) {
     // Validate function parameters
-    if (stackTokenList == NULL || stackTokenList->array == NULL || stackTokenList->top < 0) {
+    if (lexicalTokenList == NULL || lexicalTokenList->array == NULL || 
+        stackTokenList == NULL || stackTokenList->array == NULL || stackTokenList->top < 0) {
         return ERROR_INVALID_FUNCTION_PARAMETERS;
     }
 
     printf("\n");
     for (int i = 0; i < stackTokenList->top + 1; i++) {
-        int printOutput = print_token(stackTokenList->array[i]); 
+        int printOutput = print_token(lexicalTokenList, &lexicalTokenList->array[stackTokenList->array[i]]); 
         if (printOutput == 1) {
             // Errors are fatal and memory is freed in main.c
             return ERROR_FATAL_FUNCTION_CALL;
@@ -307,16 +362,11 @@ int print_stackTokenList(StackTokenList* stackTokenList) {
 
 int free_stackTokenList_memory(StackTokenList* stackTokenList) {
     // Validate function parameters
-    if (stackTokenList == NULL || stackTokenList->array == NULL || stackTokenList->top < 0) {
+    if (stackTokenList == NULL || stackTokenList->array == NULL) {
         return ERROR_INVALID_FUNCTION_PARAMETERS;
     }
 
-    // Free each token in the array
-    for (int i = 0; i < stackTokenList->top + 1; i++) {
-        stackTokenList->array[i] = NULL; // The actual tokens will be freed by the free_tokenList_memory function
-    }
-
-    // Free the token array itself (recall its a dynamic (pointer) array of pointers to tokens)
+    // Free the token index array itself (the actual tokens will be freed by the free_tokenList_memory function)
     free(stackTokenList->array);
     stackTokenList->array = NULL;
 
@@ -326,190 +376,108 @@ int free_stackTokenList_memory(StackTokenList* stackTokenList) {
 }
 
 
-// Fuction for converting a number represented by a substring to a double value.
-// `start` is a pointer to some element of the string, and `length` is length of substring. 
-// Returns the double value of the number in string form.
-static double convert_to_double(char *start, int length) {
-
-    // Null-terminate the substring by creating a new temporary string
-    char *temp = (char *)malloc(length + 1);  // +1 for null terminator
-    if (temp == NULL) {
-        return 0;
-    }
-
-    // Copy the substring to temp and null-terminate it
-    strncpy(temp, start, length);
-    temp[length] = '\0';
-
-    // Convert the substring to a double using strtod
-    double result = atof(temp);
-
-    // Free the allocated memory
-    free(temp);
-
-    return result;
-}
-
-
-// Function for evaluating the `postfixTokenList` Returns the final answer (double).
-// Any errors with memory allocation and etc are fatal.
-double evaluate_postfixTokenList(StackTokenList* postfixTokenList) {
+// Evaluates `postfixTokenList` into `result`, see evaluate_postfixTokenList. Returns 0 upon success, 1 upon errors.
+static int evaluate_postfix(TokenList* lexicalTokenList, StackTokenList* postfixTokenList, double* variableValues,
+                            DoubleStack* doubleStack, double* result) {
 
     // Validate input parameters
-    if (postfixTokenList == NULL || postfixTokenList->array == NULL || postfixTokenList->top < 0) {
-        return 0;
+    if (lexicalTokenList == NULL || lexicalTokenList->array == NULL || postfixTokenList == NULL || 
+        postfixTokenList->array == NULL || postfixTokenList->top < 0 || postfixTokenList->evaluationDepth < 1 ||
+        doubleStack == NULL || doubleStack->array == NULL || result == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
     }
 
-    // Create a doubleStack for evaluation
-    DoubleStack doubleStack;
-    int initDoubleStack = init_doubleStack(postfixTokenList, &doubleStack);
-    if (initDoubleStack == 1) {
-        return 0;
+    // Make sure the doubleStack can hold the deepest point of the evaluation, known since parsing. Once it has, the
+    // same doubleStack evaluates every later list of that depth without allocating anything.
+    if (reserve_doubleStack(doubleStack, postfixTokenList->evaluationDepth) == 1) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
     }
 
+    // The parser checked that every operator has its operands and that one value is left, so values are pushed and
+    // popped without checks (`top` is the index of the last value)
+    double* stack = doubleStack->array;
+    int top = -1;
+
     // Main loop for iterating over the tokens in postfixTokenList
     for (int i = 0; i < postfixTokenList->top + 1; i++) {
 
-        TypeToken typeToken = postfixTokenList->array[i]->typeToken;
-
-        // Cases when current token is of type number or keyword constant (pi or e). Push to stack.
-        if (typeToken == TOKEN_NUMBER) {
-            double number = convert_to_double(postfixTokenList->array[i]->pLexemmeStart, postfixTokenList->array[i]->length);
-            int push = push_doubleStack(&doubleStack, number);
-            if (push == 1) {
-                return 0;
-            }
-        }
-        else if (typeToken == TOKEN_KEYWORD_PI) {
-            int push = push_doubleStack(&doubleStack, pi);
-            if (push == 1) {
-                return 0;
-            }
-        }
-        else if (typeToken == TOKEN_KEYWORD_E) {
-            int push = push_doubleStack(&doubleStack, e);
-            if (push == 1) {
-                return 0;
-            }
-        }
-        // Cases when current token is an operator (+, -, *, /)
-        else if (typeToken == TOKEN_OPERATOR_PLUS ||
-                 typeToken == TOKEN_OPERATOR_MINUS ||
-                 typeToken == TOKEN_OPERATOR_MULTIPLY ||
-                 typeToken == TOKEN_OPERATOR_DIVIDE) {
-
-            // Pop two elements from double stack (last element popped is leftmost in order)
-            double pop2 = pop_doubleStack(&doubleStack);
-            double pop1 = pop_doubleStack(&doubleStack);
-
-            double result;
-
-            switch (typeToken) {
-                case TOKEN_OPERATOR_PLUS:
-                    result = pop1 + pop2;
-                    break;
-                case TOKEN_OPERATOR_MINUS:
-                    result = pop1 - pop2;
-                    break;
-                case TOKEN_OPERATOR_MULTIPLY:
-                    result = pop1 * pop2;
-                    break;
-                case TOKEN_OPERATOR_DIVIDE:
-                    if (pop2 == 0) {
-                        fprintf(stderr, "Error: divide by zero.\n");
-                        return 0;
-                    }
-                    result = pop1 / pop2;
-                    break;
-            }
-            int push = push_doubleStack(&doubleStack, result);
-            if (push == 1) {
-                return 0;
-            }
+        Token* token = &lexicalTokenList->array[postfixTokenList->array[i]];
+        double value;
 
-        }
-        // "sin", "cos", "tan", "asin", "acos", "atan", "ln", "log", "exp". ADD SUPPORT FOR ASIN, ACOS, ATAN
-        // Case when current token is a function. Pop one number and apply function and push result.
-        else if (typeToken == TOKEN_FUNCTION) {
-
-            // Determine which function it is and apply
-            if (strncmp(postfixTokenList->array[i]->pLexemmeStart, "sin", postfixTokenList->array[i]->length) == 0) {
-                double pop = pop_doubleStack(&doubleStack);
-                int push = push_doubleStack(&doubleStack, sin(pop));
-                if (push == 1) {
-                    return 0;
-                }
-            }
-            else if (strncmp(postfixTokenList->array[i]->pLexemmeStart, "cos", postfixTokenList->array[i]->length) == 0) {
-                double pop = pop_doubleStack(&doubleStack);
-                int push = push_doubleStack(&doubleStack, cos(pop));
-                if (push == 1) {
-                    return 0;
-                }
-            }
-            else if (strncmp(postfixTokenList->array[i]->pLexemmeStart, "tan", postfixTokenList->array[i]->length) == 0) {
-                double x = pop_doubleStack(&doubleStack);
-                // Check for domain issues with x in tan(x)
-                if (fabs(cos(x)) < EPSILON) { // tan = sin/cos => undefined when cos = 0 or cos = REALLY close to 0
-                    fprintf(stderr, "Error: tan(x) is undefined for x = %.4f.\n", x);
-                    return 0;
-                }
-                int push = push_doubleStack(&doubleStack, tan(x));
-                if (push == 1) {
-                    return 0;
-                }
-            }
-            else if (strncmp(postfixTokenList->array[i]->pLexemmeStart, "ln", postfixTokenList->array[i]->length) == 0) {
-                double x = pop_doubleStack(&doubleStack);
-                // Check for domain issues with x in ln(x)
-                if (x < 0.0 + EPSILON) {
-                    fprintf(stderr, "Error: ln(x) is undefined for x <= 0.\n", x);
-                    return 0;
-                }
-                int push = push_doubleStack(&doubleStack, log(x)); // log means log_e
-                if (push == 1) {
-                    return 0;
-                }
-            }
-            else if (strncmp(postfixTokenList->array[i]->pLexemmeStart, "log", postfixTokenList->array[i]->length) == 0) {
-                double x = pop_doubleStack(&doubleStack);
-                // Check for domain issues with x in ln(x)
-                if (x < 0.0 + EPSILON) {
-                    fprintf(stderr, "Error: log(x) is undefined for x <= 0.\n", x);
-                    return 0;
+        switch (token->typeToken) {
+            // Cases when current token is of type number or keyword constant (pi or e). Push to stack.
+            case TOKEN_NUMBER:
+                stack[++top] = lexicalTokenList->numberValues[token->slot];
+                break;
+            case TOKEN_KEYWORD_PI:
+                stack[++top] = CONSTANT_PI;
+                break;
+            case TOKEN_KEYWORD_E:
+                stack[++top] = CONSTANT_E;
+                break;
+            // Case when current token is a variable. Push the value bound to its slot.
+            case TOKEN_VARIABLE:
+                if (variableValues == NULL || token->slot < 0) {
+                    report_error(ERROR_CODE_UNBOUND_VARIABLE, token->offset, token->length,
+                                 "Error: no value given for variable '%.*s'.\n", token->length,
+                                 lexicalTokenList->sourceString + token->offset);
+                    return ERROR_INVALID_PROGRAM_USAGE;
                 }
-                int push = push_doubleStack(&doubleStack, log10(x));
-                if (push == 1) {
-                    return 0;
+                stack[++top] = variableValues[token->slot];
+                break;
+            // Cases when current token is an operator (+, -, *, /). Pop two elements from double stack 
+            // (last element popped is leftmost in order) and push the result in place of the first
+            case TOKEN_OPERATOR_PLUS:
+                top--;
+                stack[top] = stack[top] + stack[top + 1];
+                break;
+            case TOKEN_OPERATOR_MINUS:
+                top--;
+                stack[top] = stack[top] - stack[top + 1];
+                break;
+            case TOKEN_OPERATOR_MULTIPLY:
+                top--;
+                stack[top] = stack[top] * stack[top + 1];
+                break;
+            case TOKEN_OPERATOR_DIVIDE:
+                top--;
+                if (stack[top + 1] == 0) {
+                    print_domain_error(DOMAIN_ERROR_DIVIDE_BY_ZERO, stack[top + 1]);
+                    return ERROR_INVALID_PROGRAM_USAGE;
                 }
-            }
-            else if (strncmp(postfixTokenList->array[i]->pLexemmeStart, "exp", postfixTokenList->array[i]->length) == 0) {
-                double x = pop_doubleStack(&doubleStack);
-                int push = push_doubleStack(&doubleStack, exp(x));
-                if (push == 1) {
-                    return 0;
+                stack[top] = stack[top] / stack[top + 1];
+                break;
+            // Case when current token is a function. Apply the function to the top value in place.
+            case TOKEN_FUNCTION: {
+                TypeDomainError domainError = apply_function(token->typeFunction, stack[top], &value);
+                if (domainError != DOMAIN_VALID) {
+                    print_domain_error(domainError, stack[top]);
+                    return ERROR_INVALID_PROGRAM_USAGE;
                 }
+                stack[top] = value;
+                break;
             }
-            else {
-                fprintf(stderr, "Error: Unknown function.\n");
-                return 0;
-            }
+            default:
+                continue;
         }
 
     }
+    raise_statistics_peak(STATISTICS_PEAK_VALUE_STACK, postfixTokenList->evaluationDepth);
+    doubleStack->top = -1;
+    *result = stack[0];
 
-    double finalAnswer = pop_doubleStack(&doubleStack);
-    free(doubleStack.array);
-
-    return finalAnswer;
+    // Subroutine ran successfully
+    return 0;
 
 }
 
 
+int evaluate_postfixTokenList(TokenList* lexicalTokenList, StackTokenList* postfixTokenList, double* variableValues,
+                              DoubleStack* doubleStack, double* result) {
 
+    unsigned long long start = start_statistics_phase();
+    int evaluate = evaluate_postfix(lexicalTokenList, postfixTokenList, variableValues, doubleStack, result);
+    end_statistics_phase(STATISTICS_PHASE_EVALUATE, start);
 
-
-
-
-
-
+    return evaluate;
+}
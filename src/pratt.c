@@ -0,0 +1,539 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "statistics.h"
+#include "lex.h"
+#include "operations.h"
+#include "vm.h"
+#include "pratt.h"
+
+
+#define LOCAL_REGISTERS 64  // Evaluations needing up to this many registers allocate no memory
+#define INITIAL_INSTRUCTION_CAPACITY 16
+
+static const int UNARY_BINDING_POWER = 25;  // Tighter than `*` and `/`, looser than `^`
+
+
+// Structure for the value of a parsed subexpression: either a constant, not loaded into any register, or the register
+// holding it. Registers are given out as a stack, so the register of a value is the lowest its subexpression used.
+typedef struct PrattValue {
+    int isConstant;
+    double constant;
+    int registerIndex;
+} PrattValue;
+
+
+// Structure for the state of a parse. Includes the source string, the lookahead token (and its value for a number),
+// the token consumed last, the current nesting depth, the instructions emitted so far, and the registers in use (the
+// top of the register stack) and needed (its maximum).
+typedef struct PrattParser {
+    char* sourceString;
+    Token token;
+    double number;
+    Token previous;
+    int depth;
+    VmInstruction* instructions;
+    int instructionCount;
+    int instructionCapacity;
+    int registerTop;
+    int registerCount;
+    PrattExpression* prattExpression;
+} PrattParser;
+
+
+// Consumes the lookahead token and scans the next one. Returns 0 upon success, 1 upon syntax errors (fatal).
+static int advance(PrattParser* parser) {
+    parser->previous = parser->token;
+    return scan_token(parser->sourceString, parser->token.offset + parser->token.length, &parser->token,
+                      &parser->number);
+}
+
+
+// Returns the binding power of the binary operator `typeToken`, 0 if it is not one (it ends the expression).
+static int get_binding_power(TypeToken typeToken) {
+    switch (typeToken) {
+        case TOKEN_OPERATOR_PLUS: return 10;
+        case TOKEN_OPERATOR_MINUS: return 10;
+        case TOKEN_OPERATOR_MULTIPLY: return 20;
+        case TOKEN_OPERATOR_DIVIDE: return 20;
+        case TOKEN_OPERATOR_POWER: return 30;
+        default: return 0;
+    }
+}
+
+
+// Appends an instruction to the program being emitted by `parser`, growing the array if needed.
+// Returns a pointer to the new instruction, NULL if memory could not be allocated (fatal).
+static VmInstruction* emit_instruction(PrattParser* parser, TypeVmOpcode opcode, int destination, int a, int b,
+                                       double constant) {
+
+    if (parser->instructionCount == parser->instructionCapacity) {
+        int capacity = parser->instructionCapacity * 2;
+        VmInstruction* tempInstructions = realloc(parser->instructions, capacity * sizeof(VmInstruction));
+        if (tempInstructions == NULL) {
+            return NULL;
+        }
+        count_statistics_allocation(capacity * sizeof(VmInstruction));
+        parser->instructions = tempInstructions;
+        parser->instructionCapacity = capacity;
+    }
+
+    VmInstruction* instruction = &parser->instructions[parser->instructionCount++];
+    instruction->constant = constant;
+    instruction->destination = destination;
+    instruction->operands[0] = a;
+    instruction->operands[1] = b;
+    instruction->operands[2] = -1;
+    instruction->opcode = (unsigned char)opcode;
+    instruction->typeFunction = FUNCTION_INVALID;
+    return instruction;
+}
+
+
+// Puts `value` into a register, loading it into a new one at the top of the register stack if it is a constant.
+// Returns 0 upon success, 1 if memory could not be allocated (fatal).
+static int load_value(PrattParser* parser, PrattValue* value) {
+
+    if (!value->isConstant) {
+        return 0;
+    }
+    int registerIndex = parser->registerTop++;
+    if (parser->registerTop > parser->registerCount) {
+        parser->registerCount = parser->registerTop;
+    }
+    if (emit_instruction(parser, VM_CONSTANT, registerIndex, -1, -1, value->constant) == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    value->isConstant = 0;
+    value->registerIndex = registerIndex;
+
+    return 0;
+}
+
+
+// Reports a syntax error with `format` at `token`.
+static void report_parse_error(Token* token, const char* format) {
+    report_error(ERROR_CODE_SYNTAX, token->offset, token->typeToken == TOKEN_EOF ? 0 : token->length, format);
+}
+
+
+// Reports the operand missing before the lookahead token of `parser`, at the operator or parenthesis that needs it
+// when the lookahead token ends an expression.
+static void report_missing_operand(PrattParser* parser) {
+    int ended = parser->token.typeToken == TOKEN_EOF || parser->token.typeToken == TOKEN_CLOSED_PARENTHESIS;
+    report_parse_error(ended ? &parser->previous : &parser->token,
+                       "Error: invalid expression, missing operand.\n");
+}
+
+
+// Searches the variable table of `prattExpression` for a name equal to the `length` characters at `name`.
+// Returns the slot index of the variable, or -1 if it is not in the table.
+static int find_variable(PrattExpression* prattExpression, char* name, int length) {
+    for (int i = 0; i < prattExpression->variableCount; i++) {
+        if (strncmp(prattExpression->variableNames[i], name, length) == 0 &&
+            prattExpression->variableNames[i][length] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+// Adds the variable called by the `length` characters at `name` to the variable table of `prattExpression` as a
+// new slot. Returns the new slot index upon success, -1 if memory could not be allocated. Errors are fatal.
+static int add_variable(PrattExpression* prattExpression, char* name, int length) {
+
+    char** tempNames = realloc(prattExpression->variableNames, (prattExpression->variableCount + 1) * sizeof(char*));
+    if (tempNames == NULL) {
+        return -1;
+    }
+    prattExpression->variableNames = tempNames;
+    count_statistics_allocation((prattExpression->variableCount + 1) * sizeof(char*));
+
+    char* nameCopy = malloc(length + 1);
+    if (nameCopy == NULL) {
+        return -1;
+    }
+    count_statistics_allocation(length + 1);
+    memcpy(nameCopy, name, length);
+    nameCopy[length] = '\0';
+
+    prattExpression->variableNames[prattExpression->variableCount] = nameCopy;
+    return prattExpression->variableCount++;
+}
+
+
+// Combines `left` and `right` with the binary operator `typeOperator` into `left`: folded if both are constants (and
+// the operation is in its domain), one instruction otherwise. Returns 0 upon success, 1 upon errors (memory).
+static int emit_binary(PrattParser* parser, TypeToken typeOperator, PrattValue* left, PrattValue* right) {
+
+    double value;
+    if (left->isConstant && right->isConstant &&
+        apply_operator(typeOperator, left->constant, right->constant, &value) == DOMAIN_VALID) {
+        left->constant = value;
+        return 0;
+    }
+
+    // A constant operand is folded into the instruction (a - k as a + -k, a * k and k + a commute exactly)
+    TypeVmOpcode opcode = VM_OPCODE_COUNT;
+    double constant = 0.0;
+    int operand = -1;
+    if (!left->isConstant && right->isConstant) {
+        operand = left->registerIndex;
+        constant = right->constant;
+        switch (typeOperator) {
+            case TOKEN_OPERATOR_PLUS: opcode = VM_ADD_CONSTANT; break;
+            case TOKEN_OPERATOR_MINUS: opcode = VM_ADD_CONSTANT; constant = -constant; break;
+            case TOKEN_OPERATOR_MULTIPLY: opcode = VM_MULTIPLY_CONSTANT; break;
+            case TOKEN_OPERATOR_DIVIDE: opcode = (constant != 0) ? VM_DIVIDE_CONSTANT : VM_OPCODE_COUNT; break;
+            default: break;
+        }
+    }
+    else if (left->isConstant && !right->isConstant) {
+        operand = right->registerIndex;
+        constant = left->constant;
+        switch (typeOperator) {
+            case TOKEN_OPERATOR_PLUS: opcode = VM_ADD_CONSTANT; break;
+            case TOKEN_OPERATOR_MINUS: opcode = VM_CONSTANT_SUBTRACT; break;
+            case TOKEN_OPERATOR_MULTIPLY: opcode = VM_MULTIPLY_CONSTANT; break;
+            case TOKEN_OPERATOR_DIVIDE: opcode = VM_CONSTANT_DIVIDE; break;
+            default: break;
+        }
+    }
+    if (opcode != VM_OPCODE_COUNT) {
+        if (emit_instruction(parser, opcode, operand, operand, -1, constant) == NULL) {
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+        left->isConstant = 0;
+        left->registerIndex = operand;
+        parser->registerTop = operand + 1;
+        return 0;
+    }
+
+    // Otherwise both operands are loaded, the result goes into the lower of their registers
+    if (load_value(parser, left) != 0 || load_value(parser, right) != 0) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    switch (typeOperator) {
+        case TOKEN_OPERATOR_PLUS: opcode = VM_ADD; break;
+        case TOKEN_OPERATOR_MINUS: opcode = VM_SUBTRACT; break;
+        case TOKEN_OPERATOR_MULTIPLY: opcode = VM_MULTIPLY; break;
+        case TOKEN_OPERATOR_DIVIDE: opcode = VM_DIVIDE; break;
+        case TOKEN_OPERATOR_POWER: opcode = VM_POWER; break;
+        default: return ERROR_FATAL_FUNCTION_CALL;
+    }
+    int destination = left->registerIndex < right->registerIndex ? left->registerIndex : right->registerIndex;
+    if (emit_instruction(parser, opcode, destination, left->registerIndex, right->registerIndex, 0.0) == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    left->registerIndex = destination;
+    parser->registerTop = destination + 1;
+
+    return 0;
+}
+
+
+// Applies the unary minus (`typeFunction` FUNCTION_INVALID) or the function `typeFunction` to `value` in place:
+// folded if it is a constant (and the function is in its domain), one instruction otherwise.
+// Returns 0 upon success, 1 upon errors (memory).
+static int emit_unary(PrattParser* parser, TypeFunction typeFunction, PrattValue* value) {
+
+    if (value->isConstant && typeFunction == FUNCTION_INVALID) {
+        value->constant = -value->constant;
+        return 0;
+    }
+    double result;
+    if (value->isConstant && apply_function(typeFunction, value->constant, &result) == DOMAIN_VALID) {
+        value->constant = result;
+        return 0;
+    }
+
+    if (load_value(parser, value) != 0) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    TypeVmOpcode opcode = (typeFunction == FUNCTION_INVALID) ? VM_NEGATE : VM_FUNCTION;
+    VmInstruction* instruction = emit_instruction(parser, opcode, value->registerIndex, value->registerIndex, -1, 0.0);
+    if (instruction == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    instruction->typeFunction = (unsigned char)typeFunction;
+
+    return 0;
+}
+
+
+static int parse_expression(PrattParser* parser, int minBindingPower, PrattValue* value);
+
+
+// Parses the parenthesized expression starting at the lookahead '(' into `value`.
+// Returns 0 upon success, 1 upon errors (syntax, memory). Errors are fatal.
+static int parse_group(PrattParser* parser, PrattValue* value) {
+
+    Token open = parser->token;
+    if (open.typeToken != TOKEN_OPEN_PARENTHESIS) {
+        report_parse_error(&parser->token, "\nError: mismatched parentheses.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    if (advance(parser) != 0 || parse_expression(parser, 0, value) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // The group must be closed right after its expression
+    if (parser->token.typeToken == TOKEN_EOF) {
+        report_parse_error(&open, "\nError: mismatched parentheses.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    if (parser->token.typeToken != TOKEN_CLOSED_PARENTHESIS) {
+        report_parse_error(&parser->token, "Error: invalid expression, missing operator.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    return advance(parser);
+}
+
+
+// Parses the operand starting at the lookahead token (a number, constant, variable, group, function call, or an
+// operand with a unary sign) into `value`. Returns 0 upon success, 1 upon errors (syntax, memory). Errors are fatal.
+static int parse_operand(PrattParser* parser, PrattValue* value) {
+
+    Token* token = &parser->token;
+    int slot;
+
+    switch (token->typeToken) {
+        case TOKEN_NUMBER:
+            value->isConstant = 1;
+            value->constant = parser->number;
+            return advance(parser);
+        case TOKEN_KEYWORD_PI:
+            value->isConstant = 1;
+            value->constant = CONSTANT_PI;
+            return advance(parser);
+        case TOKEN_KEYWORD_E:
+            value->isConstant = 1;
+            value->constant = CONSTANT_E;
+            return advance(parser);
+        case TOKEN_VARIABLE:
+            slot = find_variable(parser->prattExpression, parser->sourceString + token->offset, token->length);
+            if (slot == -1) {
+                slot = add_variable(parser->prattExpression, parser->sourceString + token->offset, token->length);
+                if (slot == -1) {
+                    return ERROR_MEMORY_ALLOCATION_FAILURE;
+                }
+            }
+            value->isConstant = 0;
+            value->registerIndex = parser->registerTop++;
+            if (parser->registerTop > parser->registerCount) {
+                parser->registerCount = parser->registerTop;
+            }
+            if (emit_instruction(parser, VM_VARIABLE, value->registerIndex, slot, -1, 0.0) == NULL) {
+                return ERROR_MEMORY_ALLOCATION_FAILURE;
+            }
+            return advance(parser);
+        case TOKEN_OPERATOR_MINUS:
+            if (advance(parser) != 0 || parse_expression(parser, UNARY_BINDING_POWER, value) != 0) {
+                return ERROR_FATAL_FUNCTION_CALL;
+            }
+            return emit_unary(parser, FUNCTION_INVALID, value);
+        case TOKEN_OPERATOR_PLUS:
+            if (advance(parser) != 0) {
+                return ERROR_FATAL_FUNCTION_CALL;
+            }
+            return parse_expression(parser, UNARY_BINDING_POWER, value);
+        case TOKEN_OPEN_PARENTHESIS:
+            return parse_group(parser, value);
+        case TOKEN_FUNCTION: {
+            // The lexer made sure the name is directly followed by '('
+            TypeFunction typeFunction = (TypeFunction)token->typeFunction;
+            if (advance(parser) != 0 || parse_group(parser, value) != 0) {
+                return ERROR_FATAL_FUNCTION_CALL;
+            }
+            return emit_unary(parser, typeFunction, value);
+        }
+        default:
+            report_missing_operand(parser);
+            return ERROR_INVALID_PROGRAM_USAGE;
+    }
+}
+
+
+// Parses the expression starting at the lookahead token into `value`, up to the first binary operator binding less
+// tightly than `minBindingPower` (or a token that is not a binary operator).
+// Returns 0 upon success, 1 upon errors (syntax, memory). Errors are fatal.
+static int parse_expression(PrattParser* parser, int minBindingPower, PrattValue* value) {
+
+    if (++parser->depth > MAX_PRATT_DEPTH) {
+        report_parse_error(&parser->token, "\nError: expression nested too deeply.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    if (parse_operand(parser, value) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    while (1) {
+        TypeToken typeOperator = (TypeToken)parser->token.typeToken;
+        int bindingPower = get_binding_power(typeOperator);
+        if (bindingPower == 0 || bindingPower < minBindingPower) {
+            break;
+        }
+
+        // The right operand takes the operators binding tighter (and `^` again, which is right-associative)
+        PrattValue right;
+        int rightBindingPower = (typeOperator == TOKEN_OPERATOR_POWER) ? bindingPower : bindingPower + 1;
+        if (advance(parser) != 0 || parse_expression(parser, rightBindingPower, &right) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        if (emit_binary(parser, typeOperator, value, &right) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+    }
+
+    parser->depth--;
+    return 0;
+}
+
+
+// Parses the whole source string of `parser` and emits the final VM_RETURN. Returns 0 upon success, 1 upon errors.
+static int parse_source(PrattParser* parser) {
+
+    if (advance(parser) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (parser->token.typeToken == TOKEN_EOF) {
+        report_error(ERROR_CODE_SYNTAX, -1, 0, "\nError: empty expression.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    PrattValue value;
+    if (parse_expression(parser, 0, &value) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // The expression must end the source string
+    if (parser->token.typeToken == TOKEN_CLOSED_PARENTHESIS) {
+        report_parse_error(&parser->token, "\nError: mismatched parentheses.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    if (parser->token.typeToken != TOKEN_EOF) {
+        report_parse_error(&parser->token, "Error: invalid expression, missing operator.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    if (load_value(parser, &value) != 0 ||
+        emit_instruction(parser, VM_RETURN, -1, value.registerIndex, -1, 0.0) == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int compile_prattExpression(char* sourceString, PrattExpression* prattExpression) {
+
+    // Validating function parameters
+    if (sourceString == NULL || prattExpression == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    prattExpression->vm.instructions = NULL;
+    prattExpression->variableNames = NULL;
+    prattExpression->variableCount = 0;
+
+    PrattParser parser;
+    parser.sourceString = sourceString;
+    parser.token.offset = 0;
+    parser.token.length = 0;
+    parser.token.typeToken = TOKEN_EOF;
+    parser.depth = 0;
+    parser.instructionCount = 0;
+    parser.instructionCapacity = INITIAL_INSTRUCTION_CAPACITY;
+    parser.registerTop = 0;
+    parser.registerCount = 0;
+    parser.prattExpression = prattExpression;
+    parser.instructions = malloc(INITIAL_INSTRUCTION_CAPACITY * sizeof(VmInstruction));
+    if (parser.instructions == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(INITIAL_INSTRUCTION_CAPACITY * sizeof(VmInstruction));
+
+    // Lexing happens during the parse, the whole pass is counted as parsing
+    unsigned long long start = start_statistics_phase();
+    int parse = parse_source(&parser);
+    end_statistics_phase(STATISTICS_PHASE_PARSE, start);
+
+    prattExpression->vm.instructions = parser.instructions;
+    prattExpression->vm.instructionCount = parser.instructionCount;
+    prattExpression->vm.registerCount = parser.registerCount;
+    prattExpression->vm.hasVariables = prattExpression->variableCount > 0;
+    prattExpression->vm.variableNames = prattExpression->variableNames;
+    if (parse != 0) {
+        free_prattExpression_memory(prattExpression);
+        return parse;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int get_prattExpression_slot(PrattExpression* prattExpression, char* variableName) {
+
+    // Validating function parameters
+    if (prattExpression == NULL || variableName == NULL) {
+        return -1;
+    }
+
+    return find_variable(prattExpression, variableName, (int)strlen(variableName));
+}
+
+
+int evaluate_prattExpression(PrattExpression* prattExpression, double* variableValues, double* result) {
+
+    // Validating function parameters
+    if (prattExpression == NULL || prattExpression->vm.instructions == NULL || result == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Registers on the stack for all but the deepest expressions
+    unsigned long long start = start_statistics_phase();
+    double localRegisters[LOCAL_REGISTERS];
+    double* registers = localRegisters;
+    if (prattExpression->vm.registerCount > LOCAL_REGISTERS) {
+        registers = malloc(prattExpression->vm.registerCount * sizeof(double));
+        if (registers == NULL) {
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+        count_statistics_allocation(prattExpression->vm.registerCount * sizeof(double));
+    }
+
+    int evaluate = evaluate_vmProgram(&prattExpression->vm, variableValues, registers, result);
+    if (registers != localRegisters) {
+        free(registers);
+    }
+    raise_statistics_peak(STATISTICS_PEAK_VALUE_STACK, prattExpression->vm.registerCount);
+    end_statistics_phase(STATISTICS_PHASE_EVALUATE, start);
+
+    return evaluate;
+}
+
+
+int free_prattExpression_memory(PrattExpression* prattExpression) {
+
+    // Validating function parameters
+    if (prattExpression == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    if (prattExpression->vm.instructions != NULL) {
+        free_vmProgram_memory(&prattExpression->vm);
+    }
+    for (int i = 0; i < prattExpression->variableCount; i++) {
+        free(prattExpression->variableNames[i]);
+    }
+    free(prattExpression->variableNames);
+    prattExpression->variableNames = NULL;
+    prattExpression->variableCount = 0;
+
+    // Subroutine ran successfully
+    return 0;
+}
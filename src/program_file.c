@@ -0,0 +1,362 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "errors.h"
+#include "statistics.h"
+#include "program_file.h"
+
+
+// Rounds `offset` up to a multiple of 8, so the nodes and offset tables that follow it are aligned
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+
+// Returns the FNV-1a hash of the `length` bytes of `string`
+static uint32_t hash_source(const char* string, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)string[i]) * 16777619u;
+    }
+    return hash;
+}
+
+
+// Returns the checksum of the `size` bytes of the program file at `data`: their FNV-1a hash, with the bytes of the
+// header's checksum field counted as zeros
+static uint32_t checksum_programFile(const char* data, uint64_t size) {
+    uint64_t field = offsetof(ProgramFileHeader, checksum);
+    uint32_t hash = 2166136261u;
+    for (uint64_t i = 0; i < size; i++) {
+        unsigned char byte = (i - field < sizeof(uint32_t)) ? 0 : (unsigned char)data[i];
+        hash = (hash ^ byte) * 16777619u;
+    }
+    return hash;
+}
+
+
+int write_programFile(const char* fileName, CompiledExpression* compiledExpressions, int count) {
+
+    // Validating function parameters
+    if (fileName == NULL || (compiledExpressions == NULL && count > 0) || count < 0) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Hash table at most half full
+    uint32_t bucketCount = 2;
+    while (bucketCount < 2 * (uint32_t)count) {
+        bucketCount *= 2;
+    }
+
+    // Layout: header, program records, hash table, then the nodes and name offsets of each program, then the strings
+    uint64_t programsOffset = align_offset(sizeof(ProgramFileHeader));
+    uint64_t bucketsOffset = programsOffset + (uint64_t)count * sizeof(ProgramRecord);
+    uint64_t fileSize = align_offset(bucketsOffset + (uint64_t)bucketCount * sizeof(uint32_t));
+    for (int i = 0; i < count; i++) {
+        fileSize += (uint64_t)compiledExpressions[i].graph.nodeCount * sizeof(GraphNode);
+        fileSize += (uint64_t)compiledExpressions[i].variableCount * sizeof(uint64_t);
+    }
+    for (int i = 0; i < count; i++) {
+        fileSize += strlen(compiledExpressions[i].sourceString) + 1;
+        for (int slot = 0; slot < compiledExpressions[i].variableCount; slot++) {
+            fileSize += strlen(compiledExpressions[i].variableNames[slot]) + 1;
+        }
+    }
+
+    // The file is built in memory and written at once
+    char* data = calloc(fileSize, 1);
+    if (data == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(fileSize);
+    ProgramFileHeader* header = (ProgramFileHeader*)data;
+    ProgramRecord* programs = (ProgramRecord*)(data + programsOffset);
+    uint32_t* buckets = (uint32_t*)(data + bucketsOffset);
+    memcpy(header->magic, PROGRAM_FILE_MAGIC, sizeof(header->magic));
+    header->version = PROGRAM_FILE_VERSION;
+    header->byteOrder = PROGRAM_FILE_BYTE_ORDER;
+    header->nodeSize = sizeof(GraphNode);
+    header->programCount = (uint32_t)count;
+    header->fileSize = fileSize;
+    header->programsOffset = programsOffset;
+    header->bucketsOffset = bucketsOffset;
+    header->bucketCount = bucketCount;
+
+    uint64_t tableOffset = align_offset(bucketsOffset + (uint64_t)bucketCount * sizeof(uint32_t));
+    uint64_t stringOffset = tableOffset;
+    for (int i = 0; i < count; i++) {
+        stringOffset += (uint64_t)compiledExpressions[i].graph.nodeCount * sizeof(GraphNode);
+        stringOffset += (uint64_t)compiledExpressions[i].variableCount * sizeof(uint64_t);
+    }
+    for (int i = 0; i < count; i++) {
+        CompiledExpression* compiledExpression = &compiledExpressions[i];
+        ProgramRecord* program = &programs[i];
+        size_t sourceLength = strlen(compiledExpression->sourceString);
+
+        // Nodes, copied as they are in memory (padding bytes are zeroed first, so files are reproducible)
+        program->nodesOffset = tableOffset;
+        program->nodeCount = compiledExpression->graph.nodeCount;
+        program->root = compiledExpression->graph.root;
+        program->valueCount = compiledExpression->graph.nodeCount;
+        for (int node = 0; node < compiledExpression->graph.nodeCount; node++) {
+            GraphNode* source = &compiledExpression->graph.nodes[node];
+            GraphNode* target = (GraphNode*)(data + tableOffset) + node;
+            target->value = source->value;
+            target->operands[0] = source->operands[0];
+            target->operands[1] = source->operands[1];
+            target->sincosPartner = source->sincosPartner;
+            target->typeToken = source->typeToken;
+            target->typeFunction = source->typeFunction;
+        }
+        tableOffset += (uint64_t)compiledExpression->graph.nodeCount * sizeof(GraphNode);
+
+        // Source string, then the variable names with their offsets in a table indexed by slot
+        program->sourceOffset = stringOffset;
+        program->sourceLength = (uint32_t)sourceLength;
+        program->sourceHash = hash_source(compiledExpression->sourceString, sourceLength);
+        memcpy(data + stringOffset, compiledExpression->sourceString, sourceLength + 1);
+        stringOffset += sourceLength + 1;
+
+        program->variableNamesOffset = tableOffset;
+        program->variableCount = compiledExpression->variableCount;
+        for (int slot = 0; slot < compiledExpression->variableCount; slot++) {
+            size_t nameLength = strlen(compiledExpression->variableNames[slot]);
+            ((uint64_t*)(data + tableOffset))[slot] = stringOffset;
+            memcpy(data + stringOffset, compiledExpression->variableNames[slot], nameLength + 1);
+            stringOffset += nameLength + 1;
+        }
+        tableOffset += (uint64_t)compiledExpression->variableCount * sizeof(uint64_t);
+
+        // Index the program by its source string, the first of identical sources is kept
+        uint32_t bucket = program->sourceHash & (bucketCount - 1);
+        while (buckets[bucket] != 0 && strcmp(data + programs[buckets[bucket] - 1].sourceOffset,
+                                              compiledExpression->sourceString) != 0) {
+            bucket = (bucket + 1) & (bucketCount - 1);
+        }
+        if (buckets[bucket] == 0) {
+            buckets[bucket] = (uint32_t)i + 1;
+        }
+    }
+
+    header->checksum = checksum_programFile(data, fileSize);
+
+    FILE* file = fopen(fileName, "wb");
+    if (file == NULL) {
+        free(data);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    size_t written = fwrite(data, 1, fileSize, file);
+    int closed = fclose(file);
+    free(data);
+    if (written != fileSize || closed != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// Returns 1 if the `count` items of `itemSize` bytes at `offset` lie inside the mapping of `programFile`, 0 otherwise
+static int in_programFile(ProgramFile* programFile, uint64_t offset, uint64_t count, uint64_t itemSize) {
+    uint64_t size = programFile->mappedFile.size;
+    return offset <= size && count <= (size - offset) / itemSize;
+}
+
+
+int load_programFile(const char* fileName, ProgramFile* programFile) {
+
+    // Validating function parameters
+    if (fileName == NULL || programFile == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    programFile->header = NULL;
+    programFile->programs = NULL;
+    programFile->buckets = NULL;
+    programFile->programCount = 0;
+
+    // Not sequential: the pages are hashed once in order, but then read again in the order programs are looked up
+    if (map_file(fileName, ACCESS_NORMAL, &programFile->mappedFile) != 0) {
+        report_error(ERROR_CODE_FILE, -1, 0, "\nError: could not open '%s'.\n\n", fileName);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // The header must be this version's, written by a machine with the same byte order and node layout
+    const ProgramFileHeader* header = (const ProgramFileHeader*)programFile->mappedFile.data;
+    if (programFile->mappedFile.size < sizeof(ProgramFileHeader) ||
+        memcmp(header->magic, PROGRAM_FILE_MAGIC, sizeof(header->magic)) != 0) {
+        report_error(ERROR_CODE_FILE, -1, 0, "\nError: '%s' is not a program file.\n\n", fileName);
+        free_programFile_memory(programFile);
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    if (header->version != PROGRAM_FILE_VERSION || header->byteOrder != PROGRAM_FILE_BYTE_ORDER ||
+        header->nodeSize != sizeof(GraphNode)) {
+        report_error(ERROR_CODE_FILE, -1, 0,
+                     "\nError: program file '%s' was written by another version or for another machine.\n\n", fileName);
+        free_programFile_memory(programFile);
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    // The file must be whole and unchanged, and every record must point inside it (the nodes themselves are checked
+    // by get_programFile_graph)
+    int valid = header->fileSize == programFile->mappedFile.size &&
+                header->checksum == checksum_programFile(programFile->mappedFile.data, programFile->mappedFile.size) &&
+                header->programCount <= INT32_MAX &&
+                header->programsOffset % 8 == 0 && header->bucketsOffset % 4 == 0 &&
+                header->bucketCount > 0 && (header->bucketCount & (header->bucketCount - 1)) == 0 &&
+                header->bucketCount > header->programCount &&
+                in_programFile(programFile, header->programsOffset, header->programCount, sizeof(ProgramRecord)) &&
+                in_programFile(programFile, header->bucketsOffset, header->bucketCount, sizeof(uint32_t));
+    const ProgramRecord* programs = valid ? (const ProgramRecord*)(programFile->mappedFile.data +
+                                                                   header->programsOffset) : NULL;
+    for (uint32_t i = 0; valid && i < header->programCount; i++) {
+        const ProgramRecord* program = &programs[i];
+        valid = program->nodeCount > 0 && program->root >= 0 && program->root < program->nodeCount &&
+                program->variableCount >= 0 && program->valueCount >= program->nodeCount &&
+                program->nodesOffset % 8 == 0 && program->variableNamesOffset % 8 == 0 &&
+                in_programFile(programFile, program->nodesOffset, program->nodeCount, sizeof(GraphNode)) &&
+                in_programFile(programFile, program->variableNamesOffset, program->variableCount, sizeof(uint64_t)) &&
+                in_programFile(programFile, program->sourceOffset, (uint64_t)program->sourceLength + 1, 1) &&
+                programFile->mappedFile.data[program->sourceOffset + program->sourceLength] == '\0';
+    }
+    if (!valid) {
+        report_error(ERROR_CODE_FILE, -1, 0, "\nError: program file '%s' is damaged.\n\n", fileName);
+        free_programFile_memory(programFile);
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+
+    programFile->header = header;
+    programFile->programs = programs;
+    programFile->buckets = (const uint32_t*)(programFile->mappedFile.data + header->bucketsOffset);
+    programFile->programCount = (int)header->programCount;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int find_programFile_program(ProgramFile* programFile, const char* sourceString) {
+
+    // Validating function parameters
+    if (programFile == NULL || programFile->header == NULL || sourceString == NULL) {
+        return -1;
+    }
+
+    size_t sourceLength = strlen(sourceString);
+    uint32_t hash = hash_source(sourceString, sourceLength);
+    uint32_t mask = programFile->header->bucketCount - 1;
+    for (uint32_t bucket = hash & mask, probes = 0; probes <= mask; bucket = (bucket + 1) & mask, probes++) {
+        uint32_t entry = programFile->buckets[bucket];
+        if (entry == 0 || entry > (uint32_t)programFile->programCount) {
+            return -1;
+        }
+        const ProgramRecord* program = &programFile->programs[entry - 1];
+        if (program->sourceHash == hash && program->sourceLength == sourceLength &&
+            memcmp(programFile->mappedFile.data + program->sourceOffset, sourceString, sourceLength) == 0) {
+            return (int)entry - 1;
+        }
+    }
+
+    return -1;
+}
+
+
+int get_programFile_graph(ProgramFile* programFile, int index, ExpressionGraph* expressionGraph) {
+
+    // Validating function parameters
+    if (programFile == NULL || expressionGraph == NULL || index < 0 || index >= programFile->programCount) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // Operands must come before the nodes using them, variable slots and functions must exist
+    const ProgramRecord* program = &programFile->programs[index];
+    GraphNode* nodes = (GraphNode*)(programFile->mappedFile.data + program->nodesOffset);
+    for (int i = 0; i < program->nodeCount; i++) {
+        GraphNode* node = &nodes[i];
+        int valid = node->sincosPartner == -1 ||
+                    (node->sincosPartner >= 0 && node->sincosPartner < program->nodeCount && node->sincosPartner != i);
+        switch (node->typeToken) {
+            case TOKEN_NUMBER:
+                break;
+            case TOKEN_VARIABLE:
+                valid = valid && node->operands[0] >= 0 && node->operands[0] < program->variableCount;
+                break;
+            case TOKEN_OPERATOR_PLUS:
+            case TOKEN_OPERATOR_MINUS:
+            case TOKEN_OPERATOR_MULTIPLY:
+            case TOKEN_OPERATOR_DIVIDE:
+                valid = valid && node->operands[1] >= 0 && node->operands[1] < i;
+                // fall through
+            case TOKEN_FUNCTION:
+                valid = valid && node->operands[0] >= 0 && node->operands[0] < i &&
+                        (node->typeToken != TOKEN_FUNCTION || node->typeFunction < FUNCTION_INVALID);
+                break;
+            default:
+                valid = 0;
+        }
+        if (!valid) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+    }
+
+    expressionGraph->nodes = nodes;
+    expressionGraph->nodeCount = program->nodeCount;
+    expressionGraph->root = program->root;
+    expressionGraph->variableNames = NULL;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+const char* get_programFile_source(ProgramFile* programFile, int index) {
+
+    // Validating function parameters
+    if (programFile == NULL || index < 0 || index >= programFile->programCount) {
+        return NULL;
+    }
+
+    return programFile->mappedFile.data + programFile->programs[index].sourceOffset;
+}
+
+
+int get_programFile_variables(ProgramFile* programFile, int index, const char** variableNames) {
+
+    // Validating function parameters
+    if (programFile == NULL || index < 0 || index >= programFile->programCount) {
+        return -1;
+    }
+
+    const ProgramRecord* program = &programFile->programs[index];
+    const uint64_t* nameOffsets = (const uint64_t*)(programFile->mappedFile.data + program->variableNamesOffset);
+    for (int slot = 0; variableNames != NULL && slot < program->variableCount; slot++) {
+        uint64_t offset = nameOffsets[slot];
+        if (offset >= programFile->mappedFile.size ||
+            memchr(programFile->mappedFile.data + offset, '\0', programFile->mappedFile.size - offset) == NULL) {
+            return -1;
+        }
+        variableNames[slot] = programFile->mappedFile.data + offset;
+    }
+
+    return program->variableCount;
+}
+
+
+int free_programFile_memory(ProgramFile* programFile) {
+
+    // Validating function parameters
+    if (programFile == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    free_mappedFile_memory(&programFile->mappedFile);
+    programFile->header = NULL;
+    programFile->programs = NULL;
+    programFile->buckets = NULL;
+    programFile->programCount = 0;
+
+    // Subroutine ran successfully
+    return 0;
+}
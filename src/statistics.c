@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdatomic.h>
+
+#include "errors.h"
+#include "statistics.h"
+
+
+// Names of the phases, counters and peaks in the JSON output
+static const char* PHASE_NAMES[STATISTICS_PHASE_COUNT] = {"lex", "parse", "fold", "graph", "evaluate", "functions"};
+static const char* COUNTER_NAMES[STATISTICS_COUNTER_COUNT] = {
+    "tokens", "numbers", "slowNumbers", "allocations", "allocatedBytes"
+};
+static const char* PEAK_NAMES[STATISTICS_PEAK_COUNT] = {"operatorStack", "valueStack"};
+
+atomic_int statisticsEnabled;
+
+static atomic_ullong phaseCalls[STATISTICS_PHASE_COUNT];
+static atomic_ullong phaseNanoseconds[STATISTICS_PHASE_COUNT];
+static atomic_ullong counters[STATISTICS_COUNTER_COUNT];
+static atomic_ullong peaks[STATISTICS_PEAK_COUNT];
+
+
+void enable_statistics(int enabled) {
+#if !defined(MATH_EVALUATOR_NO_STATISTICS)
+    atomic_store_explicit(&statisticsEnabled, enabled != 0, memory_order_relaxed);
+#endif
+}
+
+
+void reset_statistics(void) {
+    for (int i = 0; i < STATISTICS_PHASE_COUNT; i++) {
+        atomic_store_explicit(&phaseCalls[i], 0, memory_order_relaxed);
+        atomic_store_explicit(&phaseNanoseconds[i], 0, memory_order_relaxed);
+    }
+    for (int i = 0; i < STATISTICS_COUNTER_COUNT; i++) {
+        atomic_store_explicit(&counters[i], 0, memory_order_relaxed);
+    }
+    for (int i = 0; i < STATISTICS_PEAK_COUNT; i++) {
+        atomic_store_explicit(&peaks[i], 0, memory_order_relaxed);
+    }
+}
+
+
+int get_statistics(Statistics* statistics) {
+
+    // Validating function parameters
+    if (statistics == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    for (int i = 0; i < STATISTICS_PHASE_COUNT; i++) {
+        statistics->phaseCalls[i] = atomic_load_explicit(&phaseCalls[i], memory_order_relaxed);
+        statistics->phaseNanoseconds[i] = atomic_load_explicit(&phaseNanoseconds[i], memory_order_relaxed);
+    }
+    for (int i = 0; i < STATISTICS_COUNTER_COUNT; i++) {
+        statistics->counters[i] = atomic_load_explicit(&counters[i], memory_order_relaxed);
+    }
+    for (int i = 0; i < STATISTICS_PEAK_COUNT; i++) {
+        statistics->peaks[i] = atomic_load_explicit(&peaks[i], memory_order_relaxed);
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int write_statistics_json(Statistics* statistics, FILE* output) {
+
+    // Validating function parameters
+    if (statistics == NULL || output == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    fprintf(output, "{\n  \"phases\": {\n");
+    for (int i = 0; i < STATISTICS_PHASE_COUNT; i++) {
+        fprintf(output, "    \"%s\": {\"calls\": %llu, \"nanoseconds\": %llu}%s\n", PHASE_NAMES[i],
+                statistics->phaseCalls[i], statistics->phaseNanoseconds[i], i + 1 < STATISTICS_PHASE_COUNT ? "," : "");
+    }
+    fprintf(output, "  },\n  \"counters\": {\n");
+    for (int i = 0; i < STATISTICS_COUNTER_COUNT; i++) {
+        fprintf(output, "    \"%s\": %llu%s\n", COUNTER_NAMES[i], statistics->counters[i],
+                i + 1 < STATISTICS_COUNTER_COUNT ? "," : "");
+    }
+    fprintf(output, "  },\n  \"peaks\": {\n");
+    for (int i = 0; i < STATISTICS_PEAK_COUNT; i++) {
+        fprintf(output, "    \"%s\": %llu%s\n", PEAK_NAMES[i], statistics->peaks[i],
+                i + 1 < STATISTICS_PEAK_COUNT ? "," : "");
+    }
+    fprintf(output, "  }\n}\n");
+
+    // Subroutine ran successfully
+    return ferror(output) ? ERROR_FATAL_FUNCTION_CALL : 0;
+}
+
+
+void record_statistics_phase(TypeStatisticsPhase phase, unsigned long long nanoseconds) {
+    atomic_fetch_add_explicit(&phaseCalls[phase], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&phaseNanoseconds[phase], nanoseconds, memory_order_relaxed);
+}
+
+
+void record_statistics_counter(TypeStatisticsCounter counter, unsigned long long value) {
+    atomic_fetch_add_explicit(&counters[counter], value, memory_order_relaxed);
+}
+
+
+void record_statistics_peak(TypeStatisticsPeak peak, unsigned long long value) {
+    unsigned long long current = atomic_load_explicit(&peaks[peak], memory_order_relaxed);
+    while (value > current &&
+           !atomic_compare_exchange_weak_explicit(&peaks[peak], &current, value, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
@@ -0,0 +1,984 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "errors.h"
+#include "statistics.h"
+#include "lex.h"
+#include "parser.h"
+#include "operations.h"
+#include "thread_pool.h"
+#include "stream.h"
+
+static const int INITIAL_LINE_CAPACITY = 256;  // Initial capacity of the line buffer (and of the token list)
+static const size_t BATCH_BYTES = 1 << 23;  // Input evaluated at once by evaluate_stream_parallel and evaluate_text
+static const size_t BATCH_CHUNK_LINES = 64;  // Lines per chunk handed to a worker
+static const size_t EXPRESSION_CHUNK_BYTES = 1 << 20;  // Input read at once by evaluate_stream_expression
+static const int INITIAL_EXPRESSION_STACK_CAPACITY = 64;  // Initial capacity of its operator and value stacks
+
+#define RESULT_TEXT_LENGTH 32  // Room for "%.17g\n" of any double
+
+
+// Structure for the buffers of one worker evaluating a batch (the buffers of evaluate_stream, one set per worker).
+typedef struct StreamBuffers {
+    TokenList tokenList;
+    StackTokenList postfixTokenList;
+    DoubleStack doubleStack;
+} StreamBuffers;
+
+
+// Structure for a batch of lines evaluated at once: the start and length of each line (lines are not null-terminated,
+// each one is followed by its line ending), the text of the result of each line and whether it failed, and the
+// buffers of each worker. The line and result arrays only grow, and are reused by the following batches.
+typedef struct StreamBatch {
+    char** lines;
+    int* lineLengths;
+    size_t lineCount;
+    size_t lineCapacity;
+    char (*resultTexts)[RESULT_TEXT_LENGTH];
+    unsigned char* lineFailed;
+    size_t resultCapacity;
+    StreamBuffers* buffers;
+    int bufferCount;
+} StreamBatch;
+
+
+// Structure for the window of the input evaluate_stream_expression lexes from. Includes the input, the buffer of the
+// characters read (null-terminated), their number and the position of the first one not consumed yet, the offset in
+// the input of the first character of the buffer, and whether the input was read to the end (or to a line ending).
+// Unless the input ended, more than a lexemme and the character after it are always buffered past the position.
+typedef struct ExpressionReader {
+    FILE* input;
+    char* buffer;
+    int length;
+    int position;
+    long long base;
+    int ended;
+} ExpressionReader;
+
+
+// Structure for an operator, parenthesis or function waiting on the operator stack of evaluate_stream_expression, with
+// the offset of its lexemme in the input.
+typedef struct ExpressionOperator {
+    long long position;
+    unsigned char typeToken;
+    unsigned char typeFunction;
+} ExpressionOperator;
+
+
+// Structure for the stacks of evaluate_stream_expression: the operators waiting for their operands and the values of
+// the operands, each with its top, capacity and deepest use.
+typedef struct ExpressionStacks {
+    ExpressionOperator* operators;
+    int operatorTop;
+    int operatorCapacity;
+    int operatorPeak;
+    double* values;
+    int valueTop;
+    int valueCapacity;
+    int valuePeak;
+} ExpressionStacks;
+
+
+// Reads the next line of `input` into `*buffer` without its line ending, growing the buffer (capacity stored in
+// `*bufferCapacity`) when a line does not fit. Returns the length of the line, -1 at the end of the input, and
+// -2 if memory could not be allocated. Errors are fatal.
+static int read_line(FILE* input, char** buffer, int* bufferCapacity) {
+
+    int length = 0;
+
+    while (fgets(*buffer + length, *bufferCapacity - length, input) != NULL) {
+        length += strlen(*buffer + length);
+
+        // The whole line was read
+        if (length > 0 && (*buffer)[length-1] == '\n') {
+            (*buffer)[--length] = '\0';
+            if (length > 0 && (*buffer)[length-1] == '\r') {
+                (*buffer)[--length] = '\0';
+            }
+            return length;
+        }
+
+        // The line did not fit, double the buffer and keep reading
+        if (length == *bufferCapacity - 1) {
+            char* tempBuffer = realloc(*buffer, *bufferCapacity * 2);
+            if (tempBuffer == NULL) {
+                return -2;
+            }
+            count_statistics_allocation(*bufferCapacity * 2);
+            *buffer = tempBuffer;
+            *bufferCapacity *= 2;
+        }
+    }
+
+    // Last line of the input without a line ending
+    if (length > 0) {
+        if ((*buffer)[length-1] == '\r') {
+            (*buffer)[--length] = '\0';
+        }
+        return length;
+    }
+    return -1;
+}
+
+
+int is_blank_line(char* line, int length) {
+
+    // Validating function parameters (lines too long to lex are not blank, they are reported when evaluated)
+    if (line == NULL || length < 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < length; i++) {
+        if (line[i] != ' ') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+// Lexes, parses and evaluates the expression in the `length` characters of `line` using the reusable buffers passed in.
+// Returns 0 upon success (answer written into `result`), 1 upon errors (messages are printed by each stage).
+static int evaluate_line(char* line, int length, TokenList* tokenList, StackTokenList* postfixTokenList,
+                         DoubleStack* doubleStack, double* result) {
+
+    if (length < 0) {
+        report_error(ERROR_CODE_SYNTAX, -1, 0, "\nError: expression too long.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    if (lexical_analyzer_length(line, length, tokenList) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (shunting_yard_algorithm(tokenList, postfixTokenList) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    if (postfixTokenList->top < 0) {
+        report_error(ERROR_CODE_SYNTAX, -1, 0, "\nError: empty expression.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    return evaluate_postfixTokenList(tokenList, postfixTokenList, NULL, doubleStack, result);
+}
+
+
+// Initializes `streamBatch` with one set of buffers for each of `bufferCount` workers.
+// Returns 0 upon success, 1 upon errors. Errors are fatal, free_streamBatch_memory must still be called.
+static int init_streamBatch(StreamBatch* streamBatch, int bufferCount) {
+
+    streamBatch->lineCount = 0;
+    streamBatch->lineCapacity = BATCH_BYTES / 16;
+    streamBatch->lines = malloc(streamBatch->lineCapacity * sizeof(char*));
+    streamBatch->lineLengths = malloc(streamBatch->lineCapacity * sizeof(int));
+    streamBatch->resultTexts = NULL;
+    streamBatch->lineFailed = NULL;
+    streamBatch->resultCapacity = 0;
+    streamBatch->buffers = calloc(bufferCount, sizeof(StreamBuffers));
+    streamBatch->bufferCount = streamBatch->buffers != NULL ? bufferCount : 0;
+    if (streamBatch->lines == NULL || streamBatch->lineLengths == NULL || streamBatch->buffers == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(streamBatch->lineCapacity * sizeof(char*));
+    count_statistics_allocation(streamBatch->lineCapacity * sizeof(int));
+    count_statistics_allocation(bufferCount * sizeof(StreamBuffers));
+
+    for (int i = 0; i < bufferCount; i++) {
+        StreamBuffers* buffers = &streamBatch->buffers[i];
+        if (init_tokenList(&buffers->tokenList, INITIAL_LINE_CAPACITY) != 0 ||
+            init_StackTokenList(&buffers->tokenList, &buffers->postfixTokenList) != 0 ||
+            init_doubleStack(&buffers->doubleStack, INITIAL_LINE_CAPACITY) != 0) {
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// Frees the arrays and the buffers of `streamBatch`.
+static void free_streamBatch_memory(StreamBatch* streamBatch) {
+
+    for (int i = 0; i < streamBatch->bufferCount; i++) {
+        StreamBuffers* buffers = &streamBatch->buffers[i];
+        if (buffers->tokenList.array != NULL) {
+            free_tokenList_memory(&buffers->tokenList);
+        }
+        if (buffers->postfixTokenList.array != NULL) {
+            free_stackTokenList_memory(&buffers->postfixTokenList);
+        }
+        if (buffers->doubleStack.array != NULL) {
+            free_doubleStack_memory(&buffers->doubleStack);
+        }
+    }
+    free(streamBatch->buffers);
+    free(streamBatch->resultTexts);
+    free(streamBatch->lineFailed);
+    free(streamBatch->lineLengths);
+    free(streamBatch->lines);
+}
+
+
+// Appends the lines of the `length` characters at `text` to `streamBatch`. Every line ends with '\n' (the last one may
+// end with `text[length]` instead, which must then be '\0'), and a '\r' before the line ending is not part of the
+// line. Returns 0 upon success, 1 upon errors. Errors are fatal.
+static int split_lines(StreamBatch* streamBatch, char* text, size_t length) {
+
+    char* lineStart = text;
+    char* textEnd = text + length;
+    while (lineStart < textEnd) {
+        char* lineEnd = memchr(lineStart, '\n', textEnd - lineStart);
+        char* nextLine = lineEnd != NULL ? lineEnd + 1 : textEnd;
+        if (lineEnd == NULL) {
+            lineEnd = textEnd;
+        }
+        if (lineEnd > lineStart && *(lineEnd-1) == '\r') {
+            lineEnd--;
+        }
+
+        if (streamBatch->lineCount == streamBatch->lineCapacity) {
+            char** tempLines = realloc(streamBatch->lines, streamBatch->lineCapacity * 2 * sizeof(char*));
+            if (tempLines == NULL) {
+                return ERROR_MEMORY_ALLOCATION_FAILURE;
+            }
+            count_statistics_allocation(streamBatch->lineCapacity * 2 * sizeof(char*));
+            streamBatch->lines = tempLines;
+            int* tempLengths = realloc(streamBatch->lineLengths, streamBatch->lineCapacity * 2 * sizeof(int));
+            if (tempLengths == NULL) {
+                return ERROR_MEMORY_ALLOCATION_FAILURE;
+            }
+            count_statistics_allocation(streamBatch->lineCapacity * 2 * sizeof(int));
+            streamBatch->lineLengths = tempLengths;
+            streamBatch->lineCapacity *= 2;
+        }
+
+        // Lines too long for the lexer are reported when they are evaluated
+        streamBatch->lines[streamBatch->lineCount] = lineStart;
+        size_t lineLength = lineEnd - lineStart;
+        streamBatch->lineLengths[streamBatch->lineCount] = lineLength < INT_MAX ? (int)lineLength : -1;
+        streamBatch->lineCount++;
+        lineStart = nextLine;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// ThreadPoolTask evaluating the lines `firstLine` to `firstLine + lineCount - 1` of the batch with the buffers of
+// `worker`.
+static int evaluate_lines_task(void* context, int worker, size_t firstLine, size_t lineCount) {
+
+    StreamBatch* streamBatch = context;
+    StreamBuffers* buffers = &streamBatch->buffers[worker];
+
+    for (size_t i = firstLine; i < firstLine + lineCount; i++) {
+        double result;
+        if (is_blank_line(streamBatch->lines[i], streamBatch->lineLengths[i])) {
+            streamBatch->lineFailed[i] = 0;
+            strcpy(streamBatch->resultTexts[i], "\n");
+            continue;
+        }
+        streamBatch->lineFailed[i] = evaluate_line(streamBatch->lines[i], streamBatch->lineLengths[i],
+                                                   &buffers->tokenList, &buffers->postfixTokenList,
+                                                   &buffers->doubleStack, &result) != 0;
+        if (streamBatch->lineFailed[i]) {
+            strcpy(streamBatch->resultTexts[i], "error\n");
+        }
+        else {
+            snprintf(streamBatch->resultTexts[i], RESULT_TEXT_LENGTH, "%.17g\n", result);
+        }
+    }
+
+    return 0;
+}
+
+
+// Evaluates the lines of `streamBatch`, on the workers of `threadPool` (in the calling thread if NULL), writes their
+// results to `output` in order, and empties the batch. `*lineNumber` is the number of lines before the batch, and is
+// advanced past it. Returns 0 upon success, 1 upon errors. Errors are fatal.
+static int run_streamBatch(StreamBatch* streamBatch, ThreadPool* threadPool, FILE* output, int* lineNumber,
+                           int* failedLines) {
+
+    if (streamBatch->lineCount > streamBatch->resultCapacity) {
+        free(streamBatch->resultTexts);
+        free(streamBatch->lineFailed);
+        streamBatch->resultCapacity = streamBatch->lineCapacity;
+        streamBatch->resultTexts = malloc(streamBatch->resultCapacity * RESULT_TEXT_LENGTH);
+        streamBatch->lineFailed = malloc(streamBatch->resultCapacity);
+        if (streamBatch->resultTexts == NULL || streamBatch->lineFailed == NULL) {
+            streamBatch->resultCapacity = 0;
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+        count_statistics_allocation(streamBatch->resultCapacity * RESULT_TEXT_LENGTH);
+        count_statistics_allocation(streamBatch->resultCapacity);
+    }
+
+    if (threadPool != NULL) {
+        run_threadPool(threadPool, evaluate_lines_task, streamBatch, streamBatch->lineCount, BATCH_CHUNK_LINES);
+    }
+    else {
+        evaluate_lines_task(streamBatch, 0, 0, streamBatch->lineCount);
+    }
+
+    for (size_t i = 0; i < streamBatch->lineCount; i++) {
+        (*lineNumber)++;
+        fputs(streamBatch->resultTexts[i], output);
+        if (streamBatch->lineFailed[i]) {
+            fprintf(stderr, "Error on line %d.\n", *lineNumber);
+            (*failedLines)++;
+        }
+    }
+    streamBatch->lineCount = 0;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// Reads the next batch of `input` into `*text` (capacity in `*textCapacity`), after the `*textLength` bytes of the
+// unfinished line left by the previous batch. `*textLength` becomes the number of bytes in `*text`, and `*consumed` the
+// number of them that are whole lines (the rest is the unfinished last line, `*text` is null-terminated after it at
+// the end of the input). Sets `*endOfInput` once the whole input was read. Returns 0 upon success, 1 upon errors
+// (memory, read errors). Errors are fatal.
+static int read_batch(FILE* input, char** text, size_t* textCapacity, size_t* textLength, size_t* consumed,
+                      int* endOfInput) {
+
+    // Read until the text holds a line ending, growing it when a single line does not fit
+    size_t end = 0;
+    while (!*endOfInput) {
+        size_t read = fread(*text + *textLength, 1, *textCapacity - 1 - *textLength, input);
+        for (size_t i = *textLength + read; i > *textLength; i--) {
+            if ((*text)[i-1] == '\n') {
+                end = i;
+                break;
+            }
+        }
+        *textLength += read;
+
+        // A short read is the end of the input (or a read error)
+        if (*textLength < *textCapacity - 1) {
+            if (ferror(input)) {
+                return ERROR_FATAL_FUNCTION_CALL;
+            }
+            *endOfInput = 1;
+        }
+        if (end > 0 || *endOfInput) {
+            break;
+        }
+
+        char* tempText = realloc(*text, *textCapacity * 2);
+        if (tempText == NULL) {
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+        count_statistics_allocation(*textCapacity * 2);
+        *text = tempText;
+        *textCapacity *= 2;
+    }
+
+    // The last line of the input needs no line ending
+    if (*endOfInput) {
+        end = *textLength;
+        (*text)[end] = '\0';
+    }
+    *consumed = end;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// Returns `position` as the position of a reported error, -1 if it does not fit in an int.
+static int to_error_position(long long position) {
+    return (position >= 0 && position <= INT_MAX) ? (int)position : -1;
+}
+
+
+// Returns the precedence of the binary operator `typeToken`, 0 for parentheses and functions (never applied by
+// another operator).
+static int get_operator_precedence(int typeToken) {
+    switch (typeToken) {
+        case TOKEN_OPERATOR_PLUS: return 1;
+        case TOKEN_OPERATOR_MINUS: return 1;
+        case TOKEN_OPERATOR_MULTIPLY: return 2;
+        case TOKEN_OPERATOR_DIVIDE: return 2;
+        default: return 0;
+    }
+}
+
+
+// Reads the next chunk of the input of `expressionReader` behind the characters not consumed yet, which are moved to
+// the start of the buffer. Returns 0 upon success, 1 upon read errors. Errors are fatal.
+static int refill_expressionReader(ExpressionReader* expressionReader) {
+
+    int remaining = expressionReader->length - expressionReader->position;
+    memmove(expressionReader->buffer, expressionReader->buffer + expressionReader->position, remaining);
+    expressionReader->base += expressionReader->position;
+    expressionReader->position = 0;
+
+    size_t read = fread(expressionReader->buffer + remaining, 1, EXPRESSION_CHUNK_BYTES, expressionReader->input);
+    expressionReader->length = remaining + (int)read;
+    expressionReader->buffer[expressionReader->length] = '\0';
+    if (read < EXPRESSION_CHUNK_BYTES) {
+        if (ferror(expressionReader->input)) {
+            report_error(ERROR_CODE_FILE, -1, 0, "\nError: input could not be read.\n");
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        expressionReader->ended = 1;
+    }
+
+    // Nothing past the line ending is part of the expression, no need to read further
+    if (memchr(expressionReader->buffer + remaining, '\n', read) != NULL ||
+        memchr(expressionReader->buffer + remaining, '\r', read) != NULL) {
+        expressionReader->ended = 1;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// Skips the blank lines (and spaces) at the start of the input of `expressionReader`, reading as many chunks as they
+// fill, so the expression is the first line holding something. Returns 0 upon success, 1 upon read errors (fatal).
+static int skip_blank_lines(ExpressionReader* expressionReader) {
+
+    char* buffer = expressionReader->buffer;
+    do {
+        if (refill_expressionReader(expressionReader) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        while (buffer[expressionReader->position] == ' ' || buffer[expressionReader->position] == '\n' ||
+               buffer[expressionReader->position] == '\r') {
+            expressionReader->position++;
+        }
+    } while (expressionReader->position == expressionReader->length && !feof(expressionReader->input));
+
+    // Only the line endings left after the expression's line starts mean there is no need to read further
+    int remaining = expressionReader->length - expressionReader->position;
+    expressionReader->ended = feof(expressionReader->input) ||
+                              memchr(buffer + expressionReader->position, '\n', remaining) != NULL ||
+                              memchr(buffer + expressionReader->position, '\r', remaining) != NULL;
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+// Scans the next token of the input of `expressionReader` into `token` (its value into `number` for a number), and
+// writes the offset of its lexemme in the input into `position`. Reads the next chunk first when a lexemme could be
+// cut by the end of the buffer. Returns 0 upon success, 1 upon errors (syntax, read errors). Errors are fatal.
+static int next_expression_token(ExpressionReader* expressionReader, Token* token, double* number,
+                                 long long* position) {
+
+    while (1) {
+        while (expressionReader->buffer[expressionReader->position] == ' ') {
+            expressionReader->position++;
+        }
+        if (expressionReader->ended || expressionReader->length - expressionReader->position > MAX_LEXEMME_LENGTH + 1) {
+            break;
+        }
+        if (refill_expressionReader(expressionReader) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+    }
+
+    // Token positions are relative to the buffer, errors are reported relative to the input
+    if (scan_token(expressionReader->buffer, expressionReader->position, token, number) != 0) {
+        shift_error_position(expressionReader->base);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    *position = expressionReader->base + token->offset;
+    if (token->typeToken == TOKEN_OPERATOR_POWER) {
+        report_error(ERROR_CODE_SYNTAX, to_error_position(*position), 1, "\nError: invalid character at '^'.\n");
+        return ERROR_INVALID_PROGRAM_USAGE;
+    }
+    expressionReader->position = token->offset + token->length;
+
+    return 0;
+}
+
+
+// Pushes the operator, parenthesis or function `typeToken` (`typeFunction`) found at `position` in the input onto the
+// operator stack of `expressionStacks`, growing it if needed. Returns 0 upon success, 1 upon errors (memory).
+static int push_expression_operator(ExpressionStacks* expressionStacks, TypeToken typeToken,
+                                    TypeFunction typeFunction, long long position) {
+
+    if (expressionStacks->operatorTop + 1 == expressionStacks->operatorCapacity) {
+        int capacity = expressionStacks->operatorCapacity * 2;
+        ExpressionOperator* tempOperators = realloc(expressionStacks->operators, capacity * sizeof(ExpressionOperator));
+        if (tempOperators == NULL) {
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+        count_statistics_allocation(capacity * sizeof(ExpressionOperator));
+        expressionStacks->operators = tempOperators;
+        expressionStacks->operatorCapacity = capacity;
+    }
+
+    ExpressionOperator* operator = &expressionStacks->operators[++expressionStacks->operatorTop];
+    operator->position = position;
+    operator->typeToken = (unsigned char)typeToken;
+    operator->typeFunction = (unsigned char)typeFunction;
+    if (expressionStacks->operatorTop >= expressionStacks->operatorPeak) {
+        expressionStacks->operatorPeak = expressionStacks->operatorTop + 1;
+    }
+    return 0;
+}
+
+
+// Pushes `value` onto the value stack of `expressionStacks`, growing it if needed.
+// Returns 0 upon success, 1 upon errors (memory).
+static int push_expression_value(ExpressionStacks* expressionStacks, double value) {
+
+    if (expressionStacks->valueTop + 1 == expressionStacks->valueCapacity) {
+        int capacity = expressionStacks->valueCapacity * 2;
+        double* tempValues = realloc(expressionStacks->values, capacity * sizeof(double));
+        if (tempValues == NULL) {
+            return ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+        count_statistics_allocation(capacity * sizeof(double));
+        expressionStacks->values = tempValues;
+        expressionStacks->valueCapacity = capacity;
+    }
+
+    expressionStacks->values[++expressionStacks->valueTop] = value;
+    if (expressionStacks->valueTop >= expressionStacks->valuePeak) {
+        expressionStacks->valuePeak = expressionStacks->valueTop + 1;
+    }
+    return 0;
+}
+
+
+// Pops the operator or function on top of the operator stack of `expressionStacks` and applies it to the values on top
+// of the value stack, as evaluate_postfixTokenList does when it reaches it in the postfix order.
+// Returns 0 upon success, 1 upon domain errors (a message is printed). Errors are fatal.
+static int apply_expression_operator(ExpressionStacks* expressionStacks) {
+
+    ExpressionOperator* operator = &expressionStacks->operators[expressionStacks->operatorTop--];
+    double* values = expressionStacks->values;
+    int top = expressionStacks->valueTop;
+
+    if (operator->typeToken == TOKEN_FUNCTION) {
+        double value;
+        TypeDomainError domainError = apply_function(operator->typeFunction, values[top], &value);
+        if (domainError != DOMAIN_VALID) {
+            print_domain_error(domainError, values[top]);
+            return ERROR_INVALID_PROGRAM_USAGE;
+        }
+        values[top] = value;
+        return 0;
+    }
+
+    top--;
+    switch (operator->typeToken) {
+        case TOKEN_OPERATOR_PLUS:
+            values[top] = values[top] + values[top + 1];
+            break;
+        case TOKEN_OPERATOR_MINUS:
+            values[top] = values[top] - values[top + 1];
+            break;
+        case TOKEN_OPERATOR_MULTIPLY:
+            values[top] = values[top] * values[top + 1];
+            break;
+        default:
+            if (values[top + 1] == 0) {
+                print_domain_error(DOMAIN_ERROR_DIVIDE_BY_ZERO, values[top + 1]);
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            values[top] = values[top] / values[top + 1];
+            break;
+    }
+    expressionStacks->valueTop = top;
+
+    return 0;
+}
+
+
+// Lexes, parses and evaluates the expression read by `expressionReader` one token at a time with the stacks of
+// `expressionStacks`: operators are applied as soon as the shunting yard algorithm would output them, so the stacks
+// only hold the operations still waiting for an operand. Variables take their values from the `variableCount` names
+// of `variableNames` and values of `variableValues`.
+// Returns 0 upon success (answer written into `result`), 1 upon errors (syntax, domain, unbound variables, memory).
+static int evaluate_streamed_expression(ExpressionReader* expressionReader, ExpressionStacks* expressionStacks,
+                                        char** variableNames, double* variableValues, int variableCount,
+                                        double* result) {
+
+    Token token;
+    double number;
+    long long position;
+    long long previousPosition = -1;
+    int previousLength = 0;
+    int expectOperand = 1;
+    unsigned long long tokenCount = 0;
+
+    while (1) {
+        if (next_expression_token(expressionReader, &token, &number, &position) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        tokenCount++;
+        TypeToken typeToken = (TypeToken)token.typeToken;
+
+        // An operand (number, constant, variable) or what opens one (parenthesis, function) is expected
+        if (expectOperand) {
+            double value;
+            int slot;
+            switch (typeToken) {
+                case TOKEN_NUMBER: value = number; break;
+                case TOKEN_KEYWORD_PI: value = CONSTANT_PI; break;
+                case TOKEN_KEYWORD_E: value = CONSTANT_E; break;
+                case TOKEN_VARIABLE:
+                    for (slot = 0; slot < variableCount; slot++) {
+                        if (strncmp(variableNames[slot], expressionReader->buffer + token.offset, token.length) == 0 &&
+                            variableNames[slot][token.length] == '\0') {
+                            break;
+                        }
+                    }
+                    if (slot == variableCount) {
+                        report_error(ERROR_CODE_UNBOUND_VARIABLE, to_error_position(position), token.length,
+                                     "Error: no value given for variable '%.*s'.\n", token.length,
+                                     expressionReader->buffer + token.offset);
+                        return ERROR_INVALID_PROGRAM_USAGE;
+                    }
+                    value = variableValues[slot];
+                    break;
+                case TOKEN_FUNCTION:
+                case TOKEN_OPEN_PARENTHESIS:
+                    if (push_expression_operator(expressionStacks, typeToken, (TypeFunction)token.typeFunction,
+                                                 position) != 0) {
+                        return ERROR_MEMORY_ALLOCATION_FAILURE;
+                    }
+                    previousPosition = position;
+                    previousLength = token.length;
+                    continue;
+                default:
+                    if (tokenCount == 1 && typeToken == TOKEN_EOF) {
+                        report_error(ERROR_CODE_SYNTAX, -1, 0, "\nError: empty expression.\n");
+                    }
+                    else if (typeToken == TOKEN_EOF || typeToken == TOKEN_CLOSED_PARENTHESIS) {
+                        report_error(ERROR_CODE_SYNTAX, to_error_position(previousPosition), previousLength,
+                                     "Error: invalid expression, missing operand.\n");
+                    }
+                    else {
+                        report_error(ERROR_CODE_SYNTAX, to_error_position(position), token.length,
+                                     "Error: invalid expression, missing operand.\n");
+                    }
+                    return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            if (push_expression_value(expressionStacks, value) != 0) {
+                return ERROR_MEMORY_ALLOCATION_FAILURE;
+            }
+            expectOperand = 0;
+            previousPosition = position;
+            previousLength = token.length;
+            continue;
+        }
+
+        // An operator, a closing parenthesis or the end is expected
+        ExpressionOperator* operators = expressionStacks->operators;
+        switch (typeToken) {
+            case TOKEN_OPERATOR_PLUS:
+            case TOKEN_OPERATOR_MINUS:
+            case TOKEN_OPERATOR_MULTIPLY:
+            case TOKEN_OPERATOR_DIVIDE: {
+                // The operators waiting on the stack binding at least as tightly (left associativity) are applied
+                int precedence = get_operator_precedence(typeToken);
+                while (expressionStacks->operatorTop >= 0 &&
+                       get_operator_precedence(operators[expressionStacks->operatorTop].typeToken) >= precedence) {
+                    if (apply_expression_operator(expressionStacks) != 0) {
+                        return ERROR_FATAL_FUNCTION_CALL;
+                    }
+                }
+                if (push_expression_operator(expressionStacks, typeToken, FUNCTION_INVALID, position) != 0) {
+                    return ERROR_MEMORY_ALLOCATION_FAILURE;
+                }
+                expectOperand = 1;
+                break;
+            }
+            case TOKEN_CLOSED_PARENTHESIS:
+                while (expressionStacks->operatorTop >= 0 &&
+                       operators[expressionStacks->operatorTop].typeToken != TOKEN_OPEN_PARENTHESIS) {
+                    if (apply_expression_operator(expressionStacks) != 0) {
+                        return ERROR_FATAL_FUNCTION_CALL;
+                    }
+                }
+                if (expressionStacks->operatorTop < 0) {
+                    report_error(ERROR_CODE_SYNTAX, to_error_position(position), 1,
+                                 "\nError: mismatched parentheses.\n");
+                    return ERROR_INVALID_PROGRAM_USAGE;
+                }
+                expressionStacks->operatorTop--;
+
+                // A function applies to its parenthesized argument
+                if (expressionStacks->operatorTop >= 0 &&
+                    operators[expressionStacks->operatorTop].typeToken == TOKEN_FUNCTION &&
+                    apply_expression_operator(expressionStacks) != 0) {
+                    return ERROR_FATAL_FUNCTION_CALL;
+                }
+                break;
+            case TOKEN_EOF:
+                while (expressionStacks->operatorTop >= 0) {
+                    ExpressionOperator* operator = &operators[expressionStacks->operatorTop];
+                    if (operator->typeToken == TOKEN_OPEN_PARENTHESIS) {
+                        report_error(ERROR_CODE_SYNTAX, to_error_position(operator->position), 1,
+                                     "\nError: mismatched parentheses.\n");
+                        return ERROR_INVALID_PROGRAM_USAGE;
+                    }
+                    if (apply_expression_operator(expressionStacks) != 0) {
+                        return ERROR_FATAL_FUNCTION_CALL;
+                    }
+                }
+                *result = expressionStacks->values[0];
+                count_statistics(STATISTICS_TOKENS, tokenCount);
+                raise_statistics_peak(STATISTICS_PEAK_OPERATOR_STACK, expressionStacks->operatorPeak);
+                raise_statistics_peak(STATISTICS_PEAK_VALUE_STACK, expressionStacks->valuePeak);
+                return 0;
+            default:
+                report_error(ERROR_CODE_SYNTAX, to_error_position(position), token.length,
+                             "Error: invalid expression, missing operator.\n");
+                return ERROR_INVALID_PROGRAM_USAGE;
+        }
+        previousPosition = position;
+        previousLength = token.length;
+    }
+}
+
+
+int evaluate_stream(FILE* input, FILE* output, int* failedLines) {
+
+    // Validating function parameters
+    if (input == NULL || output == NULL || failedLines == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    *failedLines = 0;
+
+    // Create the buffers shared by every line. They only grow when a longer line is found.
+    int lineCapacity = INITIAL_LINE_CAPACITY;
+    char* line = malloc(lineCapacity);
+    TokenList tokenList;
+    StackTokenList postfixTokenList;
+    DoubleStack doubleStack;
+    tokenList.array = NULL;
+    postfixTokenList.array = NULL;
+    doubleStack.array = NULL;
+
+    int status = 0;
+    if (line == NULL ||
+        init_tokenList(&tokenList, INITIAL_LINE_CAPACITY) != 0 ||
+        init_StackTokenList(&tokenList, &postfixTokenList) != 0 ||
+        init_doubleStack(&doubleStack, INITIAL_LINE_CAPACITY) != 0) {
+        status = ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    if (line != NULL) {
+        count_statistics_allocation(lineCapacity);
+    }
+
+    // Main loop, one expression per line
+    int lineNumber = 0;
+    while (status == 0) {
+
+        int length = read_line(input, &line, &lineCapacity);
+        if (length == -1) {
+            break;
+        }
+        if (length == -2) {
+            status = ERROR_MEMORY_ALLOCATION_FAILURE;
+            break;
+        }
+        lineNumber++;
+
+        // Blank lines hold no expression, an empty line keeps the results lined up with the input
+        double result;
+        if (is_blank_line(line, length)) {
+            fputc('\n', output);
+        }
+        else if (evaluate_line(line, length, &tokenList, &postfixTokenList, &doubleStack, &result) == 0) {
+            fprintf(output, "%.17g\n", result);
+        }
+        else {
+            fprintf(stderr, "Error on line %d.\n", lineNumber);
+            fprintf(output, "error\n");
+            (*failedLines)++;
+        }
+    }
+
+    // A read error is not the same as the end of the input
+    if (status == 0 && ferror(input)) {
+        status = ERROR_FATAL_FUNCTION_CALL;
+    }
+
+    // Free all memory
+    free(line);
+    if (tokenList.array != NULL) {
+        free_tokenList_memory(&tokenList);
+    }
+    if (postfixTokenList.array != NULL) {
+        free_stackTokenList_memory(&postfixTokenList);
+    }
+    if (doubleStack.array != NULL) {
+        free_doubleStack_memory(&doubleStack);
+    }
+
+    return status;
+}
+
+
+int evaluate_stream_parallel(FILE* input, FILE* output, ThreadPool* threadPool, int* failedLines) {
+
+    // Validating function parameters
+    if (input == NULL || output == NULL || threadPool == NULL || failedLines == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    *failedLines = 0;
+
+    // Create the text of a batch, and the batch with the buffers of each worker
+    size_t textCapacity = BATCH_BYTES;
+    char* text = malloc(textCapacity);
+    StreamBatch streamBatch;
+    int status = init_streamBatch(&streamBatch, threadPool->workerCount);
+    if (text == NULL) {
+        status = ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    else {
+        count_statistics_allocation(textCapacity);
+    }
+
+    // Main loop, one batch of lines at a time: evaluated by the workers, then written in input order
+    size_t textLength = 0;
+    int endOfInput = 0;
+    int lineNumber = 0;
+    while (status == 0 && !endOfInput) {
+
+        size_t consumed = 0;
+        status = read_batch(input, &text, &textCapacity, &textLength, &consumed, &endOfInput);
+        if (status == 0) {
+            status = split_lines(&streamBatch, text, consumed);
+        }
+        if (status == 0) {
+            status = run_streamBatch(&streamBatch, threadPool, output, &lineNumber, failedLines);
+        }
+
+        // Keep the unfinished last line for the next batch
+        textLength -= consumed;
+        memmove(text, text + consumed, textLength);
+    }
+
+    // Free all memory
+    free_streamBatch_memory(&streamBatch);
+    free(text);
+
+    return status;
+}
+
+
+int evaluate_text(char* text, size_t length, int nullTerminated, FILE* output, ThreadPool* threadPool,
+                  int* failedLines) {
+
+    // Validating function parameters
+    if ((text == NULL && length > 0) || output == NULL || failedLines == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    *failedLines = 0;
+
+    StreamBatch streamBatch;
+    int status = init_streamBatch(&streamBatch, threadPool != NULL ? threadPool->workerCount : 1);
+
+    // A last line without a line ending is copied, unless the text is null-terminated (the byte after it may not be
+    // readable otherwise)
+    size_t wholeLength = length;
+    while (!nullTerminated && wholeLength > 0 && text[wholeLength-1] != '\n') {
+        wholeLength--;
+    }
+    char* lastLine = NULL;
+    if (status == 0 && wholeLength < length) {
+        lastLine = malloc(length - wholeLength + 1);
+        if (lastLine == NULL) {
+            status = ERROR_MEMORY_ALLOCATION_FAILURE;
+        }
+        else {
+            count_statistics_allocation(length - wholeLength + 1);
+            memcpy(lastLine, text + wholeLength, length - wholeLength);
+            lastLine[length - wholeLength] = '\0';
+        }
+    }
+
+    // Main loop, one batch of whole lines at a time, lexed where they are in the text
+    size_t position = 0;
+    int lineNumber = 0;
+    while (status == 0 && position < wholeLength) {
+
+        size_t batchEnd = wholeLength;
+        if (wholeLength - position > BATCH_BYTES) {
+            char* lineEnd = memchr(text + position + BATCH_BYTES - 1, '\n', wholeLength - position - BATCH_BYTES + 1);
+            batchEnd = lineEnd != NULL ? (size_t)(lineEnd - text) + 1 : wholeLength;
+        }
+
+        status = split_lines(&streamBatch, text + position, batchEnd - position);
+        if (status == 0 && batchEnd == wholeLength && lastLine != NULL) {
+            status = split_lines(&streamBatch, lastLine, length - wholeLength);
+        }
+        if (status == 0) {
+            status = run_streamBatch(&streamBatch, threadPool, output, &lineNumber, failedLines);
+        }
+        position = batchEnd;
+    }
+    if (status == 0 && wholeLength == 0 && lastLine != NULL) {
+        status = split_lines(&streamBatch, lastLine, length);
+        if (status == 0) {
+            status = run_streamBatch(&streamBatch, threadPool, output, &lineNumber, failedLines);
+        }
+    }
+
+    // Free all memory
+    free_streamBatch_memory(&streamBatch);
+    free(lastLine);
+
+    return status;
+}
+
+
+int evaluate_stream_expression(FILE* input, char** variableNames, double* variableValues, int variableCount,
+                               double* result) {
+
+    // Validating function parameters
+    if (input == NULL || result == NULL || variableCount < 0 ||
+        (variableCount > 0 && (variableNames == NULL || variableValues == NULL))) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    // One chunk of input (and the end of the previous one), and stacks that only grow with the nesting depth
+    ExpressionReader expressionReader;
+    expressionReader.input = input;
+    expressionReader.buffer = malloc(EXPRESSION_CHUNK_BYTES + MAX_LEXEMME_LENGTH + 2);
+    expressionReader.length = 0;
+    expressionReader.position = 0;
+    expressionReader.base = 0;
+    expressionReader.ended = 0;
+    ExpressionStacks expressionStacks;
+    expressionStacks.operators = malloc(INITIAL_EXPRESSION_STACK_CAPACITY * sizeof(ExpressionOperator));
+    expressionStacks.operatorTop = -1;
+    expressionStacks.operatorCapacity = INITIAL_EXPRESSION_STACK_CAPACITY;
+    expressionStacks.operatorPeak = 0;
+    expressionStacks.values = malloc(INITIAL_EXPRESSION_STACK_CAPACITY * sizeof(double));
+    expressionStacks.valueTop = -1;
+    expressionStacks.valueCapacity = INITIAL_EXPRESSION_STACK_CAPACITY;
+    expressionStacks.valuePeak = 0;
+
+    int status = ERROR_MEMORY_ALLOCATION_FAILURE;
+    if (expressionReader.buffer != NULL && expressionStacks.operators != NULL && expressionStacks.values != NULL) {
+        count_statistics_allocation(EXPRESSION_CHUNK_BYTES + MAX_LEXEMME_LENGTH + 2);
+        count_statistics_allocation(INITIAL_EXPRESSION_STACK_CAPACITY * sizeof(ExpressionOperator));
+        count_statistics_allocation(INITIAL_EXPRESSION_STACK_CAPACITY * sizeof(double));
+        expressionReader.buffer[0] = '\0';
+        status = skip_blank_lines(&expressionReader);
+        if (status == 0) {
+            status = evaluate_streamed_expression(&expressionReader, &expressionStacks, variableNames, variableValues,
+                                                  variableCount, result);
+        }
+    }
+
+    // Free all memory
+    free(expressionReader.buffer);
+    free(expressionStacks.operators);
+    free(expressionStacks.values);
+
+    return status;
+}
@@ -0,0 +1,240 @@
+#define _POSIX_C_SOURCE 200809L  // For sysconf under strict C11
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "errors.h"
+#include "statistics.h"
+#include "thread_pool.h"
+
+
+// Returns the number of processors available to the process (at least 1).
+static int count_processors(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwNumberOfProcessors > 0 ? (int)systemInfo.dwNumberOfProcessors : 1;
+#else
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return processors > 0 ? (int)processors : 1;
+#endif
+}
+
+
+// Takes one chunk from the share of `worker`, from the front when `fromFront` is set (the owner) and from the back
+// otherwise (thieves). Writes its index into `chunk` and returns 1, or returns 0 if the share is empty.
+static int take_chunk(ThreadPoolWorker* worker, int fromFront, size_t* chunk) {
+
+    unsigned long long chunks = atomic_load_explicit(&worker->chunks, memory_order_relaxed);
+    while (1) {
+        unsigned long long first = chunks & 0xFFFFFFFFull;
+        unsigned long long end = chunks >> 32;
+        if (first >= end) {
+            return 0;
+        }
+
+        unsigned long long remaining = fromFront ? (end << 32) | (first + 1) : ((end - 1) << 32) | first;
+        if (atomic_compare_exchange_weak_explicit(&worker->chunks, &chunks, remaining,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            *chunk = fromFront ? first : end - 1;
+            return 1;
+        }
+    }
+}
+
+
+// Runs one chunk of the current loop of `threadPool` on worker `worker`.
+static void run_chunk(ThreadPool* threadPool, int worker, size_t chunk) {
+
+    size_t firstItem = chunk * threadPool->chunkSize;
+    size_t itemCount = threadPool->itemCount - firstItem < threadPool->chunkSize ?
+                       threadPool->itemCount - firstItem : threadPool->chunkSize;
+
+    if (threadPool->task(threadPool->context, worker, firstItem, itemCount) != 0) {
+        atomic_store_explicit(&threadPool->failed, 1, memory_order_relaxed);
+    }
+}
+
+
+// Runs the chunks of the share of worker `worker`, then steals from the others (the next worker first) until every
+// share is empty.
+static void run_worker(ThreadPool* threadPool, int worker) {
+
+    size_t chunk;
+    while (take_chunk(&threadPool->workers[worker], 1, &chunk)) {
+        run_chunk(threadPool, worker, chunk);
+    }
+
+    for (int i = 1; i < threadPool->workerCount; i++) {
+        ThreadPoolWorker* victim = &threadPool->workers[(worker + i) % threadPool->workerCount];
+        while (take_chunk(victim, 0, &chunk)) {
+            run_chunk(threadPool, worker, chunk);
+        }
+    }
+}
+
+
+// Main function of the threads of the pool: waits for a loop to start, works on it, and reports when done.
+static void* worker_thread(void* argument) {
+
+    ThreadPoolWorker* worker = argument;
+    ThreadPool* threadPool = worker->threadPool;
+    unsigned long long generation = 0;
+
+    pthread_mutex_lock(&threadPool->lock);
+    while (1) {
+        while (!threadPool->stopping && threadPool->generation == generation) {
+            pthread_cond_wait(&threadPool->start, &threadPool->lock);
+        }
+        if (threadPool->stopping) {
+            break;
+        }
+        generation = threadPool->generation;
+        pthread_mutex_unlock(&threadPool->lock);
+
+        run_worker(threadPool, worker->index);
+
+        pthread_mutex_lock(&threadPool->lock);
+        if (--threadPool->activeThreads == 0) {
+            pthread_cond_signal(&threadPool->done);
+        }
+    }
+    pthread_mutex_unlock(&threadPool->lock);
+
+    return NULL;
+}
+
+
+int init_threadPool(ThreadPool* threadPool, int workerCount) {
+
+    // Validating function parameters
+    if (threadPool == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    if (workerCount <= 0) {
+        workerCount = count_processors();
+    }
+
+    threadPool->workers = calloc(workerCount, sizeof(ThreadPoolWorker));
+    if (threadPool->workers == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(workerCount * sizeof(ThreadPoolWorker));
+    if (pthread_mutex_init(&threadPool->lock, NULL) != 0) {
+        free(threadPool->workers);
+        threadPool->workers = NULL;
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    pthread_cond_init(&threadPool->start, NULL);
+    pthread_cond_init(&threadPool->done, NULL);
+
+    threadPool->workerCount = 1;
+    threadPool->task = NULL;
+    threadPool->context = NULL;
+    threadPool->itemCount = 0;
+    threadPool->chunkSize = 1;
+    threadPool->generation = 0;
+    threadPool->activeThreads = 0;
+    threadPool->stopping = 0;
+    atomic_init(&threadPool->failed, 0);
+    for (int i = 0; i < workerCount; i++) {
+        atomic_init(&threadPool->workers[i].chunks, 0);
+        threadPool->workers[i].threadPool = threadPool;
+        threadPool->workers[i].index = i;
+    }
+
+    // Worker 0 is the thread calling run_threadPool, the others get a thread each
+    for (int i = 1; i < workerCount; i++) {
+        if (pthread_create(&threadPool->workers[i].thread, NULL, worker_thread, &threadPool->workers[i]) != 0) {
+            free_threadPool_memory(threadPool);
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        threadPool->workerCount++;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int run_threadPool(ThreadPool* threadPool, ThreadPoolTask task, void* context, size_t itemCount, size_t chunkSize) {
+
+    // Validating function parameters
+    if (threadPool == NULL || threadPool->workers == NULL || task == NULL || chunkSize == 0) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    if (itemCount == 0) {
+        return 0;
+    }
+
+    // Chunk indices must fit in 32 bits
+    if ((itemCount - 1) / chunkSize >= UINT32_MAX) {
+        chunkSize = (itemCount - 1) / (UINT32_MAX - 1) + 1;
+    }
+    size_t chunkCount = (itemCount - 1) / chunkSize + 1;
+
+    // Deal the chunks out in equal shares (published to the threads by the lock below)
+    int workerCount = threadPool->workerCount;
+    for (int i = 0; i < workerCount; i++) {
+        unsigned long long first = chunkCount * i / workerCount;
+        unsigned long long end = chunkCount * (i + 1) / workerCount;
+        atomic_store_explicit(&threadPool->workers[i].chunks, (end << 32) | first, memory_order_relaxed);
+    }
+    atomic_store_explicit(&threadPool->failed, 0, memory_order_relaxed);
+
+    pthread_mutex_lock(&threadPool->lock);
+    threadPool->task = task;
+    threadPool->context = context;
+    threadPool->itemCount = itemCount;
+    threadPool->chunkSize = chunkSize;
+    threadPool->activeThreads = workerCount - 1;
+    threadPool->generation++;
+    pthread_cond_broadcast(&threadPool->start);
+    pthread_mutex_unlock(&threadPool->lock);
+
+    // Work on the loop as worker 0, then wait for the threads (which makes their writes visible to the caller)
+    run_worker(threadPool, 0);
+
+    pthread_mutex_lock(&threadPool->lock);
+    while (threadPool->activeThreads > 0) {
+        pthread_cond_wait(&threadPool->done, &threadPool->lock);
+    }
+    pthread_mutex_unlock(&threadPool->lock);
+
+    return atomic_load_explicit(&threadPool->failed, memory_order_relaxed) ? ERROR_FATAL_FUNCTION_CALL : 0;
+}
+
+
+int free_threadPool_memory(ThreadPool* threadPool) {
+
+    // Validating function parameters
+    if (threadPool == NULL || threadPool->workers == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    pthread_mutex_lock(&threadPool->lock);
+    threadPool->stopping = 1;
+    pthread_cond_broadcast(&threadPool->start);
+    pthread_mutex_unlock(&threadPool->lock);
+
+    for (int i = 1; i < threadPool->workerCount; i++) {
+        pthread_join(threadPool->workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&threadPool->start);
+    pthread_cond_destroy(&threadPool->done);
+    pthread_mutex_destroy(&threadPool->lock);
+    free(threadPool->workers);
+    threadPool->workers = NULL;
+    threadPool->workerCount = 0;
+
+    // Subroutine ran successfully
+    return 0;
+}
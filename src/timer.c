@@ -0,0 +1,26 @@
+#define _POSIX_C_SOURCE 200809L  // For clock_gettime under strict C11
+
+#include <time.h>
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "timer.h"
+
+
+unsigned long long get_timer_nanoseconds(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    // Whole seconds and the remaining ticks are converted apart, so the product cannot overflow
+    unsigned long long ticks = counter.QuadPart;
+    unsigned long long ticksPerSecond = frequency.QuadPart;
+    return ticks / ticksPerSecond * 1000000000ull + ticks % ticksPerSecond * 1000000000ull / ticksPerSecond;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+#endif
+}
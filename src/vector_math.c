@@ -0,0 +1,492 @@
+#include <math.h>
+
+#include "lex.h"
+#include "operations.h"
+#include "vector_math.h"
+
+
+// Computes every value with apply_function, for compilers without vector extensions and CPUs without AVX2
+static void apply_function_scalar(TypeFunction typeFunction, const double* x, double* result, long long* rowErrors,
+                                  int count) {
+    for (int i = 0; i < count; i++) {
+        if (apply_function(typeFunction, x[i], &result[i]) != DOMAIN_VALID) {
+            rowErrors[i] = -1;
+        }
+    }
+}
+
+
+static void apply_sincos_scalar(const double* x, double* sinResult, double* cosResult, int count) {
+    for (int i = 0; i < count; i++) {
+        apply_sincos(x[i], &sinResult[i], &cosResult[i]);
+    }
+}
+
+
+#if defined(__GNUC__)
+
+// Vectors of 4 doubles (one AVX2 register), masks of the same shape (all bits of a lane set where a comparison holds)
+// and their bit patterns. Vector/scalar arithmetic broadcasts the scalar.
+typedef double VectorDouble __attribute__((vector_size(32)));
+typedef long long VectorMask __attribute__((vector_size(32)));
+typedef unsigned long long VectorBits __attribute__((vector_size(32)));
+#define VECTOR_LANES 4
+
+// On x86-64 the loops are compiled for AVX2 with FMA, and used when the CPU supports them (the SSE2 baseline needs
+// two registers per vector and is no faster than the C library). The kernels are always inlined into the loops so
+// that they are compiled for the same instruction set. Other targets run the loops as compiled.
+#if defined(__x86_64__)
+#define VECTOR_DISPATCH
+#endif
+#define VECTOR_KERNEL static inline __attribute__((always_inline))
+
+static const long long SIGN_BIT = (long long)0x8000000000000000ULL;
+static const double EPSILON = 1e-10;  // Same threshold as in apply_function
+
+// Round-to-nearest shifter: adding it leaves the integer nearest to a value (|value| < 2^51) in the low mantissa bits
+static const double ROUNDING_SHIFTER = 0x1.8p52;
+
+// Split of pi/2 into 33-bit parts (products with the quadrant count are exact), and 2/pi
+static const double PIO2_1 = 1.57079632673412561417e+00;
+static const double PIO2_2 = 6.07710050630396597660e-11;
+static const double PIO2_3 = 2.02226624871116645580e-21;
+static const double PIO2_3T = 8.47842766036889956997e-32;
+static const double INVPIO2 = 6.36619772367581382433e-01;
+static const double SINCOS_MAX_ARGUMENT = 1e5;  // The reduction above stays accurate up to here
+
+// sin and cos polynomials on [-pi/4, pi/4]
+static const double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03,
+                    S3 = -1.98412698298579493134e-04, S4 = 2.75573137070700676789e-06,
+                    S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+static const double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03,
+                    C3 = 2.48015872894767294178e-05, C4 = -2.75573143513906633035e-07,
+                    C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+
+// exp: reduction by ln(2) (the high part has trailing zeros, its products are exact) and the polynomial on
+// [-ln(2)/2, ln(2)/2]
+static const double LN2_HI = 6.93147180369123816490e-01, LN2_LO = 1.90821492927058770002e-10;
+static const double INVLN2 = 1.44269504088896338700e+00;
+static const double P1 = 1.66666666666666019037e-01, P2 = -2.77777777770155933842e-03,
+                    P3 = 6.61375632143793436117e-05, P4 = -1.65339022054652515390e-06,
+                    P5 = 4.13813679705723846039e-08;
+static const double EXP_MIN_ARGUMENT = -708.0, EXP_MAX_ARGUMENT = 709.0;  // Results are normal numbers in between
+
+// ln and log: polynomial of log(1+f) on [sqrt(2)/2 - 1, sqrt(2) - 1], and log10 constants
+static const double LG1 = 6.666666666666735130e-01, LG2 = 3.999999999940941908e-01,
+                    LG3 = 2.857142874366239149e-01, LG4 = 2.222219843214978396e-01,
+                    LG5 = 1.818357216161805012e-01, LG6 = 1.531383769920937332e-01,
+                    LG7 = 1.479819860511658591e-01;
+static const double SQRT2 = 1.41421356237309504880e+00;
+static const double IVLN10 = 4.34294481903251816668e-01;
+static const double LOG10_2HI = 3.01029995663611771306e-01, LOG10_2LO = 3.69423907715893078616e-13;
+
+// atan: reduction breakpoints, atan of each breakpoint (high and low parts), and the polynomial
+static const double ATAN_HI[4] = {4.63647609000806093515e-01, 7.85398163397448278999e-01,
+                                  9.82793723247329054082e-01, 1.57079632679489655800e+00};
+static const double ATAN_LO[4] = {2.26987774529616870924e-17, 3.06161699786838301793e-17,
+                                  1.39033110312309984516e-17, 6.12323399573676603587e-17};
+static const double AT0 = 3.33333333333329318027e-01, AT1 = -1.99999999998764832476e-01,
+                    AT2 = 1.42857142725034663711e-01, AT3 = -1.11111104054623557880e-01,
+                    AT4 = 9.09088713343650656196e-02, AT5 = -7.69187620504482999495e-02,
+                    AT6 = 6.66107313738753120669e-02, AT7 = -5.83357013379057348645e-02,
+                    AT8 = 4.97687799461593236017e-02, AT9 = -3.65315727442169155270e-02,
+                    AT10 = 1.62858201153657823623e-02;
+
+// asin and acos: rational approximation of (asin(x) - x) / x^3, and pi split in high and low parts
+static const double PS0 = 1.66666666666666657415e-01, PS1 = -3.25565818622400915405e-01,
+                    PS2 = 2.01212532134862925881e-01, PS3 = -4.00555345006794114027e-02,
+                    PS4 = 7.91534994289814532176e-04, PS5 = 3.47933107596021167570e-05,
+                    QS1 = -2.40339491173441421878e+00, QS2 = 2.02094576023350569471e+00,
+                    QS3 = -6.88283971605453293030e-01, QS4 = 7.70381505559019352791e-02;
+static const double PI = 3.14159265358979311600e+00;
+static const double PIO2_HI = 1.57079632679489655800e+00, PIO2_LO = 6.12323399573676603587e-17;
+static const double PIO4_HI = 7.85398163397448278999e-01;
+
+
+VECTOR_KERNEL VectorDouble broadcast(double value) {
+    VectorDouble vector;
+    for (int lane = 0; lane < VECTOR_LANES; lane++) {
+        vector[lane] = value;
+    }
+    return vector;
+}
+
+// Lanes of `a` where `mask` is set, lanes of `b` elsewhere
+VECTOR_KERNEL VectorDouble select_lanes(VectorMask mask, VectorDouble a, VectorDouble b) {
+    return (VectorDouble)(((VectorMask)a & mask) | ((VectorMask)b & ~mask));
+}
+
+VECTOR_KERNEL VectorDouble absolute(VectorDouble x) {
+    return (VectorDouble)((VectorMask)x & ~SIGN_BIT);
+}
+
+VECTOR_KERNEL VectorDouble square_root(VectorDouble x) {
+    VectorDouble result = x;
+    for (int lane = 0; lane < VECTOR_LANES; lane++) {
+        result[lane] = __builtin_sqrt(x[lane]);
+    }
+    return result;
+}
+
+// `x` with the low 32 bits of the mantissa cleared (so that its square is exact)
+VECTOR_KERNEL VectorDouble truncate_low_bits(VectorDouble x) {
+    return (VectorDouble)((VectorMask)x & (long long)0xFFFFFFFF00000000ULL);
+}
+
+// Comparisons of magnitudes, all bits of a lane are set where they hold. They are made on the bit patterns (those of
+// non-negative doubles are ordered like the values, NaN above infinity) with integer subtraction: GCC splits integer
+// arithmetic on vectors wider than the registers into register-wide instructions, but compares them lane by lane.
+VECTOR_KERNEL VectorMask magnitude_bits(VectorDouble x) {
+    return (VectorMask)x & ~SIGN_BIT;
+}
+
+VECTOR_KERNEL VectorMask negative_lanes(VectorMask difference) {
+    return -(VectorMask)((VectorBits)difference >> 63);
+}
+
+// |a| < |b|
+VECTOR_KERNEL VectorMask magnitude_less(VectorDouble a, VectorDouble b) {
+    return negative_lanes(magnitude_bits(a) - magnitude_bits(b));
+}
+
+// |a| <= |b|
+VECTOR_KERNEL VectorMask magnitude_less_equal(VectorDouble a, VectorDouble b) {
+    return ~negative_lanes(magnitude_bits(b) - magnitude_bits(a));
+}
+
+// x < 0 (including -0)
+VECTOR_KERNEL VectorMask sign_lanes(VectorDouble x) {
+    return negative_lanes((VectorMask)x);
+}
+
+VECTOR_KERNEL int any_lane(VectorMask mask) {
+    long long any = 0;
+    for (int lane = 0; lane < VECTOR_LANES; lane++) {
+        any |= mask[lane];
+    }
+    return any != 0;
+}
+
+
+// Sine and cosine of `x` (|x| <= SINCOS_MAX_ARGUMENT): reduction to r in [-pi/4, pi/4] and quadrant q, then
+// sin(x) = +-sin(r) or +-cos(r) depending on q (and cos(x) likewise)
+VECTOR_KERNEL void kernel_sincos(VectorDouble x, VectorDouble* sinValue, VectorDouble* cosValue) {
+
+    VectorDouble shifted = x * INVPIO2 + broadcast(ROUNDING_SHIFTER);
+    VectorMask quadrant = (VectorMask)shifted & 3;
+    VectorDouble n = shifted - ROUNDING_SHIFTER;
+    VectorDouble r = ((x - n * PIO2_1) - n * PIO2_2) - n * PIO2_3;
+    r = r - n * PIO2_3T;
+
+    VectorDouble z = r * r;
+    VectorDouble sinR = r + (z * r) * (S1 + z * (S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)))));
+    VectorDouble cosPolynomial = z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+    VectorDouble halfZ = 0.5 * z;
+    VectorDouble w = 1.0 - halfZ;
+    VectorDouble cosR = w + (((1.0 - w) - halfZ) + z * cosPolynomial);
+
+    VectorMask swap = -(quadrant & 1);
+    VectorMask sinSign = (quadrant & 2) << 62;
+    VectorMask cosSign = ((quadrant + 1) & 2) << 62;
+    *sinValue = (VectorDouble)((VectorMask)select_lanes(swap, cosR, sinR) ^ sinSign);
+    *cosValue = (VectorDouble)((VectorMask)select_lanes(swap, sinR, cosR) ^ cosSign);
+}
+
+
+// exp(x) for x in [EXP_MIN_ARGUMENT, EXP_MAX_ARGUMENT]: x = k*ln(2) + r, exp(x) = 2^k * exp(r)
+VECTOR_KERNEL VectorDouble kernel_exp(VectorDouble x) {
+
+    VectorDouble shifted = x * INVLN2 + broadcast(ROUNDING_SHIFTER);
+    VectorMask k = (VectorMask)shifted - (VectorMask)broadcast(ROUNDING_SHIFTER);
+    VectorDouble kDouble = shifted - ROUNDING_SHIFTER;
+
+    VectorDouble hi = x - kDouble * LN2_HI;
+    VectorDouble lo = kDouble * LN2_LO;
+    VectorDouble r = hi - lo;
+    VectorDouble z = r * r;
+    VectorDouble c = r - z * (P1 + z * (P2 + z * (P3 + z * (P4 + z * P5))));
+    VectorDouble y = 1.0 - ((lo - (r * c) / (2.0 - c)) - hi);
+
+    return y * (VectorDouble)((k + 1023) << 52);
+}
+
+
+// Natural logarithm of a positive normal `x`, returned as k*ln(2) + log(m) with the parts written separately:
+// `k` is the binary exponent, the returned value is log(m) for m = x / 2^k in [sqrt(2)/2, sqrt(2)).
+VECTOR_KERNEL VectorDouble kernel_log_mantissa(VectorDouble x, VectorDouble* k, VectorDouble* f, VectorDouble* tail) {
+
+    VectorMask bits = (VectorMask)x;
+    VectorMask exponent = (VectorMask)(((VectorBits)bits >> 52) & 0x7FF) - 1023;
+    VectorDouble m = (VectorDouble)((bits & 0x000FFFFFFFFFFFFFLL) | 0x3FF0000000000000LL);
+    VectorMask large = magnitude_less(broadcast(SQRT2), m);
+    m = select_lanes(large, m * 0.5, m);
+    exponent = exponent - large;  // The mask is -1 where set
+    *k = (VectorDouble)(exponent + (VectorMask)broadcast(ROUNDING_SHIFTER)) - ROUNDING_SHIFTER;  // Exact conversion
+
+    // log(1+f) = f - hfsq + s*(hfsq+R), with s = f/(2+f). `tail` is hfsq - s*(hfsq+R), so that the caller can add
+    // the exponent term before the rounding of f - tail.
+    *f = m - 1.0;
+    VectorDouble s = *f / (2.0 + *f);
+    VectorDouble z = s * s;
+    VectorDouble w = z * z;
+    VectorDouble t1 = w * (LG2 + w * (LG4 + w * LG6));
+    VectorDouble t2 = z * (LG1 + w * (LG3 + w * (LG5 + w * LG7)));
+    VectorDouble halfSquare = 0.5 * *f * *f;
+    *tail = halfSquare - s * (halfSquare + t1 + t2);
+    return *f - *tail;
+}
+
+VECTOR_KERNEL VectorDouble kernel_ln(VectorDouble x) {
+    VectorDouble k, f, tail;
+    kernel_log_mantissa(x, &k, &f, &tail);
+    return k * LN2_HI - ((tail - k * LN2_LO) - f);
+}
+
+VECTOR_KERNEL VectorDouble kernel_log10(VectorDouble x) {
+    VectorDouble k, f, tail;
+    VectorDouble logMantissa = kernel_log_mantissa(x, &k, &f, &tail);
+    return (k * LOG10_2LO + IVLN10 * logMantissa) + k * LOG10_2HI;
+}
+
+
+// atan(x) for any x: |x| is reduced by one of four breakpoints (or not at all below 0.4375), then
+// atan(|x|) = atan(breakpoint) + atan(t) with t small
+VECTOR_KERNEL VectorDouble kernel_atan(VectorDouble x) {
+
+    VectorDouble ax = absolute(x);
+    VectorMask beyond0 = magnitude_less_equal(broadcast(0.4375), x);
+    VectorMask beyond1 = magnitude_less_equal(broadcast(0.6875), x);
+    VectorMask beyond2 = magnitude_less_equal(broadcast(1.1875), x);
+    VectorMask beyond3 = magnitude_less_equal(broadcast(2.4375), x);
+
+    VectorDouble numerator = select_lanes(beyond0, 2.0 * ax - 1.0, ax);
+    VectorDouble denominator = select_lanes(beyond0, 2.0 + ax, broadcast(1.0));
+    VectorDouble hi = select_lanes(beyond0, broadcast(ATAN_HI[0]), broadcast(0.0));
+    VectorDouble lo = select_lanes(beyond0, broadcast(ATAN_LO[0]), broadcast(0.0));
+    numerator = select_lanes(beyond1, ax - 1.0, numerator);
+    denominator = select_lanes(beyond1, ax + 1.0, denominator);
+    hi = select_lanes(beyond1, broadcast(ATAN_HI[1]), hi);
+    lo = select_lanes(beyond1, broadcast(ATAN_LO[1]), lo);
+    numerator = select_lanes(beyond2, ax - 1.5, numerator);
+    denominator = select_lanes(beyond2, 1.0 + 1.5 * ax, denominator);
+    hi = select_lanes(beyond2, broadcast(ATAN_HI[2]), hi);
+    lo = select_lanes(beyond2, broadcast(ATAN_LO[2]), lo);
+    numerator = select_lanes(beyond3, broadcast(-1.0), numerator);
+    denominator = select_lanes(beyond3, ax, denominator);
+    hi = select_lanes(beyond3, broadcast(ATAN_HI[3]), hi);
+    lo = select_lanes(beyond3, broadcast(ATAN_LO[3]), lo);
+
+    VectorDouble t = numerator / denominator;
+    VectorDouble z = t * t;
+    VectorDouble w = z * z;
+    VectorDouble s1 = z * (AT0 + w * (AT2 + w * (AT4 + w * (AT6 + w * (AT8 + w * AT10)))));
+    VectorDouble s2 = w * (AT1 + w * (AT3 + w * (AT5 + w * (AT7 + w * AT9))));
+
+    // Without reduction hi = lo = 0 and this is t - t*(s1+s2), exactly
+    VectorDouble result = hi - ((t * (s1 + s2) - lo) - t);
+    return (VectorDouble)((VectorMask)result ^ ((VectorMask)x & SIGN_BIT));
+}
+
+
+// (asin(x) - x) / x^3 as p(t)/q(t) with t = x^2, used by asin and acos
+VECTOR_KERNEL VectorDouble asin_ratio(VectorDouble t) {
+    VectorDouble p = t * (PS0 + t * (PS1 + t * (PS2 + t * (PS3 + t * (PS4 + t * PS5)))));
+    VectorDouble q = 1.0 + t * (QS1 + t * (QS2 + t * (QS3 + t * QS4)));
+    return p / q;
+}
+
+// asin(x) for |x| < 1: directly below 0.5, through asin(x) = pi/2 - 2*asin(sqrt((1-|x|)/2)) above
+VECTOR_KERNEL VectorDouble kernel_asin(VectorDouble x) {
+
+    VectorDouble ax = absolute(x);
+    VectorDouble small = x + x * asin_ratio(x * x);
+
+    VectorDouble t = (1.0 - ax) * 0.5;
+    VectorDouble s = square_root(t);
+    VectorDouble r = asin_ratio(t);
+    VectorDouble high = truncate_low_bits(s);
+    VectorDouble c = (t - high * high) / (s + high);
+    VectorDouble p = 2.0 * s * r - (PIO2_LO - 2.0 * c);
+    VectorDouble q = PIO4_HI - 2.0 * high;
+    VectorDouble large = PIO4_HI - (p - q);
+    large = (VectorDouble)((VectorMask)large ^ ((VectorMask)x & SIGN_BIT));
+
+    return select_lanes(magnitude_less(x, broadcast(0.5)), small, large);
+}
+
+// acos(x) for |x| < 1: pi/2 - asin(x) below 0.5, through acos(x) = 2*asin(sqrt((1-x)/2)) (or pi minus that) above
+VECTOR_KERNEL VectorDouble kernel_acos(VectorDouble x) {
+
+    VectorDouble ax = absolute(x);
+    VectorDouble small = PIO2_HI - (x - (PIO2_LO - x * asin_ratio(x * x)));
+
+    VectorDouble z = (1.0 - ax) * 0.5;
+    VectorDouble s = square_root(z);
+    VectorDouble r = asin_ratio(z);
+    VectorDouble negative = PI - 2.0 * (s + (r * s - PIO2_LO));
+    VectorDouble high = truncate_low_bits(s);
+    VectorDouble c = (z - high * high) / (s + high);
+    VectorDouble positive = 2.0 * (high + (r * s + c));
+
+    VectorDouble large = select_lanes(sign_lanes(x), negative, positive);
+    return select_lanes(magnitude_less(x, broadcast(0.5)), small, large);
+}
+
+
+// Recomputes the lanes of `x` set in `scalarLanes` with apply_function (values outside the range of the kernel, and
+// arguments whose domain check is too close to call) into `result`, recording their domain errors in `rowErrors`.
+VECTOR_KERNEL void apply_scalar_lanes(TypeFunction typeFunction, VectorDouble x, VectorMask scalarLanes, double* result,
+                                      long long* rowErrors) {
+    for (int lane = 0; lane < VECTOR_LANES; lane++) {
+        if (scalarLanes[lane] != 0 && apply_function(typeFunction, x[lane], &result[lane]) != DOMAIN_VALID) {
+            rowErrors[lane] = -1;
+        }
+    }
+}
+
+
+VECTOR_KERNEL void apply_function_loop(TypeFunction typeFunction, const double* x, double* result, long long* rowErrors,
+                                       int count) {
+
+    const VectorDouble* xVectors = (const VectorDouble*)x;
+    VectorDouble* resultVectors = (VectorDouble*)result;
+    int vectorCount = count / VECTOR_LANES;
+
+    // Lanes outside the range of each kernel (NaN compares false, so it always lands there) go to apply_function
+    for (int v = 0; v < vectorCount; v++) {
+        VectorDouble value = xVectors[v];
+        VectorDouble sinValue, cosValue;
+        VectorMask scalarLanes;
+
+        switch (typeFunction) {
+            case FUNCTION_SIN:
+            case FUNCTION_COS:
+                kernel_sincos(value, &sinValue, &cosValue);
+                resultVectors[v] = typeFunction == FUNCTION_SIN ? sinValue : cosValue;
+                scalarLanes = ~magnitude_less_equal(value, broadcast(SINCOS_MAX_ARGUMENT));
+                break;
+            case FUNCTION_TAN:
+                // Arguments whose cosine is near the domain threshold are checked with the C library's cosine
+                kernel_sincos(value, &sinValue, &cosValue);
+                resultVectors[v] = sinValue / cosValue;
+                scalarLanes = ~magnitude_less_equal(value, broadcast(SINCOS_MAX_ARGUMENT)) |
+                              magnitude_less(cosValue, broadcast(2.0 * EPSILON));
+                break;
+            case FUNCTION_ASIN:
+                resultVectors[v] = kernel_asin(value);
+                scalarLanes = ~magnitude_less(value, broadcast(1.0));
+                break;
+            case FUNCTION_ACOS:
+                resultVectors[v] = kernel_acos(value);
+                scalarLanes = ~magnitude_less(value, broadcast(1.0));
+                break;
+            case FUNCTION_ATAN:
+                resultVectors[v] = kernel_atan(value);
+                scalarLanes = magnitude_less(broadcast(INFINITY), value);
+                break;
+            case FUNCTION_LN:
+                resultVectors[v] = kernel_ln(value);
+                scalarLanes = sign_lanes(value) | magnitude_less(value, broadcast(EPSILON)) |
+                              magnitude_less_equal(broadcast(INFINITY), value);
+                break;
+            case FUNCTION_LOG:
+                resultVectors[v] = kernel_log10(value);
+                scalarLanes = sign_lanes(value) | magnitude_less(value, broadcast(EPSILON)) |
+                              magnitude_less_equal(broadcast(INFINITY), value);
+                break;
+            case FUNCTION_EXP:
+                resultVectors[v] = kernel_exp(value);
+                scalarLanes = magnitude_less(select_lanes(sign_lanes(value), broadcast(EXP_MIN_ARGUMENT),
+                                                          broadcast(EXP_MAX_ARGUMENT)), value);
+                break;
+            default:
+                scalarLanes = ~(VectorMask){0};
+                break;
+        }
+
+        if (any_lane(scalarLanes)) {
+            apply_scalar_lanes(typeFunction, value, scalarLanes, result + v * VECTOR_LANES,
+                               rowErrors + v * VECTOR_LANES);
+        }
+    }
+}
+
+
+VECTOR_KERNEL void apply_sincos_loop(const double* x, double* sinResult, double* cosResult, int count) {
+
+    const VectorDouble* xVectors = (const VectorDouble*)x;
+    VectorDouble* sinVectors = (VectorDouble*)sinResult;
+    VectorDouble* cosVectors = (VectorDouble*)cosResult;
+
+    for (int v = 0; v < count / VECTOR_LANES; v++) {
+        VectorDouble value = xVectors[v];
+        kernel_sincos(value, &sinVectors[v], &cosVectors[v]);
+
+        VectorMask scalarLanes = ~magnitude_less_equal(value, broadcast(SINCOS_MAX_ARGUMENT));
+        if (any_lane(scalarLanes)) {
+            for (int lane = 0; lane < VECTOR_LANES; lane++) {
+                int i = v * VECTOR_LANES + lane;
+                if (scalarLanes[lane] != 0) {
+                    apply_sincos(value[lane], &sinResult[i], &cosResult[i]);
+                }
+            }
+        }
+    }
+}
+
+
+#if defined(VECTOR_DISPATCH)
+
+__attribute__((target("avx2,fma")))
+static void apply_function_avx2(TypeFunction typeFunction, const double* x, double* result, long long* rowErrors,
+                                int count) {
+    apply_function_loop(typeFunction, x, result, rowErrors, count);
+}
+
+__attribute__((target("avx2,fma")))
+static void apply_sincos_avx2(const double* x, double* sinResult, double* cosResult, int count) {
+    apply_sincos_loop(x, sinResult, cosResult, count);
+}
+
+#endif
+
+
+void vector_apply_function(TypeFunction typeFunction, const double* x, double* result, long long* rowErrors,
+                           int count) {
+#if defined(VECTOR_DISPATCH)
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+        apply_function_scalar(typeFunction, x, result, rowErrors, count);
+        return;
+    }
+    apply_function_avx2(typeFunction, x, result, rowErrors, count);
+#else
+    apply_function_loop(typeFunction, x, result, rowErrors, count);
+#endif
+}
+
+
+void vector_apply_sincos(const double* x, double* sinResult, double* cosResult, int count) {
+#if defined(VECTOR_DISPATCH)
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+        apply_sincos_scalar(x, sinResult, cosResult, count);
+        return;
+    }
+    apply_sincos_avx2(x, sinResult, cosResult, count);
+#else
+    apply_sincos_loop(x, sinResult, cosResult, count);
+#endif
+}
+
+#else
+
+void vector_apply_function(TypeFunction typeFunction, const double* x, double* result, long long* rowErrors,
+                           int count) {
+    apply_function_scalar(typeFunction, x, result, rowErrors, count);
+}
+
+
+void vector_apply_sincos(const double* x, double* sinResult, double* cosResult, int count) {
+    apply_sincos_scalar(x, sinResult, cosResult, count);
+}
+
+#endif
@@ -0,0 +1,537 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "statistics.h"
+#include "lex.h"
+#include "operations.h"
+#include "graph.h"
+#include "vm.h"
+
+
+#if defined(__GNUC__)
+#define VM_THREADED_DISPATCH  // Labels as values (computed goto) are a GNU extension, also supported by Clang
+#endif
+
+
+// Number of register operands read by each opcode (operands[0] of VM_VARIABLE is a variable slot, operands[1] of
+// VM_SINCOS is its second destination register)
+static const int REGISTER_OPERANDS[VM_OPCODE_COUNT] = {
+    [VM_CONSTANT] = 0, [VM_VARIABLE] = 0,
+    [VM_ADD] = 2, [VM_SUBTRACT] = 2, [VM_MULTIPLY] = 2, [VM_DIVIDE] = 2,
+    [VM_ADD_CONSTANT] = 1, [VM_CONSTANT_SUBTRACT] = 1, [VM_MULTIPLY_CONSTANT] = 1,
+    [VM_DIVIDE_CONSTANT] = 1, [VM_CONSTANT_DIVIDE] = 1,
+    [VM_MULTIPLY_ADD] = 3, [VM_MULTIPLY_SUBTRACT] = 3, [VM_SUBTRACT_MULTIPLY] = 3,
+    [VM_MULTIPLY_ADD_CONSTANT] = 2, [VM_MULTIPLY_CONSTANT_ADD] = 2,
+    [VM_FUNCTION] = 1, [VM_SINCOS] = 1, [VM_NEGATE] = 1, [VM_POWER] = 2, [VM_RETURN] = 1
+};
+
+
+// Structure for a graph being translated. Includes the graph, the instructions emitted so far (their operands and
+// destinations are still node indices), their number, the number of operations using each node, and flags marking
+// the multiplications fused into their user and the constants that must be loaded into a register.
+typedef struct VmTranslation {
+    ExpressionGraph* graph;
+    VmInstruction* instructions;
+    int instructionCount;
+    int* useCounts;
+    unsigned char* fusedProducts;
+    unsigned char* loadedConstants;
+} VmTranslation;
+
+
+// Returns 1 if `node` of the graph of `translation` is a constant, 0 otherwise
+static int is_constant(VmTranslation* translation, int node) {
+    return translation->graph->nodes[node].typeToken == TOKEN_NUMBER;
+}
+
+
+// Fills `instruction` with the operation of the graph node `node` and its operands.
+static void set_instruction(VmInstruction* instruction, TypeVmOpcode opcode, int node, int a, int b, int c,
+                            double constant) {
+    instruction->constant = constant;
+    instruction->destination = node;
+    instruction->operands[0] = a;
+    instruction->operands[1] = b;
+    instruction->operands[2] = c;
+    instruction->opcode = (unsigned char)opcode;
+    instruction->typeFunction = FUNCTION_INVALID;
+}
+
+
+// Appends an instruction computing `node` to `translation`, and marks the constants it reads from registers.
+static VmInstruction* emit_instruction(VmTranslation* translation, TypeVmOpcode opcode, int node, int a, int b, int c,
+                                       double constant) {
+    VmInstruction* instruction = &translation->instructions[translation->instructionCount++];
+    set_instruction(instruction, opcode, node, a, b, c, constant);
+    for (int i = 0; i < REGISTER_OPERANDS[opcode]; i++) {
+        if (is_constant(translation, instruction->operands[i])) {
+            translation->loadedConstants[instruction->operands[i]] = 1;
+        }
+    }
+    return instruction;
+}
+
+
+// Looks for a multiplication the addition or subtraction `node` can absorb (a product only `node` uses, with at most
+// one constant factor). Fills `fused` with the fused instruction and returns the node of the product if there is
+// one, -1 otherwise.
+static int find_fused_product(VmTranslation* translation, int node, VmInstruction* fused) {
+
+    GraphNode* nodes = translation->graph->nodes;
+    int addition = nodes[node].typeToken == TOKEN_OPERATOR_PLUS;
+    if (!addition && nodes[node].typeToken != TOKEN_OPERATOR_MINUS) {
+        return -1;
+    }
+
+    for (int side = 0; side < 2; side++) {
+        int product = nodes[node].operands[side];
+        int other = nodes[node].operands[1 - side];
+        if (nodes[product].typeToken != TOKEN_OPERATOR_MULTIPLY || translation->useCounts[product] != 1 ||
+            product == translation->graph->root) {
+            continue;
+        }
+
+        // The constant factor, if any, is the second one
+        int x = nodes[product].operands[0];
+        int y = nodes[product].operands[1];
+        if (is_constant(translation, x)) {
+            x = nodes[product].operands[1];
+            y = nodes[product].operands[0];
+        }
+        if (is_constant(translation, x)) {
+            continue;
+        }
+
+        // a*b + c, a*b - c, c - a*b, a*b + k, a*b - k (as a*b + -k) and a*k + c
+        if (!is_constant(translation, y) && !is_constant(translation, other)) {
+            TypeVmOpcode opcode = VM_MULTIPLY_ADD;
+            if (!addition) {
+                opcode = side == 0 ? VM_MULTIPLY_SUBTRACT : VM_SUBTRACT_MULTIPLY;
+            }
+            set_instruction(fused, opcode, node, x, y, other, 0.0);
+            return product;
+        }
+        if (!is_constant(translation, y) && (addition || side == 0)) {
+            double constant = addition ? nodes[other].value : -nodes[other].value;
+            set_instruction(fused, VM_MULTIPLY_ADD_CONSTANT, node, x, y, -1, constant);
+            return product;
+        }
+        if (!is_constant(translation, other) && addition) {
+            set_instruction(fused, VM_MULTIPLY_CONSTANT_ADD, node, x, other, -1, nodes[y].value);
+            return product;
+        }
+    }
+
+    return -1;
+}
+
+
+// Appends the instruction computing the binary operation `node`, with constant operands folded into it when possible
+static void emit_binary_operation(VmTranslation* translation, int node) {
+
+    GraphNode* nodes = translation->graph->nodes;
+    VmInstruction fused;
+    if (find_fused_product(translation, node, &fused) != -1) {
+        translation->instructions[translation->instructionCount++] = fused;
+        return;
+    }
+
+    int a = nodes[node].operands[0];
+    int b = nodes[node].operands[1];
+    int constantA = is_constant(translation, a) && !is_constant(translation, b);
+    int constantB = is_constant(translation, b) && !is_constant(translation, a);
+    switch (nodes[node].typeToken) {
+        case TOKEN_OPERATOR_PLUS:
+            if (constantA || constantB) {
+                emit_instruction(translation, VM_ADD_CONSTANT, node, constantA ? b : a, -1, -1,
+                                 nodes[constantA ? a : b].value);
+                return;
+            }
+            emit_instruction(translation, VM_ADD, node, a, b, -1, 0.0);
+            return;
+        case TOKEN_OPERATOR_MINUS:
+            if (constantA || constantB) {
+                emit_instruction(translation, constantA ? VM_CONSTANT_SUBTRACT : VM_ADD_CONSTANT, node,
+                                 constantA ? b : a, -1, -1, constantA ? nodes[a].value : -nodes[b].value);
+                return;
+            }
+            emit_instruction(translation, VM_SUBTRACT, node, a, b, -1, 0.0);
+            return;
+        case TOKEN_OPERATOR_MULTIPLY:
+            if (constantA || constantB) {
+                emit_instruction(translation, VM_MULTIPLY_CONSTANT, node, constantA ? b : a, -1, -1,
+                                 nodes[constantA ? a : b].value);
+                return;
+            }
+            emit_instruction(translation, VM_MULTIPLY, node, a, b, -1, 0.0);
+            return;
+        default:
+            // Dividing by a constant zero is left to VM_DIVIDE, which reports the error
+            if (constantA || (constantB && nodes[b].value != 0)) {
+                emit_instruction(translation, constantA ? VM_CONSTANT_DIVIDE : VM_DIVIDE_CONSTANT, node,
+                                 constantA ? b : a, -1, -1, nodes[constantA ? a : b].value);
+                return;
+            }
+            emit_instruction(translation, VM_DIVIDE, node, a, b, -1, 0.0);
+            return;
+    }
+}
+
+
+// Replaces the node indices of the instructions of `vmProgram` by registers. Walking the instructions in order, the
+// register of a node is given back once its last reader has read it, and reused by the next result.
+// Returns 0 upon success, 1 upon errors (memory allocation). Errors are fatal.
+static int allocate_registers(VmProgram* vmProgram, int nodeCount) {
+
+    int* lastUses = malloc(3 * nodeCount * sizeof(int));
+    if (lastUses == NULL) {
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation(3 * nodeCount * sizeof(int));
+    int* nodeRegisters = lastUses + nodeCount;
+    int* freeRegisters = nodeRegisters + nodeCount;
+    int freeCount = 0;
+
+    for (int i = 0; i < nodeCount; i++) {
+        lastUses[i] = -1;
+        nodeRegisters[i] = -1;
+    }
+    for (int i = 0; i < vmProgram->instructionCount; i++) {
+        VmInstruction* instruction = &vmProgram->instructions[i];
+        for (int operand = 0; operand < REGISTER_OPERANDS[instruction->opcode]; operand++) {
+            lastUses[instruction->operands[operand]] = i;
+        }
+    }
+
+    vmProgram->registerCount = 0;
+    for (int i = 0; i < vmProgram->instructionCount; i++) {
+        VmInstruction* instruction = &vmProgram->instructions[i];
+        int operandNodes[3];
+
+        // Read the operands, then give back the registers read for the last time
+        for (int operand = 0; operand < REGISTER_OPERANDS[instruction->opcode]; operand++) {
+            operandNodes[operand] = instruction->operands[operand];
+            instruction->operands[operand] = nodeRegisters[operandNodes[operand]];
+        }
+        for (int operand = 0; operand < REGISTER_OPERANDS[instruction->opcode]; operand++) {
+            int node = operandNodes[operand];
+            if (lastUses[node] == i && nodeRegisters[node] != -1) {
+                freeRegisters[freeCount++] = nodeRegisters[node];
+                nodeRegisters[node] = -1;
+            }
+        }
+        if (instruction->opcode == VM_RETURN) {
+            continue;
+        }
+
+        // Destinations (two for VM_SINCOS), a value nothing reads gets its register back at once
+        int destinations[2] = {instruction->destination, -1};
+        if (instruction->opcode == VM_SINCOS) {
+            destinations[1] = instruction->operands[1];
+        }
+        for (int j = 0; j < 2 && destinations[j] != -1; j++) {
+            int node = destinations[j];
+            nodeRegisters[node] = freeCount > 0 ? freeRegisters[--freeCount] : vmProgram->registerCount++;
+            if (j == 0) {
+                instruction->destination = nodeRegisters[node];
+            }
+            else {
+                instruction->operands[1] = nodeRegisters[node];
+            }
+        }
+        for (int j = 0; j < 2 && destinations[j] != -1; j++) {
+            if (lastUses[destinations[j]] < i) {
+                freeRegisters[freeCount++] = nodeRegisters[destinations[j]];
+                nodeRegisters[destinations[j]] = -1;
+            }
+        }
+    }
+
+    free(lastUses);
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int compile_vmProgram(ExpressionGraph* expressionGraph, VmProgram* vmProgram) {
+
+    // Validating function parameters
+    if (expressionGraph == NULL || expressionGraph->nodes == NULL || vmProgram == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+    int nodeCount = expressionGraph->nodeCount;
+    GraphNode* nodes = expressionGraph->nodes;
+
+    // Room for one instruction per node, one constant load per node, and the return. The operations are emitted
+    // after the room left for the constant loads, which are only known once every operation has been emitted
+    VmInstruction* instructions = malloc((2 * nodeCount + 1) * sizeof(VmInstruction));
+    int* useCounts = calloc(nodeCount, sizeof(int));
+    unsigned char* flags = calloc(2 * nodeCount, 1);
+    if (instructions == NULL || useCounts == NULL || flags == NULL) {
+        free(instructions);
+        free(useCounts);
+        free(flags);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+    count_statistics_allocation((2 * nodeCount + 1) * sizeof(VmInstruction));
+    count_statistics_allocation(nodeCount * sizeof(int));
+    count_statistics_allocation(2 * nodeCount);
+    VmTranslation translation = {expressionGraph, instructions + nodeCount, 0, useCounts, flags, flags + nodeCount};
+
+    // Count the users of each node, then find the multiplications fused into an addition or a subtraction
+    for (int i = 0; i < nodeCount; i++) {
+        if (nodes[i].typeToken == TOKEN_FUNCTION) {
+            useCounts[nodes[i].operands[0]]++;
+        }
+        else if (nodes[i].typeToken != TOKEN_NUMBER && nodes[i].typeToken != TOKEN_VARIABLE) {
+            useCounts[nodes[i].operands[0]]++;
+            useCounts[nodes[i].operands[1]]++;
+        }
+    }
+    for (int i = 0; i < nodeCount; i++) {
+        VmInstruction fused;
+        int product = find_fused_product(&translation, i, &fused);
+        if (product != -1) {
+            translation.fusedProducts[product] = 1;
+        }
+    }
+
+    // One instruction per node in graph order, so errors are met in the same order as by the graph interpreter
+    vmProgram->hasVariables = 0;
+    for (int i = 0; i < nodeCount; i++) {
+        GraphNode* node = &nodes[i];
+        if (translation.fusedProducts[i]) {
+            continue;
+        }
+        switch (node->typeToken) {
+            case TOKEN_NUMBER:
+                break;
+            case TOKEN_VARIABLE:
+                emit_instruction(&translation, VM_VARIABLE, i, node->operands[0], -1, -1, 0.0);
+                vmProgram->hasVariables = 1;
+                break;
+            case TOKEN_FUNCTION:
+                // Fused sin and cos are both computed by the first node of the pair
+                if (node->sincosPartner == -1) {
+                    emit_instruction(&translation, VM_FUNCTION, i, node->operands[0], -1, -1, 0.0)->typeFunction =
+                        node->typeFunction;
+                }
+                else if (node->sincosPartner > i) {
+                    int sinNode = node->typeFunction == FUNCTION_SIN ? i : node->sincosPartner;
+                    int cosNode = node->typeFunction == FUNCTION_SIN ? node->sincosPartner : i;
+                    emit_instruction(&translation, VM_SINCOS, sinNode, node->operands[0], cosNode, -1, 0.0);
+                }
+                break;
+            default:
+                emit_binary_operation(&translation, i);
+        }
+    }
+    emit_instruction(&translation, VM_RETURN, -1, expressionGraph->root, -1, -1, 0.0);
+
+    // Constants read from registers are loaded first, followed by the operations
+    int loadCount = 0;
+    for (int i = 0; i < nodeCount; i++) {
+        if (translation.loadedConstants[i]) {
+            set_instruction(&instructions[loadCount++], VM_CONSTANT, i, -1, -1, -1, nodes[i].value);
+        }
+    }
+    memmove(instructions + loadCount, translation.instructions, translation.instructionCount * sizeof(VmInstruction));
+    free(useCounts);
+    free(flags);
+
+    vmProgram->instructions = instructions;
+    vmProgram->instructionCount = loadCount + translation.instructionCount;
+    vmProgram->variableNames = expressionGraph->variableNames;
+    if (allocate_registers(vmProgram, nodeCount) != 0) {
+        free_vmProgram_memory(vmProgram);
+        return ERROR_MEMORY_ALLOCATION_FAILURE;
+    }
+
+    // Subroutine ran successfully
+    return 0;
+}
+
+
+int evaluate_vmProgram(VmProgram* vmProgram, double* variableValues, double* registers, double* result) {
+
+    // Validating function parameters
+    if (vmProgram == NULL || vmProgram->instructions == NULL || registers == NULL || result == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    VmInstruction* instruction = vmProgram->instructions;
+    double value;
+    TypeDomainError domainError;
+
+    // Each instruction ends by jumping straight to the next one (threaded dispatch), or back to the switch otherwise
+#if defined(VM_THREADED_DISPATCH)
+    static const void* const dispatchTable[VM_OPCODE_COUNT] = {
+        [VM_CONSTANT] = &&VM_CONSTANT_label, [VM_VARIABLE] = &&VM_VARIABLE_label,
+        [VM_ADD] = &&VM_ADD_label, [VM_SUBTRACT] = &&VM_SUBTRACT_label,
+        [VM_MULTIPLY] = &&VM_MULTIPLY_label, [VM_DIVIDE] = &&VM_DIVIDE_label,
+        [VM_ADD_CONSTANT] = &&VM_ADD_CONSTANT_label, [VM_CONSTANT_SUBTRACT] = &&VM_CONSTANT_SUBTRACT_label,
+        [VM_MULTIPLY_CONSTANT] = &&VM_MULTIPLY_CONSTANT_label, [VM_DIVIDE_CONSTANT] = &&VM_DIVIDE_CONSTANT_label,
+        [VM_CONSTANT_DIVIDE] = &&VM_CONSTANT_DIVIDE_label, [VM_MULTIPLY_ADD] = &&VM_MULTIPLY_ADD_label,
+        [VM_MULTIPLY_SUBTRACT] = &&VM_MULTIPLY_SUBTRACT_label, [VM_SUBTRACT_MULTIPLY] = &&VM_SUBTRACT_MULTIPLY_label,
+        [VM_MULTIPLY_ADD_CONSTANT] = &&VM_MULTIPLY_ADD_CONSTANT_label,
+        [VM_MULTIPLY_CONSTANT_ADD] = &&VM_MULTIPLY_CONSTANT_ADD_label,
+        [VM_FUNCTION] = &&VM_FUNCTION_label, [VM_SINCOS] = &&VM_SINCOS_label,
+        [VM_NEGATE] = &&VM_NEGATE_label, [VM_POWER] = &&VM_POWER_label, [VM_RETURN] = &&VM_RETURN_label
+    };
+#define VM_OPERATION(opcode) opcode##_label:
+#define VM_NEXT() instruction++; goto *dispatchTable[instruction->opcode]
+    goto *dispatchTable[instruction->opcode];
+    {
+#else
+#define VM_OPERATION(opcode) case opcode:
+#define VM_NEXT() instruction++; goto dispatch
+dispatch:
+    switch ((TypeVmOpcode)instruction->opcode) {
+#endif
+
+#define D registers[instruction->destination]
+#define A registers[instruction->operands[0]]
+#define B registers[instruction->operands[1]]
+#define C registers[instruction->operands[2]]
+#define K instruction->constant
+
+        VM_OPERATION(VM_CONSTANT)
+            D = K;
+            VM_NEXT();
+        VM_OPERATION(VM_VARIABLE)
+            if (variableValues == NULL) {
+                if (vmProgram->variableNames == NULL) {
+                    report_error(ERROR_CODE_UNBOUND_VARIABLE, -1, 0,
+                                 "Error: no value given for the variable in slot %d.\n", instruction->operands[0]);
+                }
+                else {
+                    report_error(ERROR_CODE_UNBOUND_VARIABLE, -1, 0, "Error: no value given for variable '%s'.\n",
+                                 vmProgram->variableNames[instruction->operands[0]]);
+                }
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            D = variableValues[instruction->operands[0]];
+            VM_NEXT();
+        VM_OPERATION(VM_ADD)
+            D = A + B;
+            VM_NEXT();
+        VM_OPERATION(VM_SUBTRACT)
+            D = A - B;
+            VM_NEXT();
+        VM_OPERATION(VM_MULTIPLY)
+            D = A * B;
+            VM_NEXT();
+        VM_OPERATION(VM_DIVIDE)
+            if (B == 0) {
+                print_domain_error(DOMAIN_ERROR_DIVIDE_BY_ZERO, 0.0);
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            D = A / B;
+            VM_NEXT();
+        VM_OPERATION(VM_ADD_CONSTANT)
+            D = A + K;
+            VM_NEXT();
+        VM_OPERATION(VM_CONSTANT_SUBTRACT)
+            D = K - A;
+            VM_NEXT();
+        VM_OPERATION(VM_MULTIPLY_CONSTANT)
+            D = A * K;
+            VM_NEXT();
+        VM_OPERATION(VM_DIVIDE_CONSTANT)
+            D = A / K;
+            VM_NEXT();
+        VM_OPERATION(VM_CONSTANT_DIVIDE)
+            if (A == 0) {
+                print_domain_error(DOMAIN_ERROR_DIVIDE_BY_ZERO, 0.0);
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            D = K / A;
+            VM_NEXT();
+
+        // The product is rounded before the addition (no fused multiply-add), as when it was its own node
+        VM_OPERATION(VM_MULTIPLY_ADD)
+            value = A * B;
+            D = value + C;
+            VM_NEXT();
+        VM_OPERATION(VM_MULTIPLY_SUBTRACT)
+            value = A * B;
+            D = value - C;
+            VM_NEXT();
+        VM_OPERATION(VM_SUBTRACT_MULTIPLY)
+            value = A * B;
+            D = C - value;
+            VM_NEXT();
+        VM_OPERATION(VM_MULTIPLY_ADD_CONSTANT)
+            value = A * B;
+            D = value + K;
+            VM_NEXT();
+        VM_OPERATION(VM_MULTIPLY_CONSTANT_ADD)
+            value = A * K;
+            D = value + B;
+            VM_NEXT();
+
+        VM_OPERATION(VM_FUNCTION)
+            domainError = apply_function((TypeFunction)instruction->typeFunction, A, &value);
+            if (domainError != DOMAIN_VALID) {
+                print_domain_error(domainError, A);
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            D = value;
+            VM_NEXT();
+        VM_OPERATION(VM_SINCOS) {
+            double cosValue;
+            apply_sincos(A, &value, &cosValue);
+            D = value;
+            B = cosValue;
+            VM_NEXT();
+        }
+        VM_OPERATION(VM_NEGATE)
+            D = -A;
+            VM_NEXT();
+        VM_OPERATION(VM_POWER)
+            domainError = apply_operator(TOKEN_OPERATOR_POWER, A, B, &value);
+            if (domainError != DOMAIN_VALID) {
+                print_domain_error(domainError, A);
+                return ERROR_INVALID_PROGRAM_USAGE;
+            }
+            D = value;
+            VM_NEXT();
+        VM_OPERATION(VM_RETURN)
+            *result = A;
+            return 0;
+
+#if !defined(VM_THREADED_DISPATCH)
+        default:
+            break;
+#endif
+#undef D
+#undef A
+#undef B
+#undef C
+#undef K
+#undef VM_OPERATION
+#undef VM_NEXT
+    }
+
+    return ERROR_FATAL_FUNCTION_CALL;
+}
+
+
+int free_vmProgram_memory(VmProgram* vmProgram) {
+
+    // Validating function parameters
+    if (vmProgram == NULL) {
+        return ERROR_INVALID_FUNCTION_PARAMETERS;
+    }
+
+    free(vmProgram->instructions);
+    vmProgram->instructions = NULL;
+    vmProgram->instructionCount = 0;
+    vmProgram->registerCount = 0;
+
+    // Subroutine ran successfully
+    return 0;
+}
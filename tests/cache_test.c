@@ -0,0 +1,158 @@
+#define _POSIX_C_SOURCE 200809L  // For pthread_rwlock_t under strict C11
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "errors.h"
+#include "expression.h"
+#include "cache.h"
+
+
+// Regression test of the expression cache under concurrent lookups: THREAD_COUNT threads look up the same formulas
+// (written with and without the spaces the cache removes from its keys) through one cache, too small to hold all of
+// them so entries keep being evicted and compiled again, and every result must be the same bit for bit as that of
+// the graph of the formula compiled on its own.
+
+
+#define FORMULA_COUNT 48
+#define FORMULA_LENGTH 64
+#define CACHE_CAPACITY 16
+#define THREAD_COUNT 8
+#define LOOKUP_COUNT 20000
+
+static const double VARIABLE_VALUES[] = {0.7, 1.3, 2.9};
+
+
+// Structure for the work shared by the threads: the cache, the formulas, the result of each one evaluated on its own,
+// and the number of lookups whose result differed from it.
+typedef struct CacheTest {
+    ExpressionCache expressionCache;
+    char formulas[FORMULA_COUNT][FORMULA_LENGTH];
+    double expected[FORMULA_COUNT];
+    int expectedStatus[FORMULA_COUNT];
+    atomic_int failedCount;
+} CacheTest;
+
+
+// Structure for the arguments of one thread.
+typedef struct CacheTestThread {
+    CacheTest* cacheTest;
+    int index;
+} CacheTestThread;
+
+
+// Returns 1 if `a` and `b` are the same result (both NaN, or equal bit for bit), 0 otherwise.
+static int same_result(double a, double b) {
+    return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+
+// Compiles `sourceString` on its own and evaluates its graph. Returns the status of the evaluation (1 if the string
+// does not compile).
+static int evaluate_reference(char* sourceString, double* result) {
+
+    CompiledExpression compiledExpression;
+    if (compile_expression(sourceString, &compiledExpression) != 0) {
+        return 1;
+    }
+    double* nodeValues = malloc(compiledExpression.graph.nodeCount * sizeof(double));
+    int status = nodeValues == NULL ? 1 : evaluate_expressionGraph(&compiledExpression.graph,
+                                                                   (double*)VARIABLE_VALUES, nodeValues, result);
+    free(nodeValues);
+    free_compiledExpression_memory(&compiledExpression);
+    return status;
+}
+
+
+// Looks up formulas in an order of its own, alternately through evaluate_cachedExpression and by evaluating the graph
+// of an acquired entry, and counts the results that differ from the expected ones.
+static void* run_lookups(void* argument) {
+
+    CacheTestThread* thread = argument;
+    CacheTest* cacheTest = thread->cacheTest;
+    ErrorReport errorReport;
+    capture_errors(&errorReport);
+
+    unsigned int state = 2654435761u * (thread->index + 1);
+    for (int i = 0; i < LOOKUP_COUNT; i++) {
+        state = state * 1103515245u + 12345u;
+        int formula = (state >> 16) % FORMULA_COUNT;
+        double result = 0;
+        int status;
+        if (i % 2 == 0) {
+            status = evaluate_cachedExpression(&cacheTest->expressionCache, cacheTest->formulas[formula],
+                                               (double*)VARIABLE_VALUES, &result);
+        } else {
+            CachedExpression* cachedExpression;
+            status = acquire_cachedExpression(&cacheTest->expressionCache, cacheTest->formulas[formula],
+                                              &cachedExpression);
+            if (status == 0) {
+                ExpressionGraph* graph = &cachedExpression->compiledExpression.graph;
+                double nodeValues[FORMULA_LENGTH];
+                status = graph->nodeCount > FORMULA_LENGTH ? 1 :
+                         evaluate_expressionGraph(graph, (double*)VARIABLE_VALUES, nodeValues, &result);
+                release_cachedExpression(&cacheTest->expressionCache, cachedExpression);
+            }
+        }
+        if (status != cacheTest->expectedStatus[formula] ||
+            (status == 0 && !same_result(result, cacheTest->expected[formula]))) {
+            fprintf(stderr, "cache differs from graph on '%s': %d %.17g, expected %d %.17g\n",
+                    cacheTest->formulas[formula], status, result, cacheTest->expectedStatus[formula],
+                    cacheTest->expected[formula]);
+            atomic_fetch_add(&cacheTest->failedCount, 1);
+        }
+    }
+
+    capture_errors(NULL);
+    return NULL;
+}
+
+
+int main(void) {
+
+    static CacheTest cacheTest;
+    ErrorReport errorReport;
+    capture_errors(&errorReport);
+
+    // Every fourth formula is written with spaces, and shares its cache entry with the one before it. Evaluating a few
+    // of them raises a domain error: they compile and are cached like the others, only their evaluations fail
+    for (int i = 0; i < FORMULA_COUNT; i++) {
+        int k = i - i % 4 / 3;
+        if (i % 4 == 3) {
+            snprintf(cacheTest.formulas[i], FORMULA_LENGTH, "sin(x * %d) / (1 + y) - ln(%d - z) * x", k, k % 5);
+        } else {
+            snprintf(cacheTest.formulas[i], FORMULA_LENGTH, "sin(x*%d)/(1+y)-ln(%d-z)*x", k, k % 5);
+        }
+        cacheTest.expectedStatus[i] = evaluate_reference(cacheTest.formulas[i], &cacheTest.expected[i]);
+    }
+    if (init_expressionCache(&cacheTest.expressionCache, CACHE_CAPACITY) != 0) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    atomic_init(&cacheTest.failedCount, 0);
+
+    pthread_t threads[THREAD_COUNT];
+    CacheTestThread arguments[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        arguments[i] = (CacheTestThread){.cacheTest = &cacheTest, .index = i};
+        if (pthread_create(&threads[i], NULL, run_lookups, &arguments[i]) != 0) {
+            fprintf(stderr, "\nError: could not create thread %d.\n\n", i);
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    CacheStatistics cacheStatistics;
+    get_expressionCache_statistics(&cacheTest.expressionCache, &cacheStatistics);
+    free_expressionCache_memory(&cacheTest.expressionCache);
+
+    int failedCount = atomic_load(&cacheTest.failedCount);
+    printf("cache_test: %d lookups, %llu hits, %llu misses, %llu evictions, %d failed\n", THREAD_COUNT * LOOKUP_COUNT,
+           cacheStatistics.hits, cacheStatistics.misses, cacheStatistics.evictions, failedCount);
+    return failedCount == 0 && cacheStatistics.evictions > 0 ? 0 : 1;
+}
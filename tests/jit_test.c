@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "errors.h"
+#include "lex.h"
+#include "operations.h"
+#include "expression.h"
+
+
+// Regression test of the three back ends of a compiled expression: every expression of the corpus in bench/corpus,
+// and of a few formulas with variables bound to fixed values, is evaluated by the graph interpreter, by the bytecode
+// of the VM module and by the native code of the JIT module (where it is available), and the three results must be
+// the same bit for bit. An evaluation that fails must fail in every back end (the JIT may also give up on an
+// evaluation, which the interpreter then redoes, but only if the interpreter fails too).
+//
+// The corpus is made of constant expressions, which constant folding reduces to a single number. Each number of a
+// corpus expression (and each `pi` and `e`) is therefore replaced by a variable bound to its value, so the back ends
+// compute the whole expression. Every expression checked must have more than one graph node, or the test fails.
+//
+// Usage: jit_test [corpus files...]
+
+
+#ifndef CORPUS_DIRECTORY
+#define CORPUS_DIRECTORY "bench/corpus"  // Set by CMake to the absolute path
+#endif
+
+static const char* DEFAULT_CORPUS[] = {
+    CORPUS_DIRECTORY "/short.txt", CORPUS_DIRECTORY "/nested.txt",
+    CORPUS_DIRECTORY "/polynomial.txt", CORPUS_DIRECTORY "/functions.txt"
+};
+
+// Formulas with variables, evaluated with the variable of slot `s` bound to VARIABLE_VALUES[s]
+static const char* VARIABLE_FORMULAS[] = {
+    "x*sin(x)", "sin(x*k)/(1+sin(k*x))", "sin(x)*cos(x)+cos(x)-sin(x)", "rate*exp(t)+x",
+    "x*x*y+sin(x)/y", "ln(1+x*x)/(1+cos(y))", "x*2.5+y*y*y-z/(x+y)", "exp(0-y*y/2)*sin(x)+e*pi",
+    "asin(x/4)+acos(y/4)+atan(z)", "tan(x)/(x-x)", "ln(x-y-z)", "log(x)*log(y)-sqrt_rate/z"
+};
+static const double VARIABLE_VALUES[] = {0.7, 1.3, 2.9, 0.05};
+
+#define MAX_NAME_LENGTH 8  // A variable name (`v` and up to 7 digits) is at most 8 times as long as what it replaces
+
+
+// Returns 1 if `a` and `b` are the same result (both NaN, or equal bit for bit), 0 otherwise.
+static int same_result(double a, double b) {
+    return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+
+// Lexes `sourceString` into `tokenList` and writes it into `boundString` with each number (and `pi` and `e`) replaced
+// by a variable (`v0`, `v1`, ..., one per distinct value, in order of first appearance), whose value is written into
+// `variableValues[slot]`. `boundString` needs room for MAX_NAME_LENGTH characters per character of `sourceString`,
+// and `variableValues` for one value per character. Returns 0 upon success, 1 if the string cannot be lexed.
+static int bind_numbers(char* sourceString, TokenList* tokenList, char* boundString, double* variableValues) {
+
+    if (lexical_analyzer(sourceString, tokenList) != 0) {
+        return 1;
+    }
+
+    int variableCount = 0;
+    int copied = 0;
+    char* writer = boundString;
+    for (int i = 0; i <= tokenList->position; i++) {
+        Token* token = &tokenList->array[i];
+        double value;
+        switch (token->typeToken) {
+            case TOKEN_NUMBER: value = tokenList->numberValues[token->slot]; break;
+            case TOKEN_KEYWORD_PI: value = CONSTANT_PI; break;
+            case TOKEN_KEYWORD_E: value = CONSTANT_E; break;
+            default: continue;
+        }
+        int variable = 0;
+        while (variable < variableCount && !same_result(variableValues[variable], value)) {
+            variable++;
+        }
+        if (variable == variableCount) {
+            variableValues[variableCount++] = value;
+        }
+        memcpy(writer, sourceString + copied, token->offset - copied);
+        writer += token->offset - copied;
+        writer += sprintf(writer, "v%d", variable);
+        copied = token->offset + token->length;
+    }
+    strcpy(writer, sourceString + copied);
+
+    return 0;
+}
+
+
+// Compiles `sourceString` and evaluates it with every back end and `variableValues[slot]` as the value of each
+// variable, prints a message if the results differ. Returns 0 if they agree, 1 otherwise.
+static int check_expression(char* sourceString, double* variableValues, int* checkedCount) {
+
+    CompiledExpression compiledExpression;
+    if (compile_expression(sourceString, &compiledExpression) != 0) {
+        fprintf(stderr, "'%s' does not compile\n", sourceString);
+        return 1;
+    }
+    (*checkedCount)++;
+    if (compiledExpression.graph.nodeCount < 2) {
+        fprintf(stderr, "'%s' folds to a constant, the back ends are not run\n", sourceString);
+        free_compiledExpression_memory(&compiledExpression);
+        return 1;
+    }
+    int failed = 0;
+    double* nodeValues = malloc(compiledExpression.graph.nodeCount * sizeof(double));
+    if (nodeValues == NULL) {
+        free_compiledExpression_memory(&compiledExpression);
+        return 1;
+    }
+
+    double graphResult = 0, vmResult = 0, jitResult = 0;
+    int graphStatus = evaluate_expressionGraph(&compiledExpression.graph, variableValues, nodeValues, &graphResult);
+    int vmStatus = evaluate_vmProgram(&compiledExpression.vm, variableValues, nodeValues, &vmResult);
+    if (vmStatus != graphStatus || (graphStatus == 0 && !same_result(graphResult, vmResult))) {
+        fprintf(stderr, "vm differs from graph on '%s': %d %.17g, expected %d %.17g\n", sourceString, vmStatus,
+                vmResult, graphStatus, graphResult);
+        failed = 1;
+    }
+
+    if (enable_jit_compiledExpression(&compiledExpression) == 0) {
+        int jitStatus = evaluate_jitExpression(&compiledExpression.jit, variableValues, nodeValues, &jitResult);
+        if ((jitStatus == 0 && (graphStatus != 0 || !same_result(graphResult, jitResult))) ||
+            (jitStatus != 0 && graphStatus == 0)) {
+            fprintf(stderr, "jit differs from graph on '%s': %d %.17g, expected %d %.17g\n", sourceString, jitStatus,
+                    jitResult, graphStatus, graphResult);
+            failed = 1;
+        }
+    }
+
+    free(nodeValues);
+    free_compiledExpression_memory(&compiledExpression);
+    return failed;
+}
+
+
+// Checks every non-empty line of the file `fileName`, with its numbers bound to variables. Returns the number of
+// lines that failed, -1 if the file could not be read.
+static int check_corpus(const char* fileName, int* checkedCount) {
+
+    FILE* file = fopen(fileName, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "\nError: could not open '%s'.\n\n", fileName);
+        return -1;
+    }
+
+    int failedCount = 0;
+    size_t capacity = 1 << 16;
+    char* line = malloc(capacity);
+    char* boundLine = malloc(capacity * MAX_NAME_LENGTH);
+    double* variableValues = malloc(capacity * sizeof(double));
+    TokenList tokenList;
+    if (line == NULL || boundLine == NULL || variableValues == NULL || init_tokenList(&tokenList, 256) != 0) {
+        fclose(file);
+        return -1;
+    }
+    size_t length = 0;
+    int character;
+    do {
+        character = fgetc(file);
+        if (character == '\n' || character == '\r' || character == EOF) {
+            line[length] = '\0';
+            if (length > 0 && bind_numbers(line, &tokenList, boundLine, variableValues) != 0) {
+                fprintf(stderr, "'%s' does not lex\n", line);
+                failedCount++;
+            }
+            else if (length > 0) {
+                failedCount += check_expression(boundLine, variableValues, checkedCount);
+            }
+            length = 0;
+            continue;
+        }
+        if (length + 1 == capacity) {
+            capacity *= 2;
+            line = realloc(line, capacity);
+            boundLine = realloc(boundLine, capacity * MAX_NAME_LENGTH);
+            variableValues = realloc(variableValues, capacity * sizeof(double));
+            if (line == NULL || boundLine == NULL || variableValues == NULL) {
+                fclose(file);
+                return -1;
+            }
+        }
+        line[length++] = (char)character;
+    } while (character != EOF);
+
+    free(line);
+    free(boundLine);
+    free(variableValues);
+    free_tokenList_memory(&tokenList);
+    fclose(file);
+    return failedCount;
+}
+
+
+int main(int argc, char *argv[]) {
+
+    // Errors of the expressions are expected (domain errors), only the status codes are compared
+    ErrorReport errorReport;
+    capture_errors(&errorReport);
+
+    int fileCount = argc > 1 ? argc - 1 : (int)(sizeof(DEFAULT_CORPUS) / sizeof(DEFAULT_CORPUS[0]));
+    int checkedCount = 0, failedCount = 0;
+    for (int i = 0; i < fileCount; i++) {
+        int corpusFailed = check_corpus(argc > 1 ? argv[i + 1] : DEFAULT_CORPUS[i], &checkedCount);
+        if (corpusFailed < 0) {
+            return ERROR_INVALID_PROGRAM_USAGE;
+        }
+        failedCount += corpusFailed;
+    }
+    for (size_t i = 0; i < sizeof(VARIABLE_FORMULAS) / sizeof(VARIABLE_FORMULAS[0]); i++) {
+        failedCount += check_expression((char*)VARIABLE_FORMULAS[i], (double*)VARIABLE_VALUES, &checkedCount);
+    }
+
+    printf("jit_test: %d expressions checked, %d failed\n", checkedCount, failedCount);
+    return failedCount == 0 && checkedCount > 0 ? 0 : 1;
+}
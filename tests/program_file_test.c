@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "errors.h"
+#include "expression.h"
+#include "program_file.h"
+
+
+// Regression test of the program file loader: a few formulas are saved to a program file, which must load and give
+// the same results as the compiled formulas. Then every truncation of the file (every length shorter than it) and
+// every copy of it with one bit flipped must be rejected by load_programFile.
+//
+// Usage: program_file_test [directory for the test files]
+
+
+static const char* FORMULAS[] = {
+    "x*sin(x)", "sin(x*k)/(1+sin(k*x))", "rate*exp(t)+x", "ln(1+x*x)/(1+cos(y))", "2*pi+e/3"
+};
+#define FORMULA_COUNT ((int)(sizeof(FORMULAS) / sizeof(FORMULAS[0])))
+#define MAX_NODES 64
+
+static const double VARIABLE_VALUES[] = {0.7, 1.3, 2.9};
+
+
+// Returns 1 if `a` and `b` are the same result (both NaN, or equal bit for bit), 0 otherwise.
+static int same_result(double a, double b) {
+    return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+
+// Writes the `size` bytes of `data` to the file called `fileName`. Returns 0 upon success, 1 upon errors.
+static int write_file(const char* fileName, const char* data, size_t size) {
+    FILE* file = fopen(fileName, "wb");
+    if (file == NULL) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    size_t written = fwrite(data, 1, size, file);
+    return (fclose(file) != 0 || written != size) ? ERROR_FATAL_FUNCTION_CALL : 0;
+}
+
+
+// Reads the file called `fileName` into `*data` (allocated), and its size into `*size`. Returns 0 upon success, 1 upon
+// errors.
+static int read_file(const char* fileName, char** data, size_t* size) {
+    FILE* file = fopen(fileName, "rb");
+    if (file == NULL) {
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    *data = malloc(length > 0 ? length : 1);
+    int failed = length <= 0 || *data == NULL || fread(*data, 1, length, file) != (size_t)length;
+    fclose(file);
+    *size = (size_t)length;
+    return failed ? ERROR_FATAL_FUNCTION_CALL : 0;
+}
+
+
+// Loads the program file called `fileName` and checks each program gives the result of `compiledExpressions`.
+// Returns 0 if it does, 1 otherwise.
+static int check_programFile(const char* fileName, CompiledExpression* compiledExpressions) {
+
+    ProgramFile programFile;
+    if (load_programFile(fileName, &programFile) != 0) {
+        fprintf(stderr, "the program file '%s' was not loaded\n", fileName);
+        return 1;
+    }
+
+    int failed = programFile.programCount != FORMULA_COUNT;
+    for (int i = 0; !failed && i < FORMULA_COUNT; i++) {
+        ExpressionGraph graph;
+        double nodeValues[MAX_NODES];
+        double expected = 0, result = 0;
+        int index = find_programFile_program(&programFile, FORMULAS[i]);
+        failed = index != i || get_programFile_graph(&programFile, index, &graph) != 0 ||
+                 graph.nodeCount > MAX_NODES || compiledExpressions[i].graph.nodeCount > MAX_NODES ||
+                 evaluate_expressionGraph(&graph, (double*)VARIABLE_VALUES, nodeValues, &result) != 0 ||
+                 evaluate_expressionGraph(&compiledExpressions[i].graph, (double*)VARIABLE_VALUES, nodeValues,
+                                          &expected) != 0 ||
+                 !same_result(result, expected);
+        if (failed) {
+            fprintf(stderr, "program '%s' of '%s' differs from the compiled expression\n", FORMULAS[i], fileName);
+        }
+    }
+
+    free_programFile_memory(&programFile);
+    return failed;
+}
+
+
+int main(int argc, char *argv[]) {
+
+    char fileName[4096], damagedFileName[4096];
+    snprintf(fileName, sizeof(fileName), "%s/program_file_test.bin", argc > 1 ? argv[1] : ".");
+    snprintf(damagedFileName, sizeof(damagedFileName), "%s/program_file_test_damaged.bin", argc > 1 ? argv[1] : ".");
+
+    CompiledExpression compiledExpressions[FORMULA_COUNT];
+    for (int i = 0; i < FORMULA_COUNT; i++) {
+        if (compile_expression((char*)FORMULAS[i], &compiledExpressions[i]) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+    }
+    char* data = NULL;
+    size_t size = 0;
+    if (write_programFile(fileName, compiledExpressions, FORMULA_COUNT) != 0 ||
+        read_file(fileName, &data, &size) != 0) {
+        fprintf(stderr, "\nError: could not write '%s'.\n\n", fileName);
+        return ERROR_FATAL_FUNCTION_CALL;
+    }
+    int failedCount = check_programFile(fileName, compiledExpressions);
+
+    // The loader reports every damaged file, which is expected here
+    ErrorReport errorReport;
+    capture_errors(&errorReport);
+    int damagedCount = 0;
+    for (size_t length = 0; length < size; length++) {
+        ProgramFile programFile;
+        if (write_file(damagedFileName, data, length) != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        if (load_programFile(damagedFileName, &programFile) == 0) {
+            fprintf(stderr, "the program file truncated to %zu of %zu bytes was loaded\n", length, size);
+            free_programFile_memory(&programFile);
+            failedCount++;
+        }
+        damagedCount++;
+    }
+    for (size_t bit = 0; bit < size * 8; bit++) {
+        ProgramFile programFile;
+        data[bit / 8] ^= (char)(1 << bit % 8);
+        int written = write_file(damagedFileName, data, size);
+        data[bit / 8] ^= (char)(1 << bit % 8);
+        if (written != 0) {
+            return ERROR_FATAL_FUNCTION_CALL;
+        }
+        if (load_programFile(damagedFileName, &programFile) == 0) {
+            fprintf(stderr, "the program file with bit %zu of byte %zu flipped was loaded\n", bit % 8, bit / 8);
+            free_programFile_memory(&programFile);
+            failedCount++;
+        }
+        damagedCount++;
+    }
+    capture_errors(NULL);
+
+    // The original file must still load after all that
+    failedCount += check_programFile(fileName, compiledExpressions);
+
+    free(data);
+    remove(damagedFileName);
+    remove(fileName);
+    for (int i = 0; i < FORMULA_COUNT; i++) {
+        free_compiledExpression_memory(&compiledExpressions[i]);
+    }
+
+    printf("program_file_test: %zu bytes, %d damaged files checked, %d failed\n", size, damagedCount, failedCount);
+    return failedCount == 0 ? 0 : 1;
+}
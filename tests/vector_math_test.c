@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+#include "lex.h"
+#include "operations.h"
+#include "vector_math.h"
+
+
+// Regression test of the vector kernels of the BATCH module against the scalar apply_function: each function is
+// applied by vector_apply_function to random arguments spread over the range of its kernel, which must stay within
+// the error of the table in vector_math.h, interleaved with arguments outside that range (NaN, infinities, huge
+// values, values outside the domain), which must give the scalar result exactly. Every argument must raise the same
+// domain error as with apply_function, and applying a function in place (`result` being `x`) must give the same
+// values. vector_apply_sincos is checked the same way against apply_sincos, in place in either result array.
+//
+// Usage: vector_math_test
+
+
+#define VALUE_COUNT 4096  // A multiple of 4
+#define SPECIAL_PERIOD 7  // Every 7th argument is one of SPECIAL_VALUES
+
+// Arguments outside the range of some kernel or on its edges
+static const double SPECIAL_VALUES[] = {
+    NAN, INFINITY, -INFINITY, 0.0, -0.0, 1.0, -1.0, 1.5, -1.5, 1e-12, -1e-12, 1e5, 100000.5, -1e6, 1e300, -1e300,
+    709.5, 710.0, -708.5, -800.0, 4.9e-324, 1e-10, 9.99e-11
+};
+#define SPECIAL_COUNT ((int)(sizeof(SPECIAL_VALUES) / sizeof(SPECIAL_VALUES[0])))
+
+// Maximum error of each function inside the range of its kernel, in units in the last place (see vector_math.h)
+static const struct {
+    TypeFunction typeFunction;
+    const char* name;
+    int maxUlp;
+} FUNCTIONS[] = {
+    {FUNCTION_SIN, "sin", 2}, {FUNCTION_COS, "cos", 2}, {FUNCTION_TAN, "tan", 4},
+    {FUNCTION_ASIN, "asin", 1}, {FUNCTION_ACOS, "acos", 1}, {FUNCTION_ATAN, "atan", 1},
+    {FUNCTION_LN, "ln", 1}, {FUNCTION_LOG, "log", 2}, {FUNCTION_EXP, "exp", 1}
+};
+#define FUNCTION_COUNT ((int)(sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0])))
+
+
+// Returns a pseudo-random number in [0, 1) from the generator state `*state`.
+static double next_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return (double)(*state >> 11) / 9007199254740992.0;
+}
+
+
+// Returns a random argument inside the range of the kernel of `typeFunction`.
+static double random_argument(TypeFunction typeFunction, uint64_t* state) {
+
+    double u = next_random(state);
+    switch (typeFunction) {
+        case FUNCTION_SIN:
+        case FUNCTION_COS:
+        case FUNCTION_TAN:
+            // Half of them within a few periods of 0, where most arguments of real formulas are
+            return next_random(state) < 0.5 ? (u * 2 - 1) * 10 : (u * 2 - 1) * 1e5;
+        case FUNCTION_ASIN:
+        case FUNCTION_ACOS:
+            return u * 2 - 1;
+        case FUNCTION_ATAN:
+            return (next_random(state) < 0.5 ? -1 : 1) * pow(10, u * 40 - 20);
+        case FUNCTION_LN:
+        case FUNCTION_LOG:
+            return pow(10, u * 310 - 10);
+        case FUNCTION_EXP:
+            return u * (709 + 708) - 708;
+        default:
+            return u;
+    }
+}
+
+
+// Returns 1 if `x` is inside the range of the kernel of `typeFunction` (see vector_math.h), 0 if its value is computed
+// by apply_function.
+static int in_kernel_range(TypeFunction typeFunction, double x) {
+
+    switch (typeFunction) {
+        case FUNCTION_SIN:
+        case FUNCTION_COS:
+        case FUNCTION_TAN:
+            return fabs(x) <= 1e5;
+        case FUNCTION_ASIN:
+        case FUNCTION_ACOS:
+            return fabs(x) < 1;
+        case FUNCTION_ATAN:
+            return !isnan(x);
+        case FUNCTION_LN:
+        case FUNCTION_LOG:
+            return x >= 1e-10 && x < INFINITY;
+        case FUNCTION_EXP:
+            return x >= -708 && x <= 709;
+        default:
+            return 0;
+    }
+}
+
+
+// Returns the distance between `a` and `b` in units in the last place (the number of doubles between them).
+static uint64_t ulp_distance(double a, double b) {
+
+    int64_t ia, ib;
+    memcpy(&ia, &a, sizeof(double));
+    memcpy(&ib, &b, sizeof(double));
+    // Orders the negative doubles below the positive ones, so that -0 and 0 are next to each other
+    ia = ia < 0 ? INT64_MIN - ia : ia;
+    ib = ib < 0 ? INT64_MIN - ib : ib;
+    return ia > ib ? (uint64_t)ia - (uint64_t)ib : (uint64_t)ib - (uint64_t)ia;
+}
+
+
+// Returns 1 if `a` and `b` are the same result (both NaN, or equal bit for bit), 0 otherwise.
+static int same_result(double a, double b) {
+    return (isnan(a) && isnan(b)) || memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+
+// Checks `result` against `expected`: within `maxUlp` where `x[i]` is inside the range of the kernel (`outside[i]` is
+// 0), bit for bit elsewhere. Prints the first difference under `name`. Returns the number of differences.
+static int check_values(const char* name, const double* x, const double* result, const double* expected,
+                        const char* outside, int maxUlp) {
+
+    int failedCount = 0;
+    for (int i = 0; i < VALUE_COUNT; i++) {
+        int failed = outside[i] ? !same_result(result[i], expected[i]) :
+                     (isnan(result[i]) != isnan(expected[i]) || ulp_distance(result[i], expected[i]) > (uint64_t)maxUlp);
+        if (failed && failedCount++ == 0) {
+            fprintf(stderr, "%s(%.17g) = %.17g, expected %.17g\n", name, x[i], result[i], expected[i]);
+        }
+    }
+    return failedCount;
+}
+
+
+// Checks vector_apply_function for `FUNCTIONS[f]`, out of place and in place. Returns the number of differences.
+static int check_function(int f, double* x, double* result, double* inPlace, double* expected, char* outside,
+                          long long* rowErrors, long long* expectedErrors, uint64_t* state) {
+
+    TypeFunction typeFunction = FUNCTIONS[f].typeFunction;
+    for (int i = 0; i < VALUE_COUNT; i++) {
+        x[i] = i % SPECIAL_PERIOD == 0 ? SPECIAL_VALUES[i / SPECIAL_PERIOD % SPECIAL_COUNT] :
+               random_argument(typeFunction, state);
+        outside[i] = !in_kernel_range(typeFunction, x[i]);
+        expected[i] = 0;
+        expectedErrors[i] = apply_function(typeFunction, x[i], &expected[i]) != DOMAIN_VALID ? -1 : 0;
+        result[i] = 0;
+        rowErrors[i] = 0;
+    }
+    vector_apply_function(typeFunction, x, result, rowErrors, VALUE_COUNT);
+
+    // Only the values of arguments without a domain error are defined
+    for (int i = 0; i < VALUE_COUNT; i++) {
+        if (expectedErrors[i] != 0) {
+            result[i] = expected[i];
+        }
+    }
+    int failedCount = check_values(FUNCTIONS[f].name, x, result, expected, outside, FUNCTIONS[f].maxUlp);
+    if (memcmp(rowErrors, expectedErrors, VALUE_COUNT * sizeof(long long)) != 0) {
+        fprintf(stderr, "%s: the domain errors differ from apply_function\n", FUNCTIONS[f].name);
+        failedCount++;
+    }
+
+    memcpy(inPlace, x, VALUE_COUNT * sizeof(double));
+    memset(rowErrors, 0, VALUE_COUNT * sizeof(long long));
+    vector_apply_function(typeFunction, inPlace, inPlace, rowErrors, VALUE_COUNT);
+    for (int i = 0; i < VALUE_COUNT; i++) {
+        if (expectedErrors[i] == 0 && !same_result(inPlace[i], result[i])) {
+            fprintf(stderr, "%s(%.17g) in place = %.17g, expected %.17g\n", FUNCTIONS[f].name, x[i], inPlace[i],
+                    result[i]);
+            failedCount++;
+            break;
+        }
+    }
+    if (memcmp(rowErrors, expectedErrors, VALUE_COUNT * sizeof(long long)) != 0) {
+        fprintf(stderr, "%s in place: the domain errors differ from apply_function\n", FUNCTIONS[f].name);
+        failedCount++;
+    }
+
+    return failedCount;
+}
+
+
+// Checks vector_apply_sincos, out of place and in place in either result array. Returns the number of differences.
+static int check_sincos(double* x, double* sinResult, double* cosResult, double* inPlace, double* expectedSin,
+                        double* expectedCos, char* outside, uint64_t* state) {
+
+    for (int i = 0; i < VALUE_COUNT; i++) {
+        x[i] = i % SPECIAL_PERIOD == 0 ? SPECIAL_VALUES[i / SPECIAL_PERIOD % SPECIAL_COUNT] :
+               random_argument(FUNCTION_SIN, state);
+        outside[i] = !in_kernel_range(FUNCTION_SIN, x[i]);
+        apply_sincos(x[i], &expectedSin[i], &expectedCos[i]);
+    }
+    vector_apply_sincos(x, sinResult, cosResult, VALUE_COUNT);
+    int failedCount = check_values("sincos (sin)", x, sinResult, expectedSin, outside, 2) +
+                      check_values("sincos (cos)", x, cosResult, expectedCos, outside, 2);
+
+    // The other result array is `expectedSin` or `expectedCos`, which are overwritten with the same values
+    memcpy(inPlace, x, VALUE_COUNT * sizeof(double));
+    vector_apply_sincos(inPlace, inPlace, expectedCos, VALUE_COUNT);
+    if (memcmp(inPlace, sinResult, VALUE_COUNT * sizeof(double)) != 0 ||
+        memcmp(expectedCos, cosResult, VALUE_COUNT * sizeof(double)) != 0) {
+        fprintf(stderr, "sincos with the sines in place differs\n");
+        failedCount++;
+    }
+    memcpy(inPlace, x, VALUE_COUNT * sizeof(double));
+    vector_apply_sincos(inPlace, expectedSin, inPlace, VALUE_COUNT);
+    if (memcmp(inPlace, cosResult, VALUE_COUNT * sizeof(double)) != 0 ||
+        memcmp(expectedSin, sinResult, VALUE_COUNT * sizeof(double)) != 0) {
+        fprintf(stderr, "sincos with the cosines in place differs\n");
+        failedCount++;
+    }
+
+    return failedCount;
+}
+
+
+int main(void) {
+
+    double* x = aligned_alloc(32, VALUE_COUNT * sizeof(double));
+    double* result = aligned_alloc(32, VALUE_COUNT * sizeof(double));
+    double* otherResult = aligned_alloc(32, VALUE_COUNT * sizeof(double));
+    double* inPlace = aligned_alloc(32, VALUE_COUNT * sizeof(double));
+    double* expected = aligned_alloc(32, VALUE_COUNT * sizeof(double));
+    double* expectedOther = aligned_alloc(32, VALUE_COUNT * sizeof(double));
+    long long* rowErrors = aligned_alloc(32, VALUE_COUNT * sizeof(long long));
+    long long* expectedErrors = aligned_alloc(32, VALUE_COUNT * sizeof(long long));
+    char* outside = malloc(VALUE_COUNT);
+    if (x == NULL || result == NULL || otherResult == NULL || inPlace == NULL || expected == NULL || expectedOther == NULL ||
+        rowErrors == NULL || expectedErrors == NULL || outside == NULL) {
+        return 1;
+    }
+
+    uint64_t state = 88172645463325252ull;
+    int failedCount = 0;
+    for (int f = 0; f < FUNCTION_COUNT; f++) {
+        failedCount += check_function(f, x, result, inPlace, expected, outside, rowErrors, expectedErrors, &state);
+    }
+    failedCount += check_sincos(x, result, otherResult, inPlace, expected, expectedOther, outside, &state);
+
+    free(x);
+    free(result);
+    free(otherResult);
+    free(inPlace);
+    free(expected);
+    free(expectedOther);
+    free(rowErrors);
+    free(expectedErrors);
+    free(outside);
+
+    printf("vector_math_test: %d functions and sincos, %d values each, %d failed\n", FUNCTION_COUNT, VALUE_COUNT,
+           failedCount);
+    return failedCount == 0 ? 0 : 1;
+}